@@ -0,0 +1,258 @@
+/*****************************************************************************
+* File Name: esp_ota_codec.c
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "esp_libc.h"
+
+#include "esp_system.h"
+
+#include "esp_ota_port.h"
+#include "esp_ota_desc.h"
+#include "esp_ota_codec.h"
+
+#ifdef ESP_OTA_DEBUG_ENABLED
+#ifndef debugPrintln
+#define debugPrintln(fmt,args...)	\
+	printf("esp-ota-codec: " fmt "%s", ## args, "\r\n")
+#endif
+#else
+#define debugPrintln(...)
+#endif
+
+enum
+{
+	ESP_OTA_CODEC_TAG = 0,
+	ESP_OTA_CODEC_LITERAL,
+	ESP_OTA_CODEC_INDEX,
+	ESP_OTA_CODEC_COUNT
+};
+
+static inline esp_err_t esp_ota_codec_flush(esp_ota_codec_t *codec)
+{
+	esp_err_t err;
+
+	if(!codec->length)
+	{
+		return ESP_OK;
+	}
+	err = codec->callback(codec->callback_arg, codec->output, codec->length);
+	codec->output_length += codec->length;
+	codec->length = 0;
+	return err;
+}
+
+static inline esp_err_t esp_ota_codec_put(esp_ota_codec_t *codec, uint8_t c)
+{
+	codec->window[codec->head & ((1 << codec->window_bits) - 1)] = c;
+	codec->head++;
+	codec->output[codec->length++] = c;
+	if(codec->length < ESP_OTA_CODEC_OUTPUT_SIZE)
+	{
+		return ESP_OK;
+	}
+	return esp_ota_codec_flush(codec);
+}
+
+/* state after a bit field of the current state is complete */
+static esp_err_t esp_ota_codec_field(esp_ota_codec_t *codec)
+{
+	uint16_t mask = (1 << codec->window_bits) - 1;
+	unsigned int count;
+	esp_err_t err;
+
+	switch(codec->state)
+	{
+	case ESP_OTA_CODEC_TAG:
+		if(codec->bits)
+		{
+			codec->state = ESP_OTA_CODEC_LITERAL;
+			codec->bits_needed = 8;
+		}
+		else
+		{
+			codec->state = ESP_OTA_CODEC_INDEX;
+			codec->bits_needed = codec->window_bits;
+		}
+		break;
+
+	case ESP_OTA_CODEC_LITERAL:
+		err = esp_ota_codec_put(codec, (uint8_t)codec->bits);
+		if(err != ESP_OK)
+		{
+			return err;
+		}
+		codec->state = ESP_OTA_CODEC_TAG;
+		codec->bits_needed = 1;
+		break;
+
+	case ESP_OTA_CODEC_INDEX:
+		codec->index = codec->bits + 1;
+		codec->state = ESP_OTA_CODEC_COUNT;
+		codec->bits_needed = codec->lookahead_bits;
+		break;
+
+	case ESP_OTA_CODEC_COUNT:
+		for(count = codec->bits + 1; count; count--)
+		{
+			err = esp_ota_codec_put(codec, codec->window[(codec->head - codec->index) & mask]);
+			if(err != ESP_OK)
+			{
+				return err;
+			}
+		}
+		codec->state = ESP_OTA_CODEC_TAG;
+		codec->bits_needed = 1;
+		break;
+	}
+	codec->bits = 0;
+	return ESP_OK;
+}
+
+esp_err_t esp_ota_codec_init
+	(
+		esp_ota_codec_t *codec,
+		uint8_t codec_id,
+		uint8_t window_bits,
+		uint8_t lookahead_bits,
+		esp_ota_codec_output_t callback,
+		void *callback_arg
+	)
+{
+	memset(codec, 0, sizeof(esp_ota_codec_t));
+	if(codec_id != ESP_OTA_DESC_CODEC_HEATSHRINK)
+	{
+		debugPrintln("codec %u is not supported", codec_id);
+		return ESP_ERR_NOT_SUPPORTED;
+	}
+	if(	window_bits < 4 || window_bits > ESP_OTA_CODEC_WINDOW_BITS_MAX ||
+		lookahead_bits < 3 || lookahead_bits >= window_bits)
+	{
+		debugPrintln("heatshrink: invalid parameters w=%u l=%u", window_bits, lookahead_bits);
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	codec->window = (uint8_t *)ESP_OTA_MALLOC(1 << window_bits);
+	if(!codec->window)
+	{
+		return ESP_ERR_NO_MEM;
+	}
+	memset(codec->window, 0, 1 << window_bits);
+	codec->codec = codec_id;
+	codec->window_bits = window_bits;
+	codec->lookahead_bits = lookahead_bits;
+	codec->state = ESP_OTA_CODEC_TAG;
+	codec->bits_needed = 1;
+	codec->callback = callback;
+	codec->callback_arg = callback_arg;
+	return ESP_OK;
+}
+
+esp_err_t esp_ota_codec_write(esp_ota_codec_t *codec, const uint8_t *data, unsigned int length)
+{
+	esp_err_t err;
+
+	while(length || codec->bit_index)
+	{
+		if(!codec->bit_index)
+		{
+			codec->current_byte = *data++;
+			codec->bit_index = 0x80;
+			length--;
+		}
+
+		codec->bits <<= 1;
+		if(codec->current_byte & codec->bit_index)
+		{
+			codec->bits |= 1;
+		}
+		codec->bit_index >>= 1;
+
+		if(--codec->bits_needed)
+		{
+			continue;
+		}
+		err = esp_ota_codec_field(codec);
+		if(err != ESP_OK)
+		{
+			return err;
+		}
+	}
+	return ESP_OK;
+}
+
+esp_err_t esp_ota_codec_finish(esp_ota_codec_t *codec)
+{
+	/*
+	 * only zero padding of the last byte may follow the last token, it is
+	 * too short to complete a back-reference but may end in any other state
+	 */
+	if(codec->state == ESP_OTA_CODEC_LITERAL)
+	{
+		debugPrintln("heatshrink: truncated stream, state %u", codec->state);
+		return ESP_ERR_INVALID_SIZE;
+	}
+	return esp_ota_codec_flush(codec);
+}
+
+void esp_ota_codec_deinit(esp_ota_codec_t *codec)
+{
+	if(codec->window)
+	{
+		ESP_OTA_FREE(codec->window);
+		codec->window = NULL;
+	}
+}
+
+/*
+ * EOF
+ */
@@ -0,0 +1,132 @@
+/*****************************************************************************
+* File Name: esp_ota_codec.h
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+
+/*******************************************************************************
+* User defined Macros
+*******************************************************************************/
+
+#ifndef ESP_OTA_CODEC_H
+#define ESP_OTA_CODEC_H
+
+#ifndef ESP_OTA_CODEC_WINDOW_BITS_MAX
+#define ESP_OTA_CODEC_WINDOW_BITS_MAX	(12)
+#endif
+
+#ifndef ESP_OTA_CODEC_OUTPUT_SIZE
+#define ESP_OTA_CODEC_OUTPUT_SIZE	(128)
+#endif
+
+typedef esp_err_t (*esp_ota_codec_output_t)(void *arg, const uint8_t *data, unsigned int length);
+
+/*
+ * Streaming decoder, input can be split anywhere and the output is handed
+ * to the output callback in pieces of up to ESP_OTA_CODEC_OUTPUT_SIZE.
+ *
+ * heatshrink: LZSS with a (1 << window_bits) bytes history window, the
+ * stream is a sequence of MSB first bit fields:
+ *   1, literal[8]
+ *   0, index[window_bits], count[lookahead_bits]
+ *     (copy count+1 bytes from index+1 bytes back)
+ */
+typedef struct
+{
+	uint8_t codec;
+	uint8_t state;
+	uint8_t window_bits;
+	uint8_t lookahead_bits;
+
+	/* bit reader */
+	uint8_t current_byte;
+	uint8_t bit_index;
+	uint8_t bits_needed;
+	uint16_t bits;
+
+	uint16_t index;
+	uint16_t head;
+	uint8_t *window;
+
+	uint32_t output_length;
+	unsigned int length;
+	uint8_t output[ESP_OTA_CODEC_OUTPUT_SIZE];
+	esp_ota_codec_output_t callback;
+	void *callback_arg;
+}esp_ota_codec_t;
+
+/** @brief esp_ota_codec_init
+ *
+ *
+ * @param codec_id  ESP_OTA_DESC_CODEC_xxx
+ * @return  ESP_ERR_NOT_SUPPORTED: codec is not built in
+ */
+esp_err_t esp_ota_codec_init
+	(
+		esp_ota_codec_t *codec,
+		uint8_t codec_id,
+		uint8_t window_bits,
+		uint8_t lookahead_bits,
+		esp_ota_codec_output_t callback,
+		void *callback_arg
+	);
+
+esp_err_t esp_ota_codec_write(esp_ota_codec_t *codec, const uint8_t *data, unsigned int length);
+
+/** @brief esp_ota_codec_finish
+ *
+ * Flush the output, the stream must end at a token boundary.
+ */
+esp_err_t esp_ota_codec_finish(esp_ota_codec_t *codec);
+
+void esp_ota_codec_deinit(esp_ota_codec_t *codec);
+
+#endif
@@ -49,6 +49,8 @@
 *****************************************************************************/
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
@@ -56,12 +58,15 @@
 
 #include "esp_system.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "jsmn/jsmn.h"
 #include "json_parser.h"
 #include "json_jsmn.h"
 #include "jsondoc/jsondoc.h"
 
+#include "esp_ota_port.h"
+#include "esp_ota_hash.h"
 #include "esp_ota_desc.h"
 
 #ifdef ESP_OTA_DEBUG_ENABLED
@@ -77,18 +82,6 @@
 #define ESP_OTA_HTTP_UPGRADE_BUF_SIZE (256)
 #endif
 
-#ifndef ESP_OTA_MALLOC
-#define ESP_OTA_MALLOC	os_malloc
-#endif
-
-#ifndef ESP_OTA_FREE
-#define ESP_OTA_FREE	os_free
-#endif
-
-#ifndef ESP_OTA_REALLOC
-#define ESP_OTA_REALLOC	os_realloc
-#endif
-
 /* Function realloc_safe() is a wrapper function for standart realloc()
  * with one difference - it frees old memory pointer in case of realloc
  * failure. Thus, DO NOT use old data pointer in anyway after call to
@@ -108,46 +101,70 @@ static inline void *realloc_safe(void *ptrmem, size_t size)
 	return p;
 }
 
+/*
+ * Tokens of a descriptor without "blocks" fit the pool on the stack of
+ * esp_ota_desc_parse_json(), 0: always counted and allocated.
+ */
+#ifndef ESP_OTA_DESC_TOKEN_POOL
+#define ESP_OTA_DESC_TOKEN_POOL	(32)
+#endif
+
+/* Parse into pool, if it is too small a counting pass of jsmn sizes one
+ * allocation for the second and last parse. *out_tokens is pool or has
+ * to be freed.
+ */
 static int json_alloc_and_parse
 (
 	const char *js, unsigned int jslen,
 	const char **keys_filter_list,
 	json_jsmntok_t *json_jsmntok, int json_jsmntok_count,
+	jsmntok_t *pool, int pool_count,
 	jsmntok_t **out_tokens
 )
 {
-#define ESP_OTA_HTTP_TOKEN_COUNT	(5)
+	jsmn_parser parser;
 	jsmntok_t *tokens;
 	int rc, tokcount;
 
-	tokcount = ESP_OTA_HTTP_TOKEN_COUNT;
-	tokens = ESP_OTA_MALLOC(sizeof(jsmntok_t) * tokcount);
-	assert(tokens);
-
-	while(1)
+	rc = JSMN_ERROR_NOMEM;
+	tokens = pool;
+	if(pool_count > 0)
 	{
 		rc = json_parse
 				(	js, jslen,
-					tokens, tokcount,
+					tokens, pool_count,
 					keys_filter_list,
 					json_jsmntok, json_jsmntok_count
 				);
-
-		if(rc > 0)
+	}
+	if(rc == JSMN_ERROR_NOMEM)
+	{
+		jsmn_init(&parser);
+		tokcount = jsmn_parse(&parser, js, jslen, NULL, 0);
+		if(tokcount <= 0)
 		{
-			break;
+			return -1;
 		}
-		else if (rc == JSMN_ERROR_NOMEM)
+		tokens = ESP_OTA_MALLOC(sizeof(jsmntok_t) * tokcount);
+		if(!tokens)
 		{
-
-			tokcount = (tokcount * 4)/3;
-			tokens = realloc_safe(tokens, sizeof(jsmntok_t) * tokcount);
-			assert(tokens);
+			debugPrintln("jsmn_parse: out of memory at %d tokens", tokcount);
+			return -1;
 		}
-		else
+		rc = json_parse
+				(	js, jslen,
+					tokens, tokcount,
+					keys_filter_list,
+					json_jsmntok, json_jsmntok_count
+				);
+	}
+	if(rc <= 0)
+	{
+		if(tokens != pool)
 		{
-			return -1;
+			ESP_OTA_FREE(tokens);
 		}
+		return -1;
 	}
 	*out_tokens = tokens;
 	return rc;
@@ -188,18 +205,245 @@ static inline int hex_to_bytes(const char *string, uint8_t *bytes, int size)
 	return i;
 }
 
+static void esp_ota_desc_reset(esp_ota_desc_t *info)
+{
+	memset(info, 0, sizeof(esp_ota_desc_t));
+	info->version.u16 = 0xffff;
+	info->window_bits = 8;
+	info->lookahead_bits = 4;
+	info->block_size = ESP_OTA_DESC_BLOCK_SIZE;
+}
+
+void esp_ota_desc_free(esp_ota_desc_t *info)
+{
+	if(info->blocks)
+	{
+		ESP_OTA_FREE(info->blocks);
+		info->blocks = NULL;
+	}
+	info->block_count = 0;
+	info->block_capacity = 0;
+}
+
+/* one element of "blocks", a bad hash is kept as zero and always fetched */
+static void esp_ota_desc_block(esp_ota_desc_t *info, const char *value, unsigned int value_length)
+{
+	uint8_t *hash;
+
+	if(info->block_count >= ESP_OTA_DESC_BLOCKS_MAX)
+	{
+		/* too many, dropped by the final validation */
+		esp_ota_desc_free(info);
+		info->block_count = ESP_OTA_DESC_BLOCKS_MAX + 1;
+		return;
+	}
+	if(info->block_count == info->block_capacity)
+	{
+		info->block_capacity = info->block_capacity ? (info->block_capacity * 2) : 64;
+		if(info->block_capacity > ESP_OTA_DESC_BLOCKS_MAX)
+		{
+			info->block_capacity = ESP_OTA_DESC_BLOCKS_MAX;
+		}
+		info->blocks = (uint8_t *)realloc_safe
+			(
+				info->blocks,
+				info->block_capacity * ESP_OTA_DESC_BLOCK_HASH_SIZE
+			);
+		if(!info->blocks)
+		{
+			debugPrintln("blocks: out of memory at %u", info->block_count);
+			info->block_count = ESP_OTA_DESC_BLOCKS_MAX + 1;
+			info->block_capacity = 0;
+			return;
+		}
+	}
+
+	hash = &info->blocks[info->block_count * ESP_OTA_DESC_BLOCK_HASH_SIZE];
+	if(	value_length != (ESP_OTA_DESC_BLOCK_HASH_SIZE*2) ||
+		hex_to_bytes(value, hash, ESP_OTA_DESC_BLOCK_HASH_SIZE) != ESP_OTA_DESC_BLOCK_HASH_SIZE)
+	{
+		memset(hash, 0, ESP_OTA_DESC_BLOCK_HASH_SIZE);
+	}
+	info->block_count++;
+}
+
+static inline bool esp_ota_desc_key(const char *key, unsigned int key_length, const char *name)
+{
+	return (strlen(name) == key_length && 0 == memcmp(key, name, key_length));
+}
+
+static void esp_ota_desc_hash(uint8_t *hash, const char *value, unsigned int value_length)
+{
+	if(value_length != (32*2) || hex_to_bytes(value, hash, 32) != 32)
+	{
+		memset(hash, 0, 32);
+	}
+}
+
+/* one member of the descriptor object, value is not NUL terminated */
+static void esp_ota_desc_set
+	(
+		esp_ota_desc_t *info,
+		const char *key, unsigned int key_length,
+		const char *value, unsigned int value_length,
+		bool string
+	)
+{
+	if(!string)
+	{
+		if(esp_ota_desc_key(key, key_length, "version"))
+		{
+			info->version.u16 = strtol(value, NULL, 10);
+		}
+		else if(esp_ota_desc_key(key, key_length, "size"))
+		{
+			info->size = strtoul(value, NULL, 10);
+		}
+		else if(esp_ota_desc_key(key, key_length, "zsize"))
+		{
+			info->zsize = strtoul(value, NULL, 10);
+		}
+		else if(esp_ota_desc_key(key, key_length, "window"))
+		{
+			info->window_bits = strtoul(value, NULL, 10);
+		}
+		else if(esp_ota_desc_key(key, key_length, "lookahead"))
+		{
+			info->lookahead_bits = strtoul(value, NULL, 10);
+		}
+		else if(esp_ota_desc_key(key, key_length, "base_version"))
+		{
+			info->base_version = strtol(value, NULL, 10);
+		}
+		else if(esp_ota_desc_key(key, key_length, "base_size"))
+		{
+			info->base_size = strtoul(value, NULL, 10);
+		}
+		else if(esp_ota_desc_key(key, key_length, "block_size"))
+		{
+			info->block_size = strtoul(value, NULL, 10);
+		}
+		else if(esp_ota_desc_key(key, key_length, "retry_after"))
+		{
+			info->retry_after = strtoul(value, NULL, 10);
+		}
+	}
+	else if(esp_ota_desc_key(key, key_length, "sha256"))
+	{
+		esp_ota_desc_hash(info->sha256, value, value_length);
+	}
+	else if(esp_ota_desc_key(key, key_length, "zsha256"))
+	{
+		esp_ota_desc_hash(info->zsha256, value, value_length);
+	}
+	else if(esp_ota_desc_key(key, key_length, "base_sha256"))
+	{
+		esp_ota_desc_hash(info->base_sha256, value, value_length);
+	}
+	else if(esp_ota_desc_key(key, key_length, "merkle_root"))
+	{
+		esp_ota_desc_hash(info->merkle_root, value, value_length);
+	}
+	else if(esp_ota_desc_key(key, key_length, "codec"))
+	{
+		if(esp_ota_desc_key(value, value_length, "none"))
+		{
+			info->codec = ESP_OTA_DESC_CODEC_NONE;
+		}
+		else if(esp_ota_desc_key(value, value_length, "heatshrink"))
+		{
+			info->codec = ESP_OTA_DESC_CODEC_HEATSHRINK;
+		}
+		else if(esp_ota_desc_key(value, value_length, "lz4"))
+		{
+			info->codec = ESP_OTA_DESC_CODEC_LZ4;
+		}
+		else if(esp_ota_desc_key(value, value_length, "deflate"))
+		{
+			info->codec = ESP_OTA_DESC_CODEC_DEFLATE;
+		}
+		else
+		{
+			info->codec = ESP_OTA_DESC_CODEC_UNKNOWN;
+		}
+	}
+}
+
+static bool esp_ota_desc_merkle(const esp_ota_desc_t *info)
+{
+	static const uint8_t zero[32];
+	uint8_t hash[32];
+
+	if(!memcmp(info->merkle_root, zero, 32))
+	{
+		return true;
+	}
+	if(!info->blocks)
+	{
+		return false;
+	}
+	esp_ota_hash_sha256(NULL, info->blocks, info->block_count * ESP_OTA_DESC_BLOCK_HASH_SIZE, hash);
+	return (0 == memcmp(hash, info->merkle_root, 32));
+}
+
+static int esp_ota_desc_validate(esp_ota_desc_t *info)
+{
+	int i;
+
+	// the block list must cover the image, otherwise it is not used
+	if(	info->block_count &&
+		(!info->blocks || !info->size || !info->block_size ||
+		info->block_count != (info->size + info->block_size - 1) / info->block_size))
+	{
+		debugPrintln("blocks: %u blocks don't cover the image, ignored", info->block_count);
+		esp_ota_desc_free(info);
+	}
+	// a block list under a root must be complete and unmodified
+	if(!esp_ota_desc_merkle(info))
+	{
+		debugPrintln("blocks: merkle root is not match");
+		esp_ota_desc_free(info);
+		return -1;
+	}
+
+	// final validate
+	if(info->version.u16 == 0xffff)
+	{
+		esp_ota_desc_free(info);
+		return -1;
+	}
+	for(i = 0; i < 32; i++)
+	{
+		if(info->sha256[i])
+		{
+			return 0;
+		}
+	}
+	esp_ota_desc_free(info);
+	return -1;
+}
+
 int esp_ota_desc_parse_json(const char *js, unsigned int jslen, esp_ota_desc_t *info)
 {
-	static const char *filter_list[] = {"version", "sha256", NULL};
+	static const char *filter_list[] =
+		{
+			"version", "sha256", "size",
+			"codec", "zsize", "zsha256", "window", "lookahead",
+			"base_version", "base_size", "base_sha256",
+			"block_size", "blocks", "merkle_root", "retry_after",
+			NULL
+		};
 	int i, tokcount;
+	jsmntok_t pool[ESP_OTA_DESC_TOKEN_POOL + 1];	/* + 1: never zero length */
 	jsmntok_t *tokens;
-	json_jsmntok_t json_jsmntok[2];
+	json_jsmntok_t json_jsmntok[(sizeof(filter_list) / sizeof(filter_list[0])) - 1];
 
 	tokcount = json_alloc_and_parse
 				(
 					js, jslen,
 					filter_list,
-					json_jsmntok, 6,
+					json_jsmntok, sizeof(json_jsmntok) / sizeof(json_jsmntok[0]),
+					pool, ESP_OTA_DESC_TOKEN_POOL,
 					&tokens
 				);
 	if(tokcount < 0)
@@ -208,8 +452,7 @@ int esp_ota_desc_parse_json(const char *js, unsigned int jslen, esp_ota_desc_t *
 		return -1;
 	}
 	debugPrintln("jsmn_parse: count: %d", tokcount);
-	info->version.u16 = 0xffff;
-	memset(info->sha256, 0, 32);
+	esp_ota_desc_reset(info);
 	for(i = 0; i < tokcount; i++)
 	{
 		debugPrintln
@@ -224,47 +467,976 @@ int esp_ota_desc_parse_json(const char *js, unsigned int jslen, esp_ota_desc_t *
 				json_jsmntok[i].t_value->type
 			);
 
-		if(
-			0 == jsmntok_strcmp(js, json_jsmntok[i].t_key, "version") &&
-			json_jsmntok[i].t_value_type == JSMN_PRIMITIVE)
+		if(	json_jsmntok[i].t_value_type == JSMN_ARRAY &&
+			0 == jsmntok_strcmp(js, json_jsmntok[i].t_key, "blocks"))
 		{
-			info->version.u16 = strtol(js+jsmntok_get_offset(json_jsmntok[i].t_value), NULL, 10);
+			jsmntok_t *t;
+			int n;
+
+			// elements follow the array token
+			for(n = 0, t = json_jsmntok[i].t_value + 1; n < json_jsmntok[i].t_value->size; n++, t++)
+			{
+				if(t->type != JSMN_STRING)
+				{
+					break;
+				}
+				esp_ota_desc_block(info, js+jsmntok_get_offset(t), jsmntok_get_size(t));
+			}
+			continue;
 		}
-		else if(
-			0 == jsmntok_strcmp(js, json_jsmntok[i].t_key, "sha256") &&
-			json_jsmntok[i].t_value_type == JSMN_STRING)
+		if(json_jsmntok[i].t_value_type != JSMN_PRIMITIVE &&
+			json_jsmntok[i].t_value_type != JSMN_STRING)
 		{
-			int n;
+			continue;
+		}
+		esp_ota_desc_set
+			(
+				info,
+				js+jsmntok_get_offset(json_jsmntok[i].t_key),
+				jsmntok_get_size(json_jsmntok[i].t_key),
+				js+jsmntok_get_offset(json_jsmntok[i].t_value),
+				jsmntok_get_size(json_jsmntok[i].t_value),
+				json_jsmntok[i].t_value_type == JSMN_STRING
+			);
+	}
+	if(tokens != pool)
+	{
+		ESP_OTA_FREE(tokens);
+	}
+	return esp_ota_desc_validate(info);
+}
+
+enum
+{
+	ESP_OTA_DESC_PARSER_VALUE = 0,
+	ESP_OTA_DESC_PARSER_KEY,
+	ESP_OTA_DESC_PARSER_COLON,
+	ESP_OTA_DESC_PARSER_NEXT,
+	ESP_OTA_DESC_PARSER_IN_KEY,
+	ESP_OTA_DESC_PARSER_IN_STRING,
+	ESP_OTA_DESC_PARSER_IN_PRIMITIVE,
+	ESP_OTA_DESC_PARSER_DONE,
+	ESP_OTA_DESC_PARSER_ERROR
+};
+
+static void esp_ota_desc_parser_value(esp_ota_desc_parser_t *parser, bool string)
+{
+	if(	parser->depth == 2 && string &&
+		!(parser->objects & (1 << 1)) &&
+		esp_ota_desc_key(parser->key, parser->key_length, "blocks"))
+	{
+		esp_ota_desc_block(parser->desc, parser->value, parser->value_length);
+		return;
+	}
+	if(parser->depth != 1)
+	{
+		return;
+	}
+
+	debugPrintln("parser: Name: %s, Value: %s", parser->key, parser->value);
+	esp_ota_desc_set
+		(
+			parser->desc,
+			parser->key, parser->key_length,
+			parser->value, parser->value_length,
+			string
+		);
+}
+
+static void esp_ota_desc_parser_push(esp_ota_desc_parser_t *parser, bool object)
+{
+	if(parser->depth >= ESP_OTA_DESC_PARSER_DEPTH)
+	{
+		parser->state = ESP_OTA_DESC_PARSER_ERROR;
+		return;
+	}
+	if(object)
+	{
+		parser->objects |= (1 << parser->depth);
+		parser->state = ESP_OTA_DESC_PARSER_KEY;
+	}
+	else
+	{
+		parser->objects &= ~(1 << parser->depth);
+		parser->state = ESP_OTA_DESC_PARSER_VALUE;
+	}
+	parser->depth++;
+}
+
+static void esp_ota_desc_parser_pop(esp_ota_desc_parser_t *parser, bool object)
+{
+	bool top;
+
+	if(!parser->depth)
+	{
+		parser->state = ESP_OTA_DESC_PARSER_ERROR;
+		return;
+	}
+	top = (parser->objects & (1 << (parser->depth - 1))) ? true : false;
+	if(top != object)
+	{
+		parser->state = ESP_OTA_DESC_PARSER_ERROR;
+		return;
+	}
+	parser->depth--;
+	parser->state = parser->depth ? ESP_OTA_DESC_PARSER_NEXT : ESP_OTA_DESC_PARSER_DONE;
+}
+
+static inline void esp_ota_desc_parser_append(esp_ota_desc_parser_t *parser, char c)
+{
+	if((parser->value_length + 1) < ESP_OTA_DESC_VALUE_LENGTH)
+	{
+		parser->value[parser->value_length++] = c;
+	}
+	else
+	{
+		/* too long, can't be a valid value of a known key */
+		parser->value_length = ESP_OTA_DESC_VALUE_LENGTH;
+	}
+}
+
+static inline uint32_t esp_ota_desc_get_u16(const uint8_t *p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8);
+}
+
+static inline uint32_t esp_ota_desc_get_u32(const uint8_t *p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* CRC-32 (IEEE 802.3, reflected), the one of zlib.crc32(), a nibble at a time */
+static uint32_t esp_ota_desc_crc32(uint32_t crc, const uint8_t *data, unsigned int length)
+{
+	static const uint32_t table[16] =
+		{
+			0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+			0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+			0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+			0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c
+		};
+
+	while(length--)
+	{
+		crc ^= *data++;
+		crc = (crc >> 4) ^ table[crc & 0x0f];
+		crc = (crc >> 4) ^ table[crc & 0x0f];
+	}
+	return crc;
+}
+
+static bool esp_ota_desc_bin_header(esp_ota_desc_t *info, const uint8_t *header, uint16_t *length)
+{
+	if(	memcmp(header, ESP_OTA_DESC_BIN_MAGIC, 4) ||
+		header[4] != ESP_OTA_DESC_BIN_VERSION)
+	{
+		debugPrintln("bin: not a descriptor of version %u", ESP_OTA_DESC_BIN_VERSION);
+		return false;
+	}
+	*length = esp_ota_desc_get_u16(&header[6]);
+	if(*length < (ESP_OTA_DESC_BIN_HEADER_SIZE + ESP_OTA_DESC_BIN_CRC_SIZE))
+	{
+		return false;
+	}
+	info->version.u16 = esp_ota_desc_get_u16(&header[8]);
+	info->size = esp_ota_desc_get_u32(&header[12]);
+	memcpy(info->sha256, &header[16], 32);
+	return true;
+}
+
+/* length of a known field, 0: any (blocks, fields of a later version) */
+static unsigned int esp_ota_desc_bin_field_length(uint8_t type)
+{
+	switch(type)
+	{
+	case ESP_OTA_DESC_BIN_CODEC:
+	case ESP_OTA_DESC_BIN_WINDOW:
+	case ESP_OTA_DESC_BIN_LOOKAHEAD:
+		return 1;
+	case ESP_OTA_DESC_BIN_BASE_VERSION:
+		return 2;
+	case ESP_OTA_DESC_BIN_ZSIZE:
+	case ESP_OTA_DESC_BIN_BASE_SIZE:
+	case ESP_OTA_DESC_BIN_BLOCK_SIZE:
+	case ESP_OTA_DESC_BIN_RETRY_AFTER:
+		return 4;
+	case ESP_OTA_DESC_BIN_ZSHA256:
+	case ESP_OTA_DESC_BIN_BASE_SHA256:
+	case ESP_OTA_DESC_BIN_MERKLE_ROOT:
+		return 32;
+	default:
+		return 0;
+	}
+}
+
+/* room for a "blocks" field of length bytes, filled by the caller */
+static bool esp_ota_desc_bin_blocks(esp_ota_desc_t *info, unsigned int length)
+{
+	if(	info->blocks ||
+		(length % ESP_OTA_DESC_BLOCK_HASH_SIZE) ||
+		(length / ESP_OTA_DESC_BLOCK_HASH_SIZE) > ESP_OTA_DESC_BLOCKS_MAX)
+	{
+		return false;
+	}
+	if(!length)
+	{
+		return true;
+	}
+	info->blocks = (uint8_t *)ESP_OTA_MALLOC(length);
+	if(!info->blocks)
+	{
+		debugPrintln("blocks: out of memory");
+		return false;
+	}
+	info->block_count = length / ESP_OTA_DESC_BLOCK_HASH_SIZE;
+	info->block_capacity = info->block_count;
+	return true;
+}
+
+/* a field of esp_ota_desc_bin_field_length() bytes */
+static void esp_ota_desc_bin_field(esp_ota_desc_t *info, uint8_t type, const uint8_t *value)
+{
+	switch(type)
+	{
+	case ESP_OTA_DESC_BIN_CODEC:
+		info->codec = (value[0] <= ESP_OTA_DESC_CODEC_DEFLATE) ? value[0] : ESP_OTA_DESC_CODEC_UNKNOWN;
+		break;
+	case ESP_OTA_DESC_BIN_WINDOW:
+		info->window_bits = value[0];
+		break;
+	case ESP_OTA_DESC_BIN_LOOKAHEAD:
+		info->lookahead_bits = value[0];
+		break;
+	case ESP_OTA_DESC_BIN_BASE_VERSION:
+		info->base_version = esp_ota_desc_get_u16(value);
+		break;
+	case ESP_OTA_DESC_BIN_ZSIZE:
+		info->zsize = esp_ota_desc_get_u32(value);
+		break;
+	case ESP_OTA_DESC_BIN_BASE_SIZE:
+		info->base_size = esp_ota_desc_get_u32(value);
+		break;
+	case ESP_OTA_DESC_BIN_BLOCK_SIZE:
+		info->block_size = esp_ota_desc_get_u32(value);
+		break;
+	case ESP_OTA_DESC_BIN_RETRY_AFTER:
+		info->retry_after = esp_ota_desc_get_u32(value);
+		break;
+	case ESP_OTA_DESC_BIN_ZSHA256:
+		memcpy(info->zsha256, value, 32);
+		break;
+	case ESP_OTA_DESC_BIN_BASE_SHA256:
+		memcpy(info->base_sha256, value, 32);
+		break;
+	case ESP_OTA_DESC_BIN_MERKLE_ROOT:
+		memcpy(info->merkle_root, value, 32);
+		break;
+	default:
+		break;
+	}
+}
+
+/* the field header is read */
+static bool esp_ota_desc_bin_field_begin(esp_ota_desc_parser_t *parser)
+{
+	uint8_t type = (uint8_t)parser->key[0];
+	unsigned int length;
+
+	length = esp_ota_desc_bin_field_length(type);
+	if(length)
+	{
+		return (parser->field_length == length);
+	}
+	if(type == ESP_OTA_DESC_BIN_BLOCKS)
+	{
+		return esp_ota_desc_bin_blocks(parser->desc, parser->field_length);
+	}
+	return true;
+}
+
+static int esp_ota_desc_parser_feed_bin(esp_ota_desc_parser_t *parser, const uint8_t *data, unsigned int length)
+{
+	unsigned int i;
+	uint8_t c;
+
+	for(i = 0; i < length && parser->state != ESP_OTA_DESC_PARSER_ERROR; i++)
+	{
+		c = data[i];
+		if(parser->state == ESP_OTA_DESC_PARSER_DONE)
+		{
+			/* trailing data after the crc */
+			parser->state = ESP_OTA_DESC_PARSER_ERROR;
+			break;
+		}
+
+		if(parser->offset < ESP_OTA_DESC_BIN_HEADER_SIZE)
+		{
+			parser->crc = esp_ota_desc_crc32(parser->crc, &c, 1);
+			parser->value[parser->offset++] = c;
+			if(	parser->offset == ESP_OTA_DESC_BIN_HEADER_SIZE &&
+				!esp_ota_desc_bin_header(parser->desc, (const uint8_t *)parser->value, &parser->length))
+			{
+				parser->state = ESP_OTA_DESC_PARSER_ERROR;
+			}
+			continue;
+		}
+
+		if(parser->offset >= (uint32_t)(parser->length - ESP_OTA_DESC_BIN_CRC_SIZE))
+		{
+			if(parser->key_length)
+			{
+				/* a field runs into the crc */
+				parser->state = ESP_OTA_DESC_PARSER_ERROR;
+				break;
+			}
+			parser->key[parser->offset - (parser->length - ESP_OTA_DESC_BIN_CRC_SIZE)] = c;
+			parser->offset++;
+			if(parser->offset == parser->length)
+			{
+				parser->state = (~parser->crc == esp_ota_desc_get_u32((const uint8_t *)parser->key)) ?
+					ESP_OTA_DESC_PARSER_DONE : ESP_OTA_DESC_PARSER_ERROR;
+			}
+			continue;
+		}
+
+		parser->crc = esp_ota_desc_crc32(parser->crc, &c, 1);
+		parser->offset++;
+		if(parser->key_length < ESP_OTA_DESC_BIN_FIELD_SIZE)
+		{
+			parser->key[parser->key_length++] = c;
+			if(parser->key_length < ESP_OTA_DESC_BIN_FIELD_SIZE)
+			{
+				continue;
+			}
+			parser->field_length = esp_ota_desc_get_u16((const uint8_t *)&parser->key[1]);
+			parser->field_offset = 0;
+			if(!esp_ota_desc_bin_field_begin(parser))
+			{
+				parser->state = ESP_OTA_DESC_PARSER_ERROR;
+				break;
+			}
+		}
+		else if((uint8_t)parser->key[0] == ESP_OTA_DESC_BIN_BLOCKS)
+		{
+			parser->desc->blocks[parser->field_offset++] = c;
+		}
+		else
+		{
+			if(parser->field_offset < ESP_OTA_DESC_VALUE_LENGTH)
+			{
+				parser->value[parser->field_offset] = c;
+			}
+			parser->field_offset++;
+		}
+		if(parser->field_offset == parser->field_length)
+		{
+			if(parser->field_length == esp_ota_desc_bin_field_length((uint8_t)parser->key[0]))
+			{
+				esp_ota_desc_bin_field(parser->desc, (uint8_t)parser->key[0], (const uint8_t *)parser->value);
+			}
+			parser->key_length = 0;
+		}
+	}
+	return (parser->state == ESP_OTA_DESC_PARSER_ERROR) ? -1 : 0;
+}
+
+void esp_ota_desc_parser_init(esp_ota_desc_parser_t *parser, esp_ota_desc_t *desc)
+{
+	memset(parser, 0, sizeof(esp_ota_desc_parser_t));
+	parser->desc = desc;
+	parser->state = ESP_OTA_DESC_PARSER_VALUE;
+	esp_ota_desc_reset(desc);
+}
+
+void esp_ota_desc_parser_init_format
+	(
+		esp_ota_desc_parser_t *parser,
+		esp_ota_desc_t *desc,
+		esp_ota_desc_format_t format
+	)
+{
+	esp_ota_desc_parser_init(parser, desc);
+	parser->format = format;
+	parser->crc = 0xffffffff;
+}
+
+int esp_ota_desc_parser_feed(esp_ota_desc_parser_t *parser, const char *data, unsigned int length)
+{
+	unsigned int i;
+	char c;
+
+	if(parser->format == ESP_OTA_DESC_FORMAT_BIN)
+	{
+		return esp_ota_desc_parser_feed_bin(parser, (const uint8_t *)data, length);
+	}
+	for(i = 0; i < length && parser->state != ESP_OTA_DESC_PARSER_ERROR; i++)
+	{
+		c = data[i];
+		switch(parser->state)
+		{
+		case ESP_OTA_DESC_PARSER_IN_KEY:
+		case ESP_OTA_DESC_PARSER_IN_STRING:
+			if(parser->escape)
+			{
+				parser->escape = false;
+			}
+			else if(c == '\\')
+			{
+				parser->escape = true;
+				continue;
+			}
+			else if(c == '"')
+			{
+				if(parser->state == ESP_OTA_DESC_PARSER_IN_KEY)
+				{
+					parser->key[parser->key_length] = '\0';
+					parser->state = ESP_OTA_DESC_PARSER_COLON;
+				}
+				else
+				{
+					if(parser->value_length < ESP_OTA_DESC_VALUE_LENGTH)
+					{
+						parser->value[parser->value_length] = '\0';
+						esp_ota_desc_parser_value(parser, true);
+					}
+					parser->state = ESP_OTA_DESC_PARSER_NEXT;
+				}
+				continue;
+			}
+
+			if(parser->state == ESP_OTA_DESC_PARSER_IN_KEY)
+			{
+				if((parser->key_length + 1) < ESP_OTA_DESC_KEY_LENGTH)
+				{
+					parser->key[parser->key_length++] = c;
+				}
+				else
+				{
+					/* unknown long key, never matches */
+					parser->key[0] = '\0';
+					parser->key_length = ESP_OTA_DESC_KEY_LENGTH - 1;
+				}
+			}
+			else
+			{
+				esp_ota_desc_parser_append(parser, c);
+			}
+			continue;
+
+		case ESP_OTA_DESC_PARSER_IN_PRIMITIVE:
+			if(c != ',' && c != '}' && c != ']' &&
+				c != ' ' && c != '\t' && c != '\r' && c != '\n')
+			{
+				esp_ota_desc_parser_append(parser, c);
+				continue;
+			}
+			if(parser->value_length < ESP_OTA_DESC_VALUE_LENGTH)
+			{
+				parser->value[parser->value_length] = '\0';
+				esp_ota_desc_parser_value(parser, false);
+			}
+			parser->state = ESP_OTA_DESC_PARSER_NEXT;
+			/* the terminator is handled below */
+			break;
+
+		default:
+			break;
+		}
+
+		if(c == ' ' || c == '\t' || c == '\r' || c == '\n')
+		{
+			continue;
+		}
+
+		switch(parser->state)
+		{
+		case ESP_OTA_DESC_PARSER_VALUE:
+			if(c == '{')
+			{
+				esp_ota_desc_parser_push(parser, true);
+			}
+			else if(c == '[')
+			{
+				esp_ota_desc_parser_push(parser, false);
+			}
+			else if(c == ']')
+			{
+				esp_ota_desc_parser_pop(parser, false);
+			}
+			else if(!parser->depth)
+			{
+				parser->state = ESP_OTA_DESC_PARSER_ERROR;
+			}
+			else
+			{
+				parser->value_length = 0;
+				if(c == '"')
+				{
+					parser->state = ESP_OTA_DESC_PARSER_IN_STRING;
+				}
+				else
+				{
+					parser->value[parser->value_length++] = c;
+					parser->state = ESP_OTA_DESC_PARSER_IN_PRIMITIVE;
+				}
+			}
+			break;
+
+		case ESP_OTA_DESC_PARSER_KEY:
+			if(c == '"')
+			{
+				parser->key_length = 0;
+				parser->state = ESP_OTA_DESC_PARSER_IN_KEY;
+			}
+			else if(c == '}')
+			{
+				esp_ota_desc_parser_pop(parser, true);
+			}
+			else
+			{
+				parser->state = ESP_OTA_DESC_PARSER_ERROR;
+			}
+			break;
+
+		case ESP_OTA_DESC_PARSER_COLON:
+			parser->state = (c == ':') ? ESP_OTA_DESC_PARSER_VALUE : ESP_OTA_DESC_PARSER_ERROR;
+			break;
 
-			n = hex_to_bytes
+		case ESP_OTA_DESC_PARSER_NEXT:
+			if(c == ',')
+			{
+				parser->state = (parser->objects & (1 << (parser->depth - 1))) ?
+									ESP_OTA_DESC_PARSER_KEY : ESP_OTA_DESC_PARSER_VALUE;
+			}
+			else if(c == '}' || c == ']')
+			{
+				esp_ota_desc_parser_pop(parser, c == '}');
+			}
+			else
+			{
+				parser->state = ESP_OTA_DESC_PARSER_ERROR;
+			}
+			break;
+
+		default:
+			/* trailing data after the descriptor object */
+			parser->state = ESP_OTA_DESC_PARSER_ERROR;
+			break;
+		}
+	}
+	return (parser->state == ESP_OTA_DESC_PARSER_ERROR) ? -1 : 0;
+}
+
+int esp_ota_desc_parser_finish(esp_ota_desc_parser_t *parser)
+{
+	if(parser->state != ESP_OTA_DESC_PARSER_DONE)
+	{
+		debugPrintln("parser: incomplete descriptor, state: %u", parser->state);
+		return -1;
+	}
+	return esp_ota_desc_validate(parser->desc);
+}
+
+int esp_ota_desc_parse_bin(const uint8_t *data, unsigned int length, esp_ota_desc_t *info)
+{
+	const uint8_t *field, *end;
+	unsigned int field_length;
+	uint16_t total;
+
+	/* the whole descriptor is here, its fields are decoded in place */
+	esp_ota_desc_reset(info);
+	if(	length < (ESP_OTA_DESC_BIN_HEADER_SIZE + ESP_OTA_DESC_BIN_CRC_SIZE) ||
+		!esp_ota_desc_bin_header(info, data, &total) ||
+		total != length ||
+		~esp_ota_desc_crc32(0xffffffff, data, length - ESP_OTA_DESC_BIN_CRC_SIZE) !=
+			esp_ota_desc_get_u32(&data[length - ESP_OTA_DESC_BIN_CRC_SIZE]))
+	{
+		goto error;
+	}
+
+	end = &data[length - ESP_OTA_DESC_BIN_CRC_SIZE];
+	for(field = &data[ESP_OTA_DESC_BIN_HEADER_SIZE]; field < end; field += ESP_OTA_DESC_BIN_FIELD_SIZE + field_length)
+	{
+		if((end - field) < ESP_OTA_DESC_BIN_FIELD_SIZE)
+		{
+			goto error;
+		}
+		field_length = esp_ota_desc_get_u16(&field[1]);
+		if(field_length > (unsigned int)(end - field - ESP_OTA_DESC_BIN_FIELD_SIZE))
+		{
+			goto error;
+		}
+		if(esp_ota_desc_bin_field_length(field[0]))
+		{
+			if(field_length != esp_ota_desc_bin_field_length(field[0]))
+			{
+				goto error;
+			}
+			esp_ota_desc_bin_field(info, field[0], &field[ESP_OTA_DESC_BIN_FIELD_SIZE]);
+		}
+		else if(field[0] == ESP_OTA_DESC_BIN_BLOCKS)
+		{
+			if(!esp_ota_desc_bin_blocks(info, field_length))
+			{
+				goto error;
+			}
+			memcpy(info->blocks, &field[ESP_OTA_DESC_BIN_FIELD_SIZE], field_length);
+		}
+	}
+	return esp_ota_desc_validate(info);
+
+error:
+	esp_ota_desc_free(info);
+	return -1;
+}
+
+esp_ota_desc_format_t esp_ota_desc_url_format(const char *url)
+{
+	unsigned int length, extension;
+
+	if(!url)
+	{
+		return ESP_OTA_DESC_FORMAT_JSON;
+	}
+	/* path only, without query and fragment */
+	length = strcspn(url, "?#");
+	extension = strlen(ESP_OTA_DESC_BIN_EXTENSION);
+	if(length >= extension && !strncasecmp(&url[length - extension], ESP_OTA_DESC_BIN_EXTENSION, extension))
+	{
+		return ESP_OTA_DESC_FORMAT_BIN;
+	}
+	return ESP_OTA_DESC_FORMAT_JSON;
+}
+
+/* media type without parameters, "type/subtype; charset=..." */
+static bool esp_ota_desc_media_type(const char *content_type, const char *type)
+{
+	unsigned int length = strlen(type);
+
+	return (!strncasecmp(content_type, type, length) &&
+		(content_type[length] == '\0' || content_type[length] == ';' || content_type[length] == ' '));
+}
+
+esp_ota_desc_format_t esp_ota_desc_format(const char *content_type, esp_ota_desc_format_t fallback)
+{
+	if(!content_type)
+	{
+		return fallback;
+	}
+	if(esp_ota_desc_media_type(content_type, ESP_OTA_DESC_BIN_CONTENT_TYPE))
+	{
+		return ESP_OTA_DESC_FORMAT_BIN;
+	}
+	if(esp_ota_desc_media_type(content_type, "application/json"))
+	{
+		return ESP_OTA_DESC_FORMAT_JSON;
+	}
+	return fallback;
+}
+
+/* tokens of the value at t, its nested values included */
+static int jsmntok_span(const jsmntok_t *t, int count)
+{
+	int n;
+
+	for(n = 1; n < count && t[n].start < t->end; n++);
+	return n;
+}
+
+/* NUL terminated copy of a string token, false: it doesn't fit */
+static bool esp_ota_desc_string(char *string, unsigned int size, const char *js, const jsmntok_t *t)
+{
+	unsigned int length = jsmntok_get_size(t);
+
+	if(t->type != JSMN_STRING || length >= size)
+	{
+		return false;
+	}
+	memcpy(string, js + jsmntok_get_offset(t), length);
+	string[length] = '\0';
+	return true;
+}
+
+/* one object of "components", count: its tokens */
+static int esp_ota_desc_component
+	(
+		const char *js,
+		const jsmntok_t *object,
+		int count,
+		esp_ota_desc_component_t *component
+	)
+{
+	const jsmntok_t *key, *value;
+	bool valid = true;
+	int i, n;
+
+	memset(component, 0, sizeof(esp_ota_desc_component_t));
+	esp_ota_desc_reset(&component->desc);
+	for(i = 1; i + 1 < count; i += 1 + jsmntok_span(value, count - i - 1))
+	{
+		key = &object[i];
+		value = &object[i + 1];
+		if(jsmntok_strcmp(js, key, "name") == 0)
+		{
+			valid &= esp_ota_desc_string(component->name, sizeof(component->name), js, value);
+		}
+		else if(jsmntok_strcmp(js, key, "partition") == 0)
+		{
+			valid &= esp_ota_desc_string(component->partition, sizeof(component->partition), js, value);
+		}
+		else if(jsmntok_strcmp(js, key, "url") == 0)
+		{
+			valid &= esp_ota_desc_string(component->url, sizeof(component->url), js, value);
+		}
+		else if(value->type == JSMN_ARRAY && jsmntok_strcmp(js, key, "blocks") == 0)
+		{
+			for(n = 1; n < jsmntok_span(value, count - i - 1) && value[n].type == JSMN_STRING; n++)
+			{
+				esp_ota_desc_block(&component->desc, js+jsmntok_get_offset(&value[n]), jsmntok_get_size(&value[n]));
+			}
+		}
+		else if(value->type == JSMN_PRIMITIVE || value->type == JSMN_STRING)
+		{
+			esp_ota_desc_set
 				(
-					js+jsmntok_get_offset(json_jsmntok[i].t_value),
-					info->sha256,
-					32
+					&component->desc,
+					js+jsmntok_get_offset(key),
+					jsmntok_get_size(key),
+					js+jsmntok_get_offset(value),
+					jsmntok_get_size(value),
+					value->type == JSMN_STRING
 				);
-			if(n != 32)
+		}
+	}
+	if(!valid || !component->url[0])
+	{
+		debugPrintln("component \"%s\": bad name, partition or url", component->name);
+		esp_ota_desc_free(&component->desc);
+		return -1;
+	}
+	return esp_ota_desc_validate(&component->desc);
+}
+
+int esp_ota_desc_parse_manifest(const char *js, unsigned int jslen, esp_ota_desc_manifest_t *manifest)
+{
+	jsmn_parser parser;
+	jsmntok_t *tokens, *value;
+	int i, n, span, tokcount, rc;
+
+	memset(manifest, 0, sizeof(esp_ota_desc_manifest_t));
+	manifest->version = 0xffff;
+
+	/* counting pass, then one allocation */
+	jsmn_init(&parser);
+	tokcount = jsmn_parse(&parser, js, jslen, NULL, 0);
+	if(tokcount <= 0)
+	{
+		return -1;
+	}
+	tokens = ESP_OTA_MALLOC(sizeof(jsmntok_t) * tokcount);
+	if(!tokens)
+	{
+		debugPrintln("jsmn_parse: out of memory at %d tokens", tokcount);
+		return -1;
+	}
+	jsmn_init(&parser);
+	tokcount = jsmn_parse(&parser, js, jslen, tokens, tokcount);
+	if(tokcount <= 0 || tokens[0].type != JSMN_OBJECT)
+	{
+		ESP_OTA_FREE(tokens);
+		return -1;
+	}
+
+	rc = 0;
+	tokcount = jsmntok_span(tokens, tokcount);
+	for(i = 1; i + 1 < tokcount && rc == 0; i += 1 + span)
+	{
+		value = &tokens[i + 1];
+		span = jsmntok_span(value, tokcount - i - 1);
+		if(value->type == JSMN_PRIMITIVE && jsmntok_strcmp(js, &tokens[i], "version") == 0)
+		{
+			manifest->version = strtol(js+jsmntok_get_offset(value), NULL, 10);
+		}
+		else if(value->type == JSMN_ARRAY && jsmntok_strcmp(js, &tokens[i], "components") == 0)
+		{
+			for(n = 1; n < span && rc == 0; n += jsmntok_span(&value[n], span - n))
 			{
-				memset(info->sha256, 0, 32);
+				if(value[n].type != JSMN_OBJECT || manifest->count >= ESP_OTA_DESC_MANIFEST_COMPONENTS)
+				{
+					debugPrintln("manifest: component %u is not supported", manifest->count);
+					rc = -1;
+					break;
+				}
+				rc = esp_ota_desc_component
+					(
+						js,
+						&value[n],
+						jsmntok_span(&value[n], span - n),
+						&manifest->components[manifest->count]
+					);
+				if(rc == 0)
+				{
+					manifest->count++;
+				}
 			}
 		}
 	}
+	ESP_OTA_FREE(tokens);
 
-	// final validate
-	if(info->version.u16 == 0xffff)
+	if(rc != 0 || !manifest->count)
 	{
+		esp_ota_desc_manifest_free(manifest);
 		return -1;
 	}
-	for(i = 0; i < 32; i++)
+	debugPrintln("manifest %u: %u components", manifest->version, manifest->count);
+	return 0;
+}
+
+void esp_ota_desc_manifest_free(esp_ota_desc_manifest_t *manifest)
+{
+	unsigned int i;
+
+	for(i = 0; i < manifest->count; i++)
+	{
+		esp_ota_desc_free(&manifest->components[i].desc);
+	}
+	manifest->count = 0;
+}
+
+#ifdef ESP_OTA_DESC_BENCHMARK
+#define ESP_OTA_DESC_BENCHMARK_SHA256	\
+	"\"5e884898da28047151d0e56f8dc6292773603d0d6aabbdd62a11ef721d1542d8\""
+
+/* descriptors of tools/esp_ota_desc.py and with build metadata */
+static const char *const esp_ota_desc_benchmark_corpus[][2] =
 	{
-		if(info->sha256[i])
 		{
-			return 0;
+			"plain",
+			"{\"version\": 258, \"sha256\": " ESP_OTA_DESC_BENCHMARK_SHA256 ", \"size\": 482304}"
+		},
+		{
+			"codec",
+			"{\"version\": 258, \"sha256\": " ESP_OTA_DESC_BENCHMARK_SHA256 ", \"size\": 482304, "
+			"\"codec\": \"heatshrink\", \"zsize\": 301122, \"zsha256\": " ESP_OTA_DESC_BENCHMARK_SHA256 ", "
+			"\"window\": 10, \"lookahead\": 5}"
+		},
+		{
+			"delta",
+			"{\"version\": 258, \"sha256\": " ESP_OTA_DESC_BENCHMARK_SHA256 ", \"size\": 482304, "
+			"\"base_version\": 257, \"base_size\": 480112, \"base_sha256\": " ESP_OTA_DESC_BENCHMARK_SHA256 ", "
+			"\"retry_after\": 21600}"
+		},
+		{
+			"metadata",
+			"{\"name\": \"sensor-node\", \"version\": 258, "
+			"\"build\": {\"date\": \"2020-03-14T09:26:53Z\", \"commit\": \"4f2a91c\", \"flags\": [\"release\", \"lto\"]}, "
+			"\"sha256\": " ESP_OTA_DESC_BENCHMARK_SHA256 ", \"size\": 482304, "
+			"\"notes\": [\"fix reconnect after AP restart\", \"lower idle current\", \"new calibration table\"], "
+			"\"channels\": [\"stable\", \"beta\"], \"min_version\": 256, \"retry_after\": 21600}"
+		},
+	};
+
+/* a chunk sync descriptor of count blocks */
+static char *esp_ota_desc_benchmark_blocks(unsigned int count)
+{
+	unsigned int i, n;
+	char *js;
+
+	js = (char *)ESP_OTA_MALLOC(160 + (count * ((ESP_OTA_DESC_BLOCK_HASH_SIZE * 2) + 4)));
+	if(!js)
+	{
+		return NULL;
+	}
+	n = sprintf
+		(
+			js,
+			"{\"version\": 258, \"sha256\": " ESP_OTA_DESC_BENCHMARK_SHA256 ", \"size\": %u, "
+			"\"block_size\": %u, \"blocks\": [",
+			count * ESP_OTA_DESC_BLOCK_SIZE,
+			ESP_OTA_DESC_BLOCK_SIZE
+		);
+	for(i = 0; i < count; i++)
+	{
+		n += sprintf(js + n, "%s\"%0*x\"", i ? ", " : "", ESP_OTA_DESC_BLOCK_HASH_SIZE * 2, i);
+	}
+	strcpy(js + n, "]}");
+	return js;
+}
+
+static void esp_ota_desc_benchmark_one(const char *name, const char *js, uint32_t rounds)
+{
+	esp_ota_desc_parser_t parser;
+	esp_ota_desc_t desc;
+	unsigned int length;
+	uint32_t i, t_json, t_stream;
+	int rc_json = 0, rc_stream = 0;
+
+	memset(&desc, 0, sizeof(esp_ota_desc_t));
+	length = strlen(js);
+
+	t_json = ESP_OTA_TIME_US();
+	for(i = 0; i < rounds; i++)
+	{
+		rc_json |= esp_ota_desc_parse_json(js, length, &desc);
+		esp_ota_desc_free(&desc);
+	}
+	t_json = ESP_OTA_TIME_US() - t_json;
+
+	t_stream = ESP_OTA_TIME_US();
+	for(i = 0; i < rounds; i++)
+	{
+		esp_ota_desc_parser_init(&parser, &desc);
+		rc_stream |= esp_ota_desc_parser_feed(&parser, js, length);
+		rc_stream |= esp_ota_desc_parser_finish(&parser);
+		esp_ota_desc_free(&desc);
+	}
+	t_stream = ESP_OTA_TIME_US() - t_stream;
+
+	printf
+		(
+			"%-10s %6u %10u %10u%s\r\n",
+			name, length,
+			(uint32_t)(((uint64_t)t_json * 1000) / rounds),
+			(uint32_t)(((uint64_t)t_stream * 1000) / rounds),
+			(rc_json || rc_stream) ? " invalid" : ""
+		);
+}
+
+void esp_ota_desc_benchmark(uint32_t rounds)
+{
+	static const unsigned int blocks[] = { 16, 256 };
+	char name[16];
+	unsigned int i;
+	char *js;
+
+	if(!rounds)
+	{
+		return;
+	}
+	printf("%-10s %6s %10s %10s\r\n", "ns/parse", "bytes", "json", "stream");
+	for(i = 0; i < sizeof(esp_ota_desc_benchmark_corpus) / sizeof(esp_ota_desc_benchmark_corpus[0]); i++)
+	{
+		esp_ota_desc_benchmark_one
+			(
+				esp_ota_desc_benchmark_corpus[i][0],
+				esp_ota_desc_benchmark_corpus[i][1],
+				rounds
+			);
+	}
+	for(i = 0; i < sizeof(blocks) / sizeof(blocks[0]); i++)
+	{
+		js = esp_ota_desc_benchmark_blocks(blocks[i]);
+		if(!js)
+		{
+			return;
 		}
+		snprintf(name, sizeof(name), "blocks%u", blocks[i]);
+		esp_ota_desc_benchmark_one(name, js, rounds);
+		ESP_OTA_FREE(js);
 	}
-	return -1;
 }
+#endif
 
 /*
  * EOF
  */
-
@@ -59,6 +59,22 @@
 #ifndef ESP_OTA_DESC_H
 #define ESP_OTA_DESC_H
 
+#define ESP_OTA_DESC_CODEC_NONE			(0)
+#define ESP_OTA_DESC_CODEC_HEATSHRINK	(1)
+#define ESP_OTA_DESC_CODEC_LZ4			(2)
+#define ESP_OTA_DESC_CODEC_DEFLATE		(3)
+#define ESP_OTA_DESC_CODEC_UNKNOWN		(0xff)
+
+#define ESP_OTA_DESC_BLOCK_HASH_SIZE	(8)
+
+#ifndef ESP_OTA_DESC_BLOCK_SIZE
+#define ESP_OTA_DESC_BLOCK_SIZE			(4096)
+#endif
+
+#ifndef ESP_OTA_DESC_BLOCKS_MAX
+#define ESP_OTA_DESC_BLOCKS_MAX			(1024)
+#endif
+
 typedef struct
 {
 	union
@@ -70,7 +86,34 @@ typedef struct
 		};
 		uint16_t u16;
 	}version;
-	uint8_t sha256[32];
+	uint8_t sha256[32];		/* image */
+	uint32_t size;			/* image, 0: unknown */
+
+	/* compressed transfer: "codec", "zsize", "zsha256" */
+	uint8_t codec;
+	uint8_t window_bits;
+	uint8_t lookahead_bits;
+	uint32_t zsize;
+	uint8_t zsha256[32];	/* all zero: not given */
+
+	/* delta: the transfer is a patch against "base_sha256" on the running partition */
+	uint16_t base_version;
+	uint32_t base_size;		/* 0: full image */
+	uint8_t base_sha256[32];
+
+	/*
+	 * chunk sync and per-block verification: "blocks" lists the leading
+	 * ESP_OTA_DESC_BLOCK_HASH_SIZE bytes of the SHA-256 of every
+	 * "block_size" block of the image, "merkle_root" is the SHA-256 of
+	 * the list itself
+	 */
+	uint32_t block_size;
+	uint16_t block_count;
+	uint16_t block_capacity;
+	uint8_t *blocks;		/* NULL: not given, released by esp_ota_desc_free() */
+	uint8_t merkle_root[32];	/* all zero: not given */
+
+	uint32_t retry_after;	/* seconds until the next check (esp_ota_sched), 0: not given */
 }esp_ota_desc_t;
 
 /** @brief esp_ota_nvs_set
@@ -80,4 +123,215 @@ typedef struct
  */
 int esp_ota_desc_parse_json(const char *js, unsigned int jslen, esp_ota_desc_t *info);
 
+/** @brief esp_ota_desc_free
+ *
+ * Release the block list of a parsed descriptor, the parsers start from an
+ * empty descriptor and never free a previous one.
+ */
+void esp_ota_desc_free(esp_ota_desc_t *info);
+
+#ifndef ESP_OTA_DESC_KEY_LENGTH
+#define ESP_OTA_DESC_KEY_LENGTH		(16)
+#endif
+
+#ifndef ESP_OTA_DESC_VALUE_LENGTH
+#define ESP_OTA_DESC_VALUE_LENGTH	((32*2)+1)
+#endif
+
+#define ESP_OTA_DESC_PARSER_DEPTH	(16)
+
+/*
+ * Binary descriptor, little-endian, written by tools/esp_ota_desc.py --bin:
+ *
+ *   0  u32      magic "OTAD"
+ *   4  u8       format version, ESP_OTA_DESC_BIN_VERSION
+ *   5  u8       reserved, 0
+ *   6  u16      length of the whole descriptor, crc included
+ *   8  u16      "version"
+ *  10  u16      reserved, 0
+ *  12  u32      "size"
+ *  16  u8[32]   "sha256"
+ *  48  fields   u8 type, u16 length, value, unknown types are skipped
+ *  ..  u32      CRC-32 (IEEE 802.3) of all bytes before it
+ *
+ * Known fields have a fixed length, "blocks" is a multiple of
+ * ESP_OTA_DESC_BLOCK_HASH_SIZE and the only one that allocates.
+ */
+#define ESP_OTA_DESC_BIN_MAGIC			"OTAD"
+#define ESP_OTA_DESC_BIN_VERSION		(1)
+#define ESP_OTA_DESC_BIN_HEADER_SIZE	(48)
+#define ESP_OTA_DESC_BIN_FIELD_SIZE		(3)
+#define ESP_OTA_DESC_BIN_CRC_SIZE		(4)
+
+#define ESP_OTA_DESC_BIN_CODEC			(1)		/* u8 */
+#define ESP_OTA_DESC_BIN_ZSIZE			(2)		/* u32 */
+#define ESP_OTA_DESC_BIN_ZSHA256		(3)		/* u8[32] */
+#define ESP_OTA_DESC_BIN_WINDOW			(4)		/* u8 */
+#define ESP_OTA_DESC_BIN_LOOKAHEAD		(5)		/* u8 */
+#define ESP_OTA_DESC_BIN_BASE_VERSION	(6)		/* u16 */
+#define ESP_OTA_DESC_BIN_BASE_SIZE		(7)		/* u32 */
+#define ESP_OTA_DESC_BIN_BASE_SHA256	(8)		/* u8[32] */
+#define ESP_OTA_DESC_BIN_BLOCK_SIZE		(9)		/* u32 */
+#define ESP_OTA_DESC_BIN_BLOCKS			(10)	/* u8[8][n] */
+#define ESP_OTA_DESC_BIN_MERKLE_ROOT	(11)	/* u8[32] */
+#define ESP_OTA_DESC_BIN_RETRY_AFTER	(12)	/* u32 */
+
+#ifndef ESP_OTA_DESC_BIN_CONTENT_TYPE
+#define ESP_OTA_DESC_BIN_CONTENT_TYPE	"application/vnd.esp-ota.desc"
+#endif
+
+#ifndef ESP_OTA_DESC_BIN_EXTENSION
+#define ESP_OTA_DESC_BIN_EXTENSION		".otad"
+#endif
+
+typedef enum
+{
+	ESP_OTA_DESC_FORMAT_JSON = 0,
+	ESP_OTA_DESC_FORMAT_BIN
+}esp_ota_desc_format_t;
+
+/** @brief esp_ota_desc_url_format
+ *
+ * ESP_OTA_DESC_FORMAT_BIN if the path of url ends with
+ * ESP_OTA_DESC_BIN_EXTENSION.
+ */
+esp_ota_desc_format_t esp_ota_desc_url_format(const char *url);
+
+/** @brief esp_ota_desc_format
+ *
+ * Format of a descriptor response by its Content-Type,
+ * ESP_OTA_DESC_BIN_CONTENT_TYPE or application/json.
+ *
+ * @param content_type  NULL: not given
+ * @param fallback  any other type, e.g. esp_ota_desc_url_format()
+ */
+esp_ota_desc_format_t esp_ota_desc_format(const char *content_type, esp_ota_desc_format_t fallback);
+
+/** @brief esp_ota_desc_parse_bin
+ *
+ * Same validation as esp_ota_desc_parse_json().
+ *
+ * @return  0: descriptor is complete and valid
+ */
+int esp_ota_desc_parse_bin(const uint8_t *data, unsigned int length, esp_ota_desc_t *info);
+
+/*
+ * Incremental descriptor parser: the body is fed as it arrives.
+ * JSON: only the current key and one scalar value are kept (longer values
+ * are cut), nested objects and arrays are skipped.
+ * Binary: the header and one field are kept, block hashes go straight to
+ * the descriptor.
+ */
+typedef struct
+{
+	esp_ota_desc_t *desc;
+	uint8_t format;
+	uint8_t state;
+	uint8_t depth;
+	uint16_t objects;	/* bit n: container at depth n+1 is an object */
+	bool escape;
+	uint8_t key_length;
+	uint8_t value_length;
+	char key[ESP_OTA_DESC_KEY_LENGTH];
+	char value[ESP_OTA_DESC_VALUE_LENGTH];
+
+	/* ESP_OTA_DESC_FORMAT_BIN */
+	uint16_t length;		/* of the descriptor, from the header */
+	uint16_t field_length;
+	uint16_t field_offset;
+	uint32_t offset;
+	uint32_t crc;
+}esp_ota_desc_parser_t;
+
+void esp_ota_desc_parser_init(esp_ota_desc_parser_t *parser, esp_ota_desc_t *desc);
+
+/** @brief esp_ota_desc_parser_init_format
+ *
+ * esp_ota_desc_parser_init() of a JSON or a binary descriptor.
+ */
+void esp_ota_desc_parser_init_format
+	(
+		esp_ota_desc_parser_t *parser,
+		esp_ota_desc_t *desc,
+		esp_ota_desc_format_t format
+	);
+
+/** @brief esp_ota_desc_parser_feed
+ *
+ *
+ * @return  0: ok, -1: syntax error
+ */
+int esp_ota_desc_parser_feed(esp_ota_desc_parser_t *parser, const char *data, unsigned int length);
+
+/** @brief esp_ota_desc_parser_finish
+ *
+ * Same validation as esp_ota_desc_parse_json().
+ *
+ * @return  0: descriptor is complete and valid
+ */
+int esp_ota_desc_parser_finish(esp_ota_desc_parser_t *parser);
+
+/*
+ * Manifest: one update of several partitions (app, data, filesystem), one
+ * descriptor per component plus its partition and url. JSON only.
+ *
+ *	{
+ *		"version": 5,
+ *		"components":
+ *		[
+ *			{"name": "app", "partition": "", "url": "app.bin", "version": 261, "size": ..., "sha256": "..."},
+ *			{"name": "www", "partition": "spiffs", "url": "www.bin", "version": 3, "size": ..., "sha256": "..."}
+ *		]
+ *	}
+ *
+ * "partition" is a partition label, "" or missing: the next OTA app
+ * partition. "url" is absolute or relative to the manifest url. The other
+ * members are those of a descriptor (esp_ota_desc_parse_json()).
+ */
+#ifndef ESP_OTA_DESC_MANIFEST_COMPONENTS
+#define ESP_OTA_DESC_MANIFEST_COMPONENTS	(4)
+#endif
+
+#ifndef ESP_OTA_DESC_URL_LENGTH
+#define ESP_OTA_DESC_URL_LENGTH				(128)
+#endif
+
+#define ESP_OTA_DESC_LABEL_LENGTH			(17)	/* esp_partition_t.label */
+
+typedef struct
+{
+	char name[ESP_OTA_DESC_LABEL_LENGTH];
+	char partition[ESP_OTA_DESC_LABEL_LENGTH];	/* "": the next OTA app partition */
+	char url[ESP_OTA_DESC_URL_LENGTH];
+	esp_ota_desc_t desc;
+}esp_ota_desc_component_t;
+
+typedef struct
+{
+	uint16_t version;		/* of the set, 0xffff: not given */
+	uint8_t count;
+	esp_ota_desc_component_t components[ESP_OTA_DESC_MANIFEST_COMPONENTS];
+}esp_ota_desc_manifest_t;
+
+/** @brief esp_ota_desc_parse_manifest
+ *
+ * Every component must be a valid descriptor with a url, names and
+ * partition labels must fit ESP_OTA_DESC_LABEL_LENGTH.
+ *
+ * @return  0: ok, release with esp_ota_desc_manifest_free(), -1: invalid
+ */
+int esp_ota_desc_parse_manifest(const char *js, unsigned int jslen, esp_ota_desc_manifest_t *manifest);
+
+void esp_ota_desc_manifest_free(esp_ota_desc_manifest_t *manifest);
+
+#ifdef ESP_OTA_DESC_BENCHMARK
+/** @brief esp_ota_desc_benchmark
+ *
+ * Parse a corpus of descriptors (plain, compressed, delta, with build
+ * metadata, 16 and 256 blocks) rounds times with esp_ota_desc_parse_json()
+ * and the incremental parser and print the time of one parse (printf).
+ */
+void esp_ota_desc_benchmark(uint32_t rounds);
+#endif
+
 #endif
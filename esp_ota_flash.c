@@ -0,0 +1,529 @@
+/*****************************************************************************
+* File Name: esp_ota_flash.c
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "esp_libc.h"
+
+#include "esp_system.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "esp_partition.h"
+#include "esp_ota_ops.h"
+
+#include "esp_ota_port.h"
+#include "esp_ota_flash.h"
+
+#ifdef ESP_OTA_DEBUG_ENABLED
+#ifndef debugPrintln
+#define debugPrintln(fmt,args...)	\
+	printf("esp-ota-flash: " fmt "%s", ## args, "\r\n")
+#endif
+#else
+#define debugPrintln(...)
+#endif
+
+/* erase from erase_end up to end */
+static esp_err_t esp_ota_flash_erase(esp_ota_flash_t *flash, uint32_t end)
+{
+	esp_err_t err;
+	uint32_t t;
+
+	t = ESP_OTA_TIME_US();
+	err = esp_partition_erase_range(flash->partition, flash->erase_end, end - flash->erase_end);
+	t = ESP_OTA_TIME_US() - t;
+	if (err != ESP_OK)
+	{
+		debugPrintln("esp_partition_erase_range failed at 0x%x, error=0x%x", flash->erase_end, err);
+		return err;
+	}
+	flash->erase_time_us += t;
+	if(t > flash->erase_max_us)
+	{
+		flash->erase_max_us = t;
+	}
+	flash->erase_count++;
+	flash->erase_end = end;
+	return ESP_OK;
+}
+
+/* length of the leading pages that are all 0xFF (blank) or not */
+static unsigned int esp_ota_flash_run(const uint8_t *data, unsigned int length, bool blank)
+{
+	unsigned int i, k, n;
+
+	for(i = 0; i < length; i += n)
+	{
+		n = length - i;
+		if(n > ESP_OTA_FLASH_PAGE_SIZE)
+		{
+			n = ESP_OTA_FLASH_PAGE_SIZE;
+		}
+		for(k = 0; k < n && data[i + k] == 0xff; k++);
+		if((k == n) != blank)
+		{
+			break;
+		}
+	}
+	return i;
+}
+
+/*
+ * write length bytes at offset, in order when it goes through esp_ota_write(),
+ * direct writes go to erased flash, pages of 0xFF are left as they are
+ */
+static esp_err_t esp_ota_flash_program(esp_ota_flash_t *flash, uint32_t offset, const uint8_t *data, unsigned int length)
+{
+	esp_err_t err = ESP_OK;
+	unsigned int n;
+	uint32_t t;
+
+	t = ESP_OTA_TIME_US();
+	if(flash->direct)
+	{
+		while(length && err == ESP_OK)
+		{
+			n = esp_ota_flash_run(data, length, true);
+			flash->blank_count += (n + ESP_OTA_FLASH_PAGE_SIZE - 1) / ESP_OTA_FLASH_PAGE_SIZE;
+			offset += n;
+			data += n;
+			length -= n;
+
+			n = esp_ota_flash_run(data, length, false);
+			if(n)
+			{
+				err = esp_partition_write
+						(
+							flash->partition,
+							offset,
+							(const void *)data,
+							n
+						);
+				flash->write_count++;
+				flash->write_bytes += n;
+			}
+			offset += n;
+			data += n;
+			length -= n;
+		}
+	}
+	else
+	{
+		err = esp_ota_write
+				(
+					flash->update_handle,
+					(const void *)data,
+					length
+				);
+		flash->write_count++;
+		flash->write_bytes += length;
+	}
+	if(err != ESP_OK)
+	{
+		debugPrintln("flash write failed at 0x%x, error=0x%x", offset, err);
+		return err;
+	}
+	t = ESP_OTA_TIME_US() - t;
+	flash->write_time_us += t;
+	if(t > flash->write_max_us)
+	{
+		flash->write_max_us = t;
+	}
+	return ESP_OK;
+}
+
+/* the partition already holds data at offset */
+static bool esp_ota_flash_same(esp_ota_flash_t *flash, uint32_t offset, const uint8_t *data, unsigned int length)
+{
+	uint8_t buffer[ESP_OTA_FLASH_PAGE_SIZE];
+	unsigned int n;
+
+	for(; length; offset += n, data += n, length -= n)
+	{
+		n = (length < sizeof(buffer)) ? length : sizeof(buffer);
+		if(	esp_partition_read(flash->partition, offset, buffer, n) != ESP_OK ||
+			memcmp(buffer, data, n))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/* skip mode: sector by sector, erased and written only when it differs */
+static esp_err_t esp_ota_flash_sync(esp_ota_flash_t *flash)
+{
+	uint32_t offset;
+	unsigned int i, n;
+	esp_err_t err;
+
+	for(i = 0; i < flash->length; i += n)
+	{
+		offset = flash->offset + i;
+		n = flash->length - i;
+		if(n > ESP_OTA_FLASH_SECTOR_SIZE)
+		{
+			n = ESP_OTA_FLASH_SECTOR_SIZE;
+		}
+		if(esp_ota_flash_same(flash, offset, &flash->buffer[i], n))
+		{
+			flash->skip_count++;
+			continue;
+		}
+		flash->erase_end = offset;
+		err = esp_ota_flash_erase(flash, offset + ESP_OTA_FLASH_SECTOR_SIZE);
+		if(err == ESP_OK)
+		{
+			err = esp_ota_flash_program(flash, offset, &flash->buffer[i], n);
+		}
+		if(err != ESP_OK)
+		{
+			return err;
+		}
+	}
+	return ESP_OK;
+}
+
+esp_err_t esp_ota_flash_flush(esp_ota_flash_t *flash)
+{
+	esp_err_t err;
+	uint32_t end;
+
+	if(!flash->length)
+	{
+		return ESP_OK;
+	}
+
+	end = flash->offset + flash->length;
+	if(end > flash->erase_limit)
+	{
+		debugPrintln("flash write at 0x%x is beyond the image", flash->offset);
+		return ESP_ERR_INVALID_SIZE;
+	}
+	/* erase-ahead: keep the next sectors erased, while the network fills the buffers */
+	end = ESP_OTA_FLASH_SECTOR_ALIGN(end) + (flash->erase_ahead * ESP_OTA_FLASH_SECTOR_SIZE);
+	if(end > flash->erase_limit)
+	{
+		end = flash->erase_limit;
+	}
+	if(!flash->skip_same && end > flash->erase_end)
+	{
+		err = esp_ota_flash_erase(flash, end);
+		if(err != ESP_OK)
+		{
+			return err;
+		}
+	}
+
+	if(flash->block_callback)
+	{
+		err = flash->block_callback(flash->block_callback_arg, flash->buffer, flash->length);
+		if(err != ESP_OK)
+		{
+			return err;
+		}
+	}
+
+	if(flash->skip_same)
+	{
+		err = esp_ota_flash_sync(flash);
+	}
+	else
+	{
+		err = esp_ota_flash_program(flash, flash->offset, flash->buffer, flash->length);
+	}
+	if(err != ESP_OK)
+	{
+		return err;
+	}
+	flash->offset += flash->length;
+	flash->length = 0;
+	return ESP_OK;
+}
+
+static esp_err_t esp_ota_flash_init
+	(
+		esp_ota_flash_t *flash,
+		const esp_partition_t *partition,
+		unsigned int block_size
+	)
+{
+	if(!block_size)
+	{
+		block_size = ESP_OTA_FLASH_BLOCK_SIZE;
+	}
+	if(block_size % ESP_OTA_FLASH_PAGE_SIZE)
+	{
+		debugPrintln("block size %u is not multiple of flash page", block_size);
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	memset(flash, 0, sizeof(esp_ota_flash_t));
+	flash->partition = partition;
+	flash->block_size = block_size;
+
+	flash->buffer = (uint8_t *)ESP_OTA_MALLOC(block_size);
+	if(!flash->buffer)
+	{
+		return ESP_ERR_NO_MEM;
+	}
+	debugPrintln("block size: %u", block_size);
+	return ESP_OK;
+}
+
+esp_err_t esp_ota_flash_begin
+	(
+		esp_ota_flash_t *flash,
+		const esp_partition_t *partition,
+		unsigned int block_size,
+		uint32_t image_size,
+		unsigned int erase_ahead,
+		bool skip_same
+	)
+{
+	esp_err_t err;
+	uint32_t t;
+
+	if(image_size > partition->size)
+	{
+		debugPrintln("image %u(bytes) is larger than the partition %u(bytes)", image_size, partition->size);
+		return ESP_ERR_INVALID_SIZE;
+	}
+	if(erase_ahead || skip_same || partition->type != ESP_PARTITION_TYPE_APP)
+	{
+		/* esp_ota_begin() would erase everything up front, app partitions only */
+		return esp_ota_flash_resume(flash, partition, block_size, 0, image_size, erase_ahead, skip_same);
+	}
+
+	err = esp_ota_flash_init(flash, partition, block_size);
+	if(err != ESP_OK)
+	{
+		return err;
+	}
+	flash->erase_limit = image_size ? ESP_OTA_FLASH_SECTOR_ALIGN(image_size) : partition->size;
+	flash->erase_end = flash->erase_limit;
+
+	/* the image size, or the whole partition, is erased here */
+	t = ESP_OTA_TIME_US();
+	err = esp_ota_begin(partition, image_size ? image_size : OTA_SIZE_UNKNOWN, &flash->update_handle);
+	flash->erase_time_us = ESP_OTA_TIME_US() - t;
+	flash->erase_max_us = flash->erase_time_us;
+	flash->erase_count = 1;
+	if (err != ESP_OK)
+	{
+		debugPrintln("esp_ota_begin failed, error=0x%x", err);
+		ESP_OTA_FREE(flash->buffer);
+		flash->buffer = NULL;
+		return err;
+	}
+	return ESP_OK;
+}
+
+esp_err_t esp_ota_flash_open
+	(
+		esp_ota_flash_t *flash,
+		const esp_partition_t *partition,
+		unsigned int block_size,
+		uint32_t offset
+	)
+{
+	esp_err_t err;
+
+	if((offset % ESP_OTA_FLASH_PAGE_SIZE) || offset >= partition->size)
+	{
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	err = esp_ota_flash_init(flash, partition, block_size);
+	if(err != ESP_OK)
+	{
+		return err;
+	}
+	flash->direct = true;
+	flash->offset = offset;
+	flash->erase_end = partition->size;
+	flash->erase_limit = partition->size;
+	return ESP_OK;
+}
+
+esp_err_t esp_ota_flash_resume
+	(
+		esp_ota_flash_t *flash,
+		const esp_partition_t *partition,
+		unsigned int block_size,
+		uint32_t offset,
+		uint32_t image_size,
+		unsigned int erase_ahead,
+		bool skip_same
+	)
+{
+	esp_err_t err;
+
+	if((offset % ESP_OTA_FLASH_SECTOR_SIZE) || image_size > partition->size)
+	{
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	err = esp_ota_flash_open(flash, partition, block_size, offset);
+	if(err != ESP_OK)
+	{
+		return err;
+	}
+	flash->erase_limit = image_size ? ESP_OTA_FLASH_SECTOR_ALIGN(image_size) : partition->size;
+	flash->erase_end = offset;
+	flash->erase_ahead = erase_ahead;
+	if(skip_same && (flash->block_size % ESP_OTA_FLASH_SECTOR_SIZE))
+	{
+		debugPrintln("block size %u is not multiple of flash sector, no skip", flash->block_size);
+		skip_same = false;
+	}
+	flash->skip_same = skip_same;
+	if(erase_ahead || skip_same || offset >= flash->erase_limit)
+	{
+		return ESP_OK;
+	}
+
+	err = esp_ota_flash_erase(flash, flash->erase_limit);
+	if (err != ESP_OK)
+	{
+		ESP_OTA_FREE(flash->buffer);
+		flash->buffer = NULL;
+		return err;
+	}
+	debugPrintln("resume at 0x%x", offset);
+	return ESP_OK;
+}
+
+uint8_t *esp_ota_flash_get_buffer(esp_ota_flash_t *flash, unsigned int *length)
+{
+	*length = flash->block_size - flash->length;
+	return &flash->buffer[flash->length];
+}
+
+esp_err_t esp_ota_flash_commit(esp_ota_flash_t *flash, unsigned int length)
+{
+	if(length > (flash->block_size - flash->length))
+	{
+		return ESP_ERR_INVALID_SIZE;
+	}
+	flash->length += length;
+	if(flash->length < flash->block_size)
+	{
+		return ESP_OK;
+	}
+	return esp_ota_flash_flush(flash);
+}
+
+esp_err_t esp_ota_flash_write(esp_ota_flash_t *flash, const void *data, unsigned int length)
+{
+	const uint8_t *p = (const uint8_t *)data;
+	unsigned int n;
+	esp_err_t err;
+
+	while(length)
+	{
+		n = flash->block_size - flash->length;
+		if(n > length)
+		{
+			n = length;
+		}
+		memcpy(&flash->buffer[flash->length], p, n);
+		err = esp_ota_flash_commit(flash, n);
+		if(err != ESP_OK)
+		{
+			return err;
+		}
+		p += n;
+		length -= n;
+	}
+	return ESP_OK;
+}
+
+void esp_ota_flash_discard(esp_ota_flash_t *flash)
+{
+	flash->length = 0;
+}
+
+esp_err_t esp_ota_flash_skip(esp_ota_flash_t *flash, uint32_t length)
+{
+	if(!flash->direct || flash->length || (length % ESP_OTA_FLASH_PAGE_SIZE))
+	{
+		return ESP_ERR_INVALID_STATE;
+	}
+	flash->offset += length;
+	return ESP_OK;
+}
+
+esp_err_t esp_ota_flash_end(esp_ota_flash_t *flash, bool flush)
+{
+	esp_err_t err, end_err;
+
+	err = flush ? esp_ota_flash_flush(flash) : ESP_OK;
+	end_err = flash->direct ? ESP_OK : esp_ota_end(flash->update_handle);
+
+	debugPrintln
+		(
+			"flash: %u bytes in %u writes, %u sectors skipped, %u blank pages",
+			flash->write_bytes,
+			flash->write_count,
+			flash->skip_count,
+			flash->blank_count
+		);
+
+	ESP_OTA_FREE(flash->buffer);
+	flash->buffer = NULL;
+	return (err != ESP_OK) ? err : end_err;
+}
+
+/*
+ * EOF
+ */
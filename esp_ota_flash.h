@@ -0,0 +1,219 @@
+/*****************************************************************************
+* File Name: esp_ota_flash.h
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+
+/*******************************************************************************
+* User defined Macros
+*******************************************************************************/
+
+#ifndef ESP_OTA_FLASH_H
+#define ESP_OTA_FLASH_H
+
+#define ESP_OTA_FLASH_PAGE_SIZE		(256)
+#define ESP_OTA_FLASH_SECTOR_SIZE	(4096)
+
+#define ESP_OTA_FLASH_SECTOR_ALIGN(x)	\
+	(((x) + ESP_OTA_FLASH_SECTOR_SIZE - 1) & ~(ESP_OTA_FLASH_SECTOR_SIZE - 1))
+
+#ifndef ESP_OTA_FLASH_BLOCK_SIZE
+#define ESP_OTA_FLASH_BLOCK_SIZE	ESP_OTA_FLASH_SECTOR_SIZE
+#endif
+
+typedef esp_err_t (*esp_ota_flash_block_callback_t)(void *arg, const uint8_t *data, unsigned int length);
+
+typedef struct
+{
+	const esp_partition_t *partition;
+	esp_ota_handle_t update_handle;
+	bool direct;	/* esp_partition_write, no esp_ota_begin/esp_ota_end */
+	uint8_t *buffer;
+	unsigned int block_size;
+	unsigned int length;
+	uint32_t offset;
+	uint32_t write_count;
+	uint32_t write_bytes;
+	uint32_t write_time_us;
+	uint32_t write_max_us;
+
+	/* flash is erased up to erase_end, nothing is written beyond erase_limit */
+	uint32_t erase_end;
+	uint32_t erase_limit;
+	unsigned int erase_ahead;	/* sectors erased ahead of the write cursor, 0: all at begin */
+	uint32_t erase_count;
+	uint32_t erase_time_us;
+	uint32_t erase_max_us;
+
+	/* skip mode: sectors already holding the data are not erased/written */
+	bool skip_same;
+	uint32_t skip_count;
+
+	/* direct writes: pages of 0xFF (the erased state) are not programmed */
+	uint32_t blank_count;
+
+	/* called with every block before it is written */
+	esp_ota_flash_block_callback_t block_callback;
+	void *block_callback_arg;
+}esp_ota_flash_t;
+
+/** @brief esp_ota_flash_begin
+ *
+ * Start an update of the partition. Data is gathered into blocks of
+ * block_size bytes (multiple of the flash page size) before it is written.
+ *
+ * @param block_size  0: ESP_OTA_FLASH_BLOCK_SIZE
+ * @param image_size  0: unknown, the whole partition is erased
+ * @param erase_ahead  0: the image is erased here (esp_ota_begin), else
+ *                     sectors are erased erase_ahead sectors ahead of the
+ *                     writes and the partition is written directly
+ *                     (always for data partitions, esp_ota_begin() takes
+ *                     app partitions only, the image is erased here)
+ * @param skip_same  every sector is compared with the partition first and
+ *                   erased/written only when it differs (block_size must be
+ *                   a multiple of the sector size), erase_ahead is ignored
+ * @return  ESP_ERR_INVALID_SIZE: the image doesn't fit the partition
+ */
+esp_err_t esp_ota_flash_begin
+	(
+		esp_ota_flash_t *flash,
+		const esp_partition_t *partition,
+		unsigned int block_size,
+		uint32_t image_size,
+		unsigned int erase_ahead,
+		bool skip_same
+	);
+
+/** @brief esp_ota_flash_open
+ *
+ * Write directly into an already erased region of the partition from
+ * offset (flash page aligned) on, e.g. one range of a parallel download.
+ */
+esp_err_t esp_ota_flash_open
+	(
+		esp_ota_flash_t *flash,
+		const esp_partition_t *partition,
+		unsigned int block_size,
+		uint32_t offset
+	);
+
+/** @brief esp_ota_flash_resume
+ *
+ * Continue an update interrupted at offset (flash sector aligned): the
+ * partition is erased from offset on and written directly, the image is
+ * validated by esp_ota_set_boot_partition().
+ *
+ * @param image_size  0: unknown, erased up to the end of the partition
+ * @param erase_ahead, skip_same  see esp_ota_flash_begin()
+ */
+esp_err_t esp_ota_flash_resume
+	(
+		esp_ota_flash_t *flash,
+		const esp_partition_t *partition,
+		unsigned int block_size,
+		uint32_t offset,
+		uint32_t image_size,
+		unsigned int erase_ahead,
+		bool skip_same
+	);
+
+/** @brief esp_ota_flash_get_buffer
+ *
+ * Free space of the current block, data can be read directly into it and
+ * then accounted with esp_ota_flash_commit().
+ */
+uint8_t *esp_ota_flash_get_buffer(esp_ota_flash_t *flash, unsigned int *length);
+
+/** @brief esp_ota_flash_commit
+ *
+ * Account length bytes placed into the buffer returned by
+ * esp_ota_flash_get_buffer(), the block is written when it is full.
+ */
+esp_err_t esp_ota_flash_commit(esp_ota_flash_t *flash, unsigned int length);
+
+/** @brief esp_ota_flash_write
+ *
+ * Copy data into the block buffer, writing every block that becomes full.
+ */
+esp_err_t esp_ota_flash_write(esp_ota_flash_t *flash, const void *data, unsigned int length);
+
+/** @brief esp_ota_flash_flush
+ *
+ * Write the current partial block now, e.g. the last block of an image
+ * when the block callback result is needed before esp_ota_flash_end().
+ */
+esp_err_t esp_ota_flash_flush(esp_ota_flash_t *flash);
+
+/** @brief esp_ota_flash_discard
+ *
+ * Drop the unwritten data of the current block, e.g. after the block
+ * callback rejected it, writing continues at flash->offset.
+ */
+void esp_ota_flash_discard(esp_ota_flash_t *flash);
+
+/** @brief esp_ota_flash_skip
+ *
+ * Direct writes: move on over length bytes (flash pages) written by
+ * someone else, e.g. a block another mirror finished first. The block
+ * buffer must be empty.
+ */
+esp_err_t esp_ota_flash_skip(esp_ota_flash_t *flash, uint32_t length);
+
+/** @brief esp_ota_flash_end
+ *
+ * Write the last partial block and close the update handle.
+ * Must be called after a successful esp_ota_flash_begin(), also on error.
+ *
+ * @param flush  false: drop buffered data (error path)
+ */
+esp_err_t esp_ota_flash_end(esp_ota_flash_t *flash, bool flush);
+
+#endif
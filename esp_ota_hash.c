@@ -0,0 +1,631 @@
+/*****************************************************************************
+* File Name: esp_ota_hash.c
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+#include "mbedtls/sha256.h"
+
+#include "esp_libc.h"
+
+#include "esp_system.h"
+#include "esp_timer.h"
+
+#ifdef ESP_OTA_HASH_ESP_SHA
+#include "esp_sha.h"
+#endif
+
+#include "esp_ota_port.h"
+#include "esp_ota_hash.h"
+
+#if defined(__SHA__) && defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+#ifdef ESP_OTA_DEBUG_ENABLED
+#ifndef debugPrintln
+#define debugPrintln(fmt,args...)	\
+	printf("esp-ota-hash: " fmt "%s", ## args, "\r\n")
+#endif
+#else
+#define debugPrintln(...)
+#endif
+
+#define ESP_OTA_HASH_CTX(hash, type)	((type *)(hash)->ctx.bytes)
+
+/* a backend context that doesn't fit fails here at compile time */
+#define ESP_OTA_HASH_CTX_CHECK(type)	\
+	typedef char esp_ota_hash_check_##type[(sizeof(type) <= ESP_OTA_HASH_CTX_SIZE) ? 1 : -1]
+
+/*
+ * mbedTLS
+ */
+
+ESP_OTA_HASH_CTX_CHECK(mbedtls_sha256_context);
+
+static esp_err_t esp_ota_hash_mbedtls_init(esp_ota_hash_t *hash)
+{
+	mbedtls_sha256_context *ctx = ESP_OTA_HASH_CTX(hash, mbedtls_sha256_context);
+
+	mbedtls_sha256_init( ctx );
+	return mbedtls_sha256_starts_ret( ctx, 0 ) ? ESP_FAIL : ESP_OK;
+}
+
+static esp_err_t esp_ota_hash_mbedtls_update(esp_ota_hash_t *hash, const uint8_t *data, unsigned int length)
+{
+	mbedtls_sha256_context *ctx = ESP_OTA_HASH_CTX(hash, mbedtls_sha256_context);
+
+	return mbedtls_sha256_update_ret( ctx, data, length ) ? ESP_FAIL : ESP_OK;
+}
+
+static esp_err_t esp_ota_hash_mbedtls_finish(esp_ota_hash_t *hash, uint8_t *sha256)
+{
+	mbedtls_sha256_context *ctx = ESP_OTA_HASH_CTX(hash, mbedtls_sha256_context);
+
+	return mbedtls_sha256_finish_ret( ctx, sha256 ) ? ESP_FAIL : ESP_OK;
+}
+
+static void esp_ota_hash_mbedtls_free(esp_ota_hash_t *hash)
+{
+	mbedtls_sha256_free( ESP_OTA_HASH_CTX(hash, mbedtls_sha256_context) );
+}
+
+#if !defined(MBEDTLS_SHA256_ALT)
+static bool esp_ota_hash_mbedtls_export(const esp_ota_hash_t *hash, esp_ota_hash_midstate_t *midstate)
+{
+	const mbedtls_sha256_context *ctx = ESP_OTA_HASH_CTX(hash, const mbedtls_sha256_context);
+
+	memcpy(midstate->total, ctx->total, sizeof(midstate->total));
+	memcpy(midstate->state, ctx->state, sizeof(midstate->state));
+	return true;
+}
+
+static bool esp_ota_hash_mbedtls_import(esp_ota_hash_t *hash, const esp_ota_hash_midstate_t *midstate)
+{
+	mbedtls_sha256_context *ctx = ESP_OTA_HASH_CTX(hash, mbedtls_sha256_context);
+
+	memcpy(ctx->total, midstate->total, sizeof(ctx->total));
+	memcpy(ctx->state, midstate->state, sizeof(ctx->state));
+	return true;
+}
+#endif
+
+const esp_ota_hash_backend_t esp_ota_hash_mbedtls =
+{
+	"mbedtls",
+	esp_ota_hash_mbedtls_init,
+	esp_ota_hash_mbedtls_update,
+	esp_ota_hash_mbedtls_finish,
+	esp_ota_hash_mbedtls_free,
+#if !defined(MBEDTLS_SHA256_ALT)
+	esp_ota_hash_mbedtls_export,
+	esp_ota_hash_mbedtls_import
+#else
+	NULL,
+	NULL
+#endif
+};
+
+/*
+ * SDK
+ */
+
+#ifdef ESP_OTA_HASH_ESP_SHA
+ESP_OTA_HASH_CTX_CHECK(esp_sha256_t);
+
+static esp_err_t esp_ota_hash_esp_init(esp_ota_hash_t *hash)
+{
+	return esp_sha256_init( ESP_OTA_HASH_CTX(hash, esp_sha256_t) ) ? ESP_FAIL : ESP_OK;
+}
+
+static esp_err_t esp_ota_hash_esp_update(esp_ota_hash_t *hash, const uint8_t *data, unsigned int length)
+{
+	return esp_sha256_update( ESP_OTA_HASH_CTX(hash, esp_sha256_t), data, length ) ? ESP_FAIL : ESP_OK;
+}
+
+static esp_err_t esp_ota_hash_esp_finish(esp_ota_hash_t *hash, uint8_t *sha256)
+{
+	return esp_sha256_finish( ESP_OTA_HASH_CTX(hash, esp_sha256_t), sha256 ) ? ESP_FAIL : ESP_OK;
+}
+
+static void esp_ota_hash_esp_free(esp_ota_hash_t *hash)
+{
+}
+
+const esp_ota_hash_backend_t esp_ota_hash_esp =
+{
+	"esp",
+	esp_ota_hash_esp_init,
+	esp_ota_hash_esp_update,
+	esp_ota_hash_esp_finish,
+	esp_ota_hash_esp_free,
+	NULL,
+	NULL
+};
+#endif
+
+/*
+ * Built-in implementations: one context, the block function differs
+ */
+
+typedef struct
+{
+	uint32_t total[2];
+	uint32_t state[8];
+	uint8_t buffer[64];
+}esp_ota_hash_ctx_t;
+
+ESP_OTA_HASH_CTX_CHECK(esp_ota_hash_ctx_t);
+
+typedef void (*esp_ota_hash_blocks_t)(uint32_t *state, const uint8_t *data, unsigned int count);
+
+static const uint32_t esp_ota_hash_k[64] =
+{
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ESP_OTA_HASH_ROTR(x, n)		(((x) >> (n)) | ((x) << (32 - (n))))
+#define ESP_OTA_HASH_S0(x)			(ESP_OTA_HASH_ROTR(x, 2) ^ ESP_OTA_HASH_ROTR(x, 13) ^ ESP_OTA_HASH_ROTR(x, 22))
+#define ESP_OTA_HASH_S1(x)			(ESP_OTA_HASH_ROTR(x, 6) ^ ESP_OTA_HASH_ROTR(x, 11) ^ ESP_OTA_HASH_ROTR(x, 25))
+#define ESP_OTA_HASH_G0(x)			(ESP_OTA_HASH_ROTR(x, 7) ^ ESP_OTA_HASH_ROTR(x, 18) ^ ((x) >> 3))
+#define ESP_OTA_HASH_G1(x)			(ESP_OTA_HASH_ROTR(x, 17) ^ ESP_OTA_HASH_ROTR(x, 19) ^ ((x) >> 10))
+#define ESP_OTA_HASH_CH(x, y, z)	((z) ^ ((x) & ((y) ^ (z))))
+#define ESP_OTA_HASH_MAJ(x, y, z)	(((x) & (y)) | ((z) & ((x) | (y))))
+
+/* message schedule in place, 16 words */
+#define ESP_OTA_HASH_W(w, i)	\
+	(w[(i) & 15] += ESP_OTA_HASH_G1(w[((i) - 2) & 15]) + w[((i) - 7) & 15] + ESP_OTA_HASH_G0(w[((i) - 15) & 15]))
+
+/* one round, the variables rotate by renaming instead of moving */
+#define ESP_OTA_HASH_ROUND(a, b, c, d, e, f, g, h, i, x)	\
+	do	\
+	{	\
+		h += ESP_OTA_HASH_S1(e) + ESP_OTA_HASH_CH(e, f, g) + esp_ota_hash_k[i] + (x);	\
+		d += h;	\
+		h += ESP_OTA_HASH_S0(a) + ESP_OTA_HASH_MAJ(a, b, c);	\
+	}while(0)
+
+static void esp_ota_hash_soft_blocks(uint32_t *state, const uint8_t *data, unsigned int count)
+{
+	uint32_t a, b, c, d, e, f, g, h;
+	uint32_t w[16];
+	unsigned int i;
+
+	for(; count; count--, data += 64)
+	{
+		for(i = 0; i < 16; i++)
+		{
+			w[i] =	((uint32_t)data[i * 4] << 24) | ((uint32_t)data[i * 4 + 1] << 16) |
+					((uint32_t)data[i * 4 + 2] << 8) | (uint32_t)data[i * 4 + 3];
+		}
+		a = state[0]; b = state[1]; c = state[2]; d = state[3];
+		e = state[4]; f = state[5]; g = state[6]; h = state[7];
+
+		for(i = 0; i < 16; i += 8)
+		{
+			ESP_OTA_HASH_ROUND(a, b, c, d, e, f, g, h, i + 0, w[i + 0]);
+			ESP_OTA_HASH_ROUND(h, a, b, c, d, e, f, g, i + 1, w[i + 1]);
+			ESP_OTA_HASH_ROUND(g, h, a, b, c, d, e, f, i + 2, w[i + 2]);
+			ESP_OTA_HASH_ROUND(f, g, h, a, b, c, d, e, i + 3, w[i + 3]);
+			ESP_OTA_HASH_ROUND(e, f, g, h, a, b, c, d, i + 4, w[i + 4]);
+			ESP_OTA_HASH_ROUND(d, e, f, g, h, a, b, c, i + 5, w[i + 5]);
+			ESP_OTA_HASH_ROUND(c, d, e, f, g, h, a, b, i + 6, w[i + 6]);
+			ESP_OTA_HASH_ROUND(b, c, d, e, f, g, h, a, i + 7, w[i + 7]);
+		}
+		for(; i < 64; i += 8)
+		{
+			ESP_OTA_HASH_ROUND(a, b, c, d, e, f, g, h, i + 0, ESP_OTA_HASH_W(w, i + 0));
+			ESP_OTA_HASH_ROUND(h, a, b, c, d, e, f, g, i + 1, ESP_OTA_HASH_W(w, i + 1));
+			ESP_OTA_HASH_ROUND(g, h, a, b, c, d, e, f, i + 2, ESP_OTA_HASH_W(w, i + 2));
+			ESP_OTA_HASH_ROUND(f, g, h, a, b, c, d, e, i + 3, ESP_OTA_HASH_W(w, i + 3));
+			ESP_OTA_HASH_ROUND(e, f, g, h, a, b, c, d, i + 4, ESP_OTA_HASH_W(w, i + 4));
+			ESP_OTA_HASH_ROUND(d, e, f, g, h, a, b, c, i + 5, ESP_OTA_HASH_W(w, i + 5));
+			ESP_OTA_HASH_ROUND(c, d, e, f, g, h, a, b, i + 6, ESP_OTA_HASH_W(w, i + 6));
+			ESP_OTA_HASH_ROUND(b, c, d, e, f, g, h, a, i + 7, ESP_OTA_HASH_W(w, i + 7));
+		}
+
+		state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+		state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+	}
+}
+
+#ifdef ESP_OTA_HASH_SHANI
+/* 4 rounds per step, the schedule is kept in 4 vectors of 4 words */
+static void esp_ota_hash_shani_blocks(uint32_t *state, const uint8_t *data, unsigned int count)
+{
+	const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+	__m128i state0, state1, abef, cdgh, msg, tmp;
+	__m128i w[4];
+	unsigned int i;
+
+	tmp = _mm_loadu_si128((const __m128i *)&state[0]);
+	state1 = _mm_loadu_si128((const __m128i *)&state[4]);
+	tmp = _mm_shuffle_epi32(tmp, 0xb1);				/* CDAB */
+	state1 = _mm_shuffle_epi32(state1, 0x1b);		/* EFGH */
+	state0 = _mm_alignr_epi8(tmp, state1, 8);		/* ABEF */
+	state1 = _mm_blend_epi16(state1, tmp, 0xf0);	/* CDGH */
+
+	for(; count; count--, data += 64)
+	{
+		abef = state0;
+		cdgh = state1;
+		for(i = 0; i < 16; i++)
+		{
+			if(i < 4)
+			{
+				w[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)&data[i * 16]), mask);
+			}
+			else
+			{
+				tmp = _mm_sha256msg1_epu32(w[i & 3], w[(i + 1) & 3]);
+				tmp = _mm_add_epi32(tmp, _mm_alignr_epi8(w[(i + 3) & 3], w[(i + 2) & 3], 4));
+				w[i & 3] = _mm_sha256msg2_epu32(tmp, w[(i + 3) & 3]);
+			}
+			msg = _mm_add_epi32(w[i & 3], _mm_loadu_si128((const __m128i *)&esp_ota_hash_k[i * 4]));
+			state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+			msg = _mm_shuffle_epi32(msg, 0x0e);
+			state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+		}
+		state0 = _mm_add_epi32(state0, abef);
+		state1 = _mm_add_epi32(state1, cdgh);
+	}
+
+	tmp = _mm_shuffle_epi32(state0, 0x1b);			/* FEBA */
+	state1 = _mm_shuffle_epi32(state1, 0xb1);		/* DCHG */
+	state0 = _mm_blend_epi16(tmp, state1, 0xf0);	/* DCBA */
+	state1 = _mm_alignr_epi8(state1, tmp, 8);		/* ABEF */
+	_mm_storeu_si128((__m128i *)&state[0], state0);
+	_mm_storeu_si128((__m128i *)&state[4], state1);
+}
+#endif
+
+static esp_err_t esp_ota_hash_ctx_init(esp_ota_hash_t *hash)
+{
+	static const uint32_t iv[8] =
+	{
+		0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+	};
+	esp_ota_hash_ctx_t *ctx = ESP_OTA_HASH_CTX(hash, esp_ota_hash_ctx_t);
+
+	memset(ctx, 0, sizeof(esp_ota_hash_ctx_t));
+	memcpy(ctx->state, iv, sizeof(iv));
+	return ESP_OK;
+}
+
+static esp_err_t esp_ota_hash_ctx_update
+	(
+		esp_ota_hash_t *hash,
+		const uint8_t *data,
+		unsigned int length,
+		esp_ota_hash_blocks_t blocks
+	)
+{
+	esp_ota_hash_ctx_t *ctx = ESP_OTA_HASH_CTX(hash, esp_ota_hash_ctx_t);
+	unsigned int used = ctx->total[0] & 0x3f;
+	unsigned int n;
+
+	ctx->total[0] += length;
+	if(ctx->total[0] < length)
+	{
+		ctx->total[1]++;
+	}
+
+	if(used)
+	{
+		n = 64 - used;
+		if(length < n)
+		{
+			memcpy(&ctx->buffer[used], data, length);
+			return ESP_OK;
+		}
+		memcpy(&ctx->buffer[used], data, n);
+		blocks(ctx->state, ctx->buffer, 1);
+		data += n;
+		length -= n;
+	}
+	/* whole blocks straight from the caller's buffer */
+	if(length >= 64)
+	{
+		blocks(ctx->state, data, length / 64);
+		data += length & ~0x3f;
+		length &= 0x3f;
+	}
+	memcpy(ctx->buffer, data, length);
+	return ESP_OK;
+}
+
+static esp_err_t esp_ota_hash_ctx_finish(esp_ota_hash_t *hash, uint8_t *sha256, esp_ota_hash_blocks_t blocks)
+{
+	esp_ota_hash_ctx_t *ctx = ESP_OTA_HASH_CTX(hash, esp_ota_hash_ctx_t);
+	unsigned int used = ctx->total[0] & 0x3f;
+	uint32_t high, low;
+	unsigned int i;
+
+	high = (ctx->total[0] >> 29) | (ctx->total[1] << 3);
+	low = ctx->total[0] << 3;
+
+	ctx->buffer[used++] = 0x80;
+	if(used > 56)
+	{
+		memset(&ctx->buffer[used], 0, 64 - used);
+		blocks(ctx->state, ctx->buffer, 1);
+		used = 0;
+	}
+	memset(&ctx->buffer[used], 0, 56 - used);
+	for(i = 0; i < 4; i++)
+	{
+		ctx->buffer[56 + i] = (uint8_t)(high >> (24 - (i * 8)));
+		ctx->buffer[60 + i] = (uint8_t)(low >> (24 - (i * 8)));
+	}
+	blocks(ctx->state, ctx->buffer, 1);
+
+	for(i = 0; i < 8; i++)
+	{
+		sha256[i * 4] = (uint8_t)(ctx->state[i] >> 24);
+		sha256[i * 4 + 1] = (uint8_t)(ctx->state[i] >> 16);
+		sha256[i * 4 + 2] = (uint8_t)(ctx->state[i] >> 8);
+		sha256[i * 4 + 3] = (uint8_t)ctx->state[i];
+	}
+	return ESP_OK;
+}
+
+static void esp_ota_hash_ctx_free(esp_ota_hash_t *hash)
+{
+	memset(hash->ctx.bytes, 0, sizeof(esp_ota_hash_ctx_t));
+}
+
+static bool esp_ota_hash_ctx_export(const esp_ota_hash_t *hash, esp_ota_hash_midstate_t *midstate)
+{
+	const esp_ota_hash_ctx_t *ctx = ESP_OTA_HASH_CTX(hash, const esp_ota_hash_ctx_t);
+
+	memcpy(midstate->total, ctx->total, sizeof(midstate->total));
+	memcpy(midstate->state, ctx->state, sizeof(midstate->state));
+	return true;
+}
+
+static bool esp_ota_hash_ctx_import(esp_ota_hash_t *hash, const esp_ota_hash_midstate_t *midstate)
+{
+	esp_ota_hash_ctx_t *ctx = ESP_OTA_HASH_CTX(hash, esp_ota_hash_ctx_t);
+
+	memcpy(ctx->total, midstate->total, sizeof(ctx->total));
+	memcpy(ctx->state, midstate->state, sizeof(ctx->state));
+	return true;
+}
+
+static esp_err_t esp_ota_hash_soft_update(esp_ota_hash_t *hash, const uint8_t *data, unsigned int length)
+{
+	return esp_ota_hash_ctx_update(hash, data, length, esp_ota_hash_soft_blocks);
+}
+
+static esp_err_t esp_ota_hash_soft_finish(esp_ota_hash_t *hash, uint8_t *sha256)
+{
+	return esp_ota_hash_ctx_finish(hash, sha256, esp_ota_hash_soft_blocks);
+}
+
+const esp_ota_hash_backend_t esp_ota_hash_soft =
+{
+	"soft",
+	esp_ota_hash_ctx_init,
+	esp_ota_hash_soft_update,
+	esp_ota_hash_soft_finish,
+	esp_ota_hash_ctx_free,
+	esp_ota_hash_ctx_export,
+	esp_ota_hash_ctx_import
+};
+
+#ifdef ESP_OTA_HASH_SHANI
+static esp_err_t esp_ota_hash_shani_update(esp_ota_hash_t *hash, const uint8_t *data, unsigned int length)
+{
+	return esp_ota_hash_ctx_update(hash, data, length, esp_ota_hash_shani_blocks);
+}
+
+static esp_err_t esp_ota_hash_shani_finish(esp_ota_hash_t *hash, uint8_t *sha256)
+{
+	return esp_ota_hash_ctx_finish(hash, sha256, esp_ota_hash_shani_blocks);
+}
+
+const esp_ota_hash_backend_t esp_ota_hash_shani =
+{
+	"sha-ni",
+	esp_ota_hash_ctx_init,
+	esp_ota_hash_shani_update,
+	esp_ota_hash_shani_finish,
+	esp_ota_hash_ctx_free,
+	esp_ota_hash_ctx_export,
+	esp_ota_hash_ctx_import
+};
+#endif
+
+const esp_ota_hash_backend_t *const esp_ota_hash_backends[] =
+{
+	&esp_ota_hash_mbedtls,
+	&esp_ota_hash_soft,
+#ifdef ESP_OTA_HASH_ESP_SHA
+	&esp_ota_hash_esp,
+#endif
+#ifdef ESP_OTA_HASH_SHANI
+	&esp_ota_hash_shani,
+#endif
+	NULL
+};
+
+/*
+ * Interface
+ */
+
+esp_err_t esp_ota_hash_init(esp_ota_hash_t *hash, const esp_ota_hash_backend_t *backend)
+{
+	hash->backend = backend ? backend : &ESP_OTA_HASH_DEFAULT;
+	return hash->backend->init(hash);
+}
+
+esp_err_t esp_ota_hash_update(esp_ota_hash_t *hash, const void *data, unsigned int length)
+{
+	return hash->backend->update(hash, (const uint8_t *)data, length);
+}
+
+esp_err_t esp_ota_hash_finish(esp_ota_hash_t *hash, uint8_t *sha256)
+{
+	return hash->backend->finish(hash, sha256);
+}
+
+void esp_ota_hash_free(esp_ota_hash_t *hash)
+{
+	if(hash->backend)
+	{
+		hash->backend->free(hash);
+	}
+}
+
+bool esp_ota_hash_export(const esp_ota_hash_t *hash, esp_ota_hash_midstate_t *midstate)
+{
+	if(!hash->backend->export_state || !hash->backend->export_state(hash, midstate))
+	{
+		return false;
+	}
+	return !(midstate->total[0] & 0x3f);
+}
+
+bool esp_ota_hash_import(esp_ota_hash_t *hash, const esp_ota_hash_midstate_t *midstate)
+{
+	if(!hash->backend->import_state || (midstate->total[0] & 0x3f))
+	{
+		return false;
+	}
+	return hash->backend->import_state(hash, midstate);
+}
+
+esp_err_t esp_ota_hash_sha256
+	(
+		const esp_ota_hash_backend_t *backend,
+		const void *data,
+		unsigned int length,
+		uint8_t *sha256
+	)
+{
+	esp_ota_hash_t hash;
+	esp_err_t err;
+
+	err = esp_ota_hash_init(&hash, backend);
+	if(err == ESP_OK)
+	{
+		err = esp_ota_hash_update(&hash, data, length);
+	}
+	if(err == ESP_OK)
+	{
+		err = esp_ota_hash_finish(&hash, sha256);
+	}
+	esp_ota_hash_free(&hash);
+	return err;
+}
+
+#ifdef ESP_OTA_HASH_BENCHMARK
+void esp_ota_hash_benchmark(uint32_t total)
+{
+	static const unsigned int sizes[] = { 64, 256, 1024, 4096, 16384 };
+	const esp_ota_hash_backend_t *const *backend;
+	esp_ota_hash_t hash;
+	uint8_t sha256[ESP_OTA_HASH_SIZE];
+	uint8_t *buffer;
+	uint32_t done, t;
+	unsigned int i;
+
+	buffer = (uint8_t *)ESP_OTA_MALLOC(sizes[(sizeof(sizes) / sizeof(sizes[0])) - 1]);
+	if(!buffer)
+	{
+		return;
+	}
+	memset(buffer, 0xa5, sizes[(sizeof(sizes) / sizeof(sizes[0])) - 1]);
+
+	printf("%-8s", "KB/s");
+	for(i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+	{
+		printf(" %8u", sizes[i]);
+	}
+	printf("\r\n");
+	for(backend = esp_ota_hash_backends; *backend; backend++)
+	{
+		printf("%-8s", (*backend)->name);
+		for(i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+		{
+			t = ESP_OTA_TIME_US();
+			esp_ota_hash_init(&hash, *backend);
+			for(done = 0; done < total; done += sizes[i])
+			{
+				esp_ota_hash_update(&hash, buffer, sizes[i]);
+			}
+			esp_ota_hash_finish(&hash, sha256);
+			esp_ota_hash_free(&hash);
+			t = ESP_OTA_TIME_US() - t;
+			printf(" %8u", t ? (uint32_t)(((uint64_t)done * 1000000) / 1024 / t) : 0);
+		}
+		printf("\r\n");
+	}
+	ESP_OTA_FREE(buffer);
+}
+#endif
+
+/*
+ * EOF
+ */
@@ -0,0 +1,175 @@
+/*****************************************************************************
+* File Name: esp_ota_hash.h
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+
+/*******************************************************************************
+* User defined Macros
+*******************************************************************************/
+
+#ifndef ESP_OTA_HASH_H
+#define ESP_OTA_HASH_H
+
+/*
+ * SHA-256 behind a small interface, so the streaming hash of an upgrade
+ * can run on mbedTLS, the SDK (hardware where the chip has one) or the
+ * built-in software implementation, and on SHA-NI in host tooling.
+ */
+
+#define ESP_OTA_HASH_SIZE	(32)
+
+/* backend context, large enough for all of them */
+#ifndef ESP_OTA_HASH_CTX_SIZE
+#define ESP_OTA_HASH_CTX_SIZE	(128)
+#endif
+
+/* midstate on a 64 bytes boundary, the hash can continue from it */
+typedef struct
+{
+	uint32_t total[2];	/* bytes hashed */
+	uint32_t state[8];
+}esp_ota_hash_midstate_t;
+
+typedef struct esp_ota_hash esp_ota_hash_t;
+
+typedef struct
+{
+	const char *name;
+	esp_err_t (*init)(esp_ota_hash_t *hash);
+	esp_err_t (*update)(esp_ota_hash_t *hash, const uint8_t *data, unsigned int length);
+	esp_err_t (*finish)(esp_ota_hash_t *hash, uint8_t *sha256);
+	void (*free)(esp_ota_hash_t *hash);
+
+	/* NULL: the midstate is not accessible */
+	bool (*export_state)(const esp_ota_hash_t *hash, esp_ota_hash_midstate_t *midstate);
+	bool (*import_state)(esp_ota_hash_t *hash, const esp_ota_hash_midstate_t *midstate);
+}esp_ota_hash_backend_t;
+
+struct esp_ota_hash
+{
+	const esp_ota_hash_backend_t *backend;
+	union
+	{
+		uint64_t align;
+		uint8_t bytes[ESP_OTA_HASH_CTX_SIZE];
+	}ctx;
+};
+
+extern const esp_ota_hash_backend_t esp_ota_hash_mbedtls;
+extern const esp_ota_hash_backend_t esp_ota_hash_soft;	/* unrolled C */
+
+#ifdef ESP_OTA_HASH_ESP_SHA
+extern const esp_ota_hash_backend_t esp_ota_hash_esp;	/* esp_sha.h of the SDK */
+#endif
+
+#if defined(__SHA__) && defined(__SSE4_1__)
+#define ESP_OTA_HASH_SHANI
+extern const esp_ota_hash_backend_t esp_ota_hash_shani;	/* x86 SHA extensions, host builds */
+#endif
+
+#ifndef ESP_OTA_HASH_DEFAULT
+#define ESP_OTA_HASH_DEFAULT	esp_ota_hash_mbedtls
+#endif
+
+/* backends compiled in, NULL terminated */
+extern const esp_ota_hash_backend_t *const esp_ota_hash_backends[];
+
+/** @brief esp_ota_hash_init
+ *
+ *
+ * @param backend  NULL: ESP_OTA_HASH_DEFAULT
+ */
+esp_err_t esp_ota_hash_init(esp_ota_hash_t *hash, const esp_ota_hash_backend_t *backend);
+
+esp_err_t esp_ota_hash_update(esp_ota_hash_t *hash, const void *data, unsigned int length);
+
+esp_err_t esp_ota_hash_finish(esp_ota_hash_t *hash, uint8_t *sha256);
+
+void esp_ota_hash_free(esp_ota_hash_t *hash);
+
+/** @brief esp_ota_hash_export
+ *
+ *
+ * @return  false: not on a 64 bytes boundary, or not supported by the backend
+ */
+bool esp_ota_hash_export(const esp_ota_hash_t *hash, esp_ota_hash_midstate_t *midstate);
+
+/** @brief esp_ota_hash_import
+ *
+ * Continue the hash of an initialized context from a midstate.
+ */
+bool esp_ota_hash_import(esp_ota_hash_t *hash, const esp_ota_hash_midstate_t *midstate);
+
+/** @brief esp_ota_hash_sha256
+ *
+ * One-shot SHA-256 of data.
+ *
+ * @param backend  NULL: ESP_OTA_HASH_DEFAULT
+ */
+esp_err_t esp_ota_hash_sha256
+	(
+		const esp_ota_hash_backend_t *backend,
+		const void *data,
+		unsigned int length,
+		uint8_t *sha256
+	);
+
+#ifdef ESP_OTA_HASH_BENCHMARK
+/** @brief esp_ota_hash_benchmark
+ *
+ * Hash total bytes with every backend in updates of 64 bytes to 16K and
+ * print the throughput (printf).
+ */
+void esp_ota_hash_benchmark(uint32_t total);
+#endif
+
+#endif
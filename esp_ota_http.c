@@ -49,20 +49,21 @@
 *****************************************************************************/
 
 #include <stdint.h>
+#include <stdio.h>
 #include <string.h>
-
-#if !defined(MBEDTLS_CONFIG_FILE)
-#include "mbedtls/config.h"
-#else
-#include MBEDTLS_CONFIG_FILE
-#endif
-#include "mbedtls/sha256.h"
+#include <stdlib.h>
 
 #include "esp_libc.h"
 
 #include "esp_system.h"
 #include "esp_log.h"
 
+#include "esp_timer.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
 #include "esp_partition.h"
 #include "nvs.h"
 #include "nvs_flash.h"
@@ -76,8 +77,14 @@
 #include "json_jsmn.h"
 #include "jsondoc/jsondoc.h"
 
+#include "esp_ota_port.h"
+#include "esp_ota_hash.h"
 #include "esp_ota_nvs.h"
 #include "esp_ota_desc.h"
+#include "esp_ota_flash.h"
+#include "esp_ota_ring.h"
+#include "esp_ota_codec.h"
+#include "esp_ota_patch.h"
 #include "esp_ota_http.h"
 
 #ifdef ESP_OTA_DEBUG_ENABLED
@@ -89,49 +96,266 @@
 #define debugPrintln(...)
 #endif
 
-#ifndef ESP_OTA_HTTP_UPGRADE_BUF_SIZE
-#define ESP_OTA_HTTP_UPGRADE_BUF_SIZE (130)
+#ifndef ESP_OTA_HTTP_DESC_READ_SIZE
+#define ESP_OTA_HTTP_DESC_READ_SIZE (128)
 #endif
 
-#ifndef ESP_OTA_MALLOC
-#define ESP_OTA_MALLOC	os_malloc
+#ifndef ESP_OTA_HTTP_PIPELINE_BUF_SIZE
+#define ESP_OTA_HTTP_PIPELINE_BUF_SIZE (1024)
 #endif
 
-#ifndef ESP_OTA_FREE
-#define ESP_OTA_FREE	os_free
+#ifndef ESP_OTA_HTTP_READER_STACK_SIZE
+#define ESP_OTA_HTTP_READER_STACK_SIZE (4096)
 #endif
 
-#ifndef ESP_OTA_REALLOC
-#define ESP_OTA_REALLOC	os_realloc
+#ifndef ESP_OTA_HTTP_READER_PRIORITY
+#define ESP_OTA_HTTP_READER_PRIORITY (5)
 #endif
 
-/* Function realloc_safe() is a wrapper function for standart realloc()
- * with one difference - it frees old memory pointer in case of realloc
- * failure. Thus, DO NOT use old data pointer in anyway after call to
- * realloc_safe(). If your code has some kind of fallback algorithm if
- * memory can't be re-allocated - use standart realloc() instead.
- */
-static inline void *realloc_safe(void *ptrmem, size_t size)
+#ifndef ESP_OTA_HTTP_CODEC_READ_SIZE
+#define ESP_OTA_HTTP_CODEC_READ_SIZE (256)
+#endif
+
+#ifndef ESP_OTA_HTTP_SYNC_READ_SIZE
+#define ESP_OTA_HTTP_SYNC_READ_SIZE (256)
+#endif
+
+#ifndef ESP_OTA_HTTP_BLOCK_RETRIES
+#define ESP_OTA_HTTP_BLOCK_RETRIES (3)
+#endif
+
+#ifndef ESP_OTA_HTTP_VERIFY_BLOCK_MAX
+#define ESP_OTA_HTTP_VERIFY_BLOCK_MAX (16384)
+#endif
+
+#ifndef ESP_OTA_HTTP_MIRROR_RANGE_SIZE
+#define ESP_OTA_HTTP_MIRROR_RANGE_SIZE (32768)
+#endif
+
+#ifndef ESP_OTA_HTTP_MIRROR_STACK_SIZE
+#define ESP_OTA_HTTP_MIRROR_STACK_SIZE (4096)
+#endif
+
+#ifndef ESP_OTA_HTTP_MIRROR_ERRORS
+#define ESP_OTA_HTTP_MIRROR_ERRORS (3)
+#endif
+
+#ifndef ESP_OTA_HTTP_MIRROR_WAIT_MS
+#define ESP_OTA_HTTP_MIRROR_WAIT_MS (100)
+#endif
+
+#ifndef ESP_OTA_HTTP_HOST_LENGTH
+#define ESP_OTA_HTTP_HOST_LENGTH (64)
+#endif
+
+#ifndef ESP_OTA_HTTP_URL_LENGTH
+#define ESP_OTA_HTTP_URL_LENGTH (256)
+#endif
+
+#ifndef ESP_OTA_HTTP_MANIFEST_SIZE
+#define ESP_OTA_HTTP_MANIFEST_SIZE (2048)
+#endif
+
+/* internal: the range of a resume is refused, the image is requested again */
+#define ESP_OTA_HTTP_RESUME_REFUSED	(ESP_ERR_OTA_BASE + 0x8F)
+
+struct esp_ota_http_session
+{
+	esp_http_client_handle_t client;
+	char host[ESP_OTA_HTTP_HOST_LENGTH];
+	bool connected;
+	esp_ota_http_session_stats_t stats;
+
+	/* the application's event handler, response headers are seen first */
+	http_event_handle_cb event_handler;
+	void *user_data;
+
+	/* validators of the last response, url of the next request */
+	char etag[ESP_OTA_NVS_ETAG_LENGTH];
+	char last_modified[ESP_OTA_NVS_DATE_LENGTH];
+	uint8_t url_sha256[32];
+
+	/* descriptor format by the url extension, then by the Content-Type */
+	esp_ota_desc_format_t url_format;
+	esp_ota_desc_format_t desc_format;
+
+	/* current descriptor/upgrade attempt */
+	esp_ota_http_stats_t attempt;
+	uint32_t attempt_time;
+	esp_ota_port_alloc_stats_t attempt_alloc;
+};
+
+static esp_ota_http_stats_t esp_ota_http_last_stats;
+
+static inline void esp_ota_http_stage(esp_ota_http_stage_stats_t *stage, uint32_t t)
+{
+	t = ESP_OTA_TIME_US() - t;
+	stage->count++;
+	stage->time_us += t;
+	if(t > stage->max_us)
+	{
+		stage->max_us = t;
+	}
+}
+
+static inline void esp_ota_http_heap(esp_ota_http_stats_t *stats)
+{
+	uint32_t heap = esp_get_free_heap_size();
+
+	if(heap < stats->free_heap_min)
+	{
+		stats->free_heap_min = heap;
+	}
+}
+
+/* esp_http_client_read() with timing and size histogram */
+static int esp_ota_http_read
+	(
+		esp_http_client_handle_t client,
+		char *buffer,
+		int length,
+		esp_ota_http_stats_t *stats
+	)
+{
+	uint32_t t = ESP_OTA_TIME_US();
+	unsigned int bucket;
+	int read_length;
+
+	read_length = esp_http_client_read(client, buffer, length);
+	esp_ota_http_stage(&stats->read, t);
+	if(read_length > 0)
+	{
+		stats->read_bytes += read_length;
+		for(bucket = 0; bucket < (ESP_OTA_HTTP_STATS_READ_BUCKETS - 1) && read_length >= (64 << (bucket * 2)); bucket++);
+		stats->read_histogram[bucket]++;
+	}
+	return read_length;
+}
+
+static void esp_ota_http_attempt_begin(esp_ota_http_session_handle_t session)
+{
+	memset(&session->attempt, 0, sizeof(esp_ota_http_stats_t));
+	session->attempt.free_heap_min = esp_get_free_heap_size();
+	session->attempt_time = ESP_OTA_TIME_US();
+	esp_ota_port_alloc_reset_peak();
+	esp_ota_port_get_alloc_stats(&session->attempt_alloc);
+}
+
+static void esp_ota_http_attempt_end(esp_ota_http_session_handle_t session, esp_err_t err)
+{
+	esp_ota_port_alloc_stats_t alloc;
+
+	session->attempt.err = err;
+	session->attempt.total_us = ESP_OTA_TIME_US() - session->attempt_time;
+	esp_ota_http_heap(&session->attempt);
+	if(esp_ota_port_get_alloc_stats(&alloc))
+	{
+		session->attempt.alloc_count = alloc.count - session->attempt_alloc.count;
+		session->attempt.alloc_peak = alloc.peak - session->attempt_alloc.current;
+	}
+	memcpy(&esp_ota_http_last_stats, &session->attempt, sizeof(esp_ota_http_stats_t));
+}
+
+void esp_ota_http_get_stats(esp_ota_http_stats_t *stats)
+{
+	memcpy(stats, &esp_ota_http_last_stats, sizeof(esp_ota_http_stats_t));
+}
+
+/* host part of the url, esp_http_client drops the connection when it changes */
+static void esp_ota_http_url_host(const char *url, char *host, unsigned int size)
+{
+	const char *p;
+	unsigned int i;
+
+	p = url ? strstr(url, "://") : NULL;
+	p = p ? p + 3 : (url ? url : "");
+	for(i = 0; (i + 1) < size && p[i] && p[i] != '/'; i++)
+	{
+		host[i] = p[i];
+	}
+	host[i] = '\0';
+}
+
+/* url relative to base ("/path": same host, "name": same directory), absolute ones as they are */
+static esp_err_t esp_ota_http_url_resolve(const char *base, const char *url, char *out, unsigned int size)
+{
+	const char *p;
+	unsigned int length;
+
+	length = 0;
+	if(base && !strstr(url, "://"))
+	{
+		if(url[0] == '/')
+		{
+			p = strstr(base, "://");
+			p = p ? p + 3 : base;
+			length = (p - base) + strcspn(p, "/?#");
+		}
+		else
+		{
+			for(length = strcspn(base, "?#"); length && base[length - 1] != '/'; length--);
+		}
+	}
+	if(length + strlen(url) >= size)
+	{
+		return ESP_ERR_INVALID_SIZE;
+	}
+	memcpy(out, base, length);
+	strcpy(&out[length], url);
+	return ESP_OK;
+}
+
+static void esp_ota_http_header_copy(char *dst, unsigned int size, const char *value)
+{
+	/* a truncated validator would never match, keep none */
+	if(!value || strlen(value) >= size)
+	{
+		dst[0] = '\0';
+		return;
+	}
+	strcpy(dst, value);
+}
+
+static esp_err_t esp_ota_http_session_event(esp_http_client_event_t *evt)
 {
-	void *p;
+	esp_ota_http_session_handle_t session = (esp_ota_http_session_handle_t)evt->user_data;
 
-//	debugPrintln("free heap size is %d", system_get_free_heap_size());
-	p = (void *)ESP_OTA_REALLOC(ptrmem, size);
-	if (!p)
+	if(evt->event_id == HTTP_EVENT_ON_HEADER && evt->header_key)
+	{
+		if(!strcasecmp(evt->header_key, "ETag"))
+		{
+			esp_ota_http_header_copy(session->etag, sizeof(session->etag), evt->header_value);
+		}
+		else if(!strcasecmp(evt->header_key, "Last-Modified"))
+		{
+			esp_ota_http_header_copy(session->last_modified, sizeof(session->last_modified), evt->header_value);
+		}
+		else if(!strcasecmp(evt->header_key, "Retry-After") && evt->header_value &&
+			evt->header_value[0] >= '0' && evt->header_value[0] <= '9')
+		{
+			session->attempt.retry_after = strtoul(evt->header_value, NULL, 10);
+		}
+		else if(!strcasecmp(evt->header_key, "Content-Type"))
+		{
+			session->desc_format = esp_ota_desc_format(evt->header_value, session->url_format);
+		}
+	}
+	if(!session->event_handler)
 	{
-		ESP_OTA_FREE (ptrmem);
+		return ESP_OK;
 	}
-	return p;
+	evt->user_data = session->user_data;
+	return session->event_handler(evt);
 }
 
-static esp_err_t esp_ota_http_client_open
+esp_err_t esp_ota_http_session_open
 (
 	const esp_http_client_config_t *config,
-	esp_http_client_handle_t *out
+	esp_ota_http_session_handle_t *out
 )
 {
-	esp_err_t err;
-	esp_http_client_handle_t client;
+	esp_ota_http_session_handle_t session;
+	esp_http_client_config_t client_config;
 
 	if (!config)
 	{
@@ -145,197 +369,450 @@ static esp_err_t esp_ota_http_client_open
 		return ESP_FAIL;
 	}
 
-	client = esp_http_client_init(config);
-	if (client == NULL)
+	session = (esp_ota_http_session_handle_t)ESP_OTA_MALLOC(sizeof(struct esp_ota_http_session));
+	if(!session)
+	{
+		return ESP_ERR_NO_MEM;
+	}
+	memset(session, 0, sizeof(struct esp_ota_http_session));
+	session->event_handler = config->event_handler;
+	session->user_data = config->user_data;
+
+	memcpy(&client_config, config, sizeof(esp_http_client_config_t));
+	client_config.event_handler = esp_ota_http_session_event;
+	client_config.user_data = session;
+	session->client = esp_http_client_init(&client_config);
+	if (session->client == NULL)
 	{
 		debugPrintln("Failed to initialize HTTP connection");
+		ESP_OTA_FREE(session);
 		return ESP_FAIL;
 	}
 
-	if (esp_http_client_get_transport_type(client) != HTTP_TRANSPORT_OVER_SSL)
+	if (esp_http_client_get_transport_type(session->client) != HTTP_TRANSPORT_OVER_SSL)
 	{
 		debugPrintln("Transport is not over HTTPS");
+		esp_http_client_cleanup(session->client);
+		ESP_OTA_FREE(session);
 		return ESP_FAIL;
 	}
-	err = esp_http_client_open(client, 0);
-	if (err != ESP_OK)
+	esp_ota_http_url_host(config->url, session->host, sizeof(session->host));
+	esp_ota_hash_sha256(NULL, config->url ? config->url : "", config->url ? strlen(config->url) : 0, session->url_sha256);
+	session->url_format = esp_ota_desc_url_format(config->url);
+	*out = session;
+	return ESP_OK;
+}
+
+/* send a request, the connection is reused when the server kept it open */
+static esp_err_t esp_ota_http_session_request
+(
+	esp_ota_http_session_handle_t session,
+	const char *url,
+	uint32_t range_start,
+	uint32_t range_end
+)
+{
+	esp_err_t err;
+	char range[32];
+	char host[ESP_OTA_HTTP_HOST_LENGTH];
+	uint32_t t;
+	int retry;
+
+	if(url)
 	{
-		esp_http_client_cleanup(client);
-		debugPrintln("Failed to open HTTP connection: %d", err);
-		return err;
+		esp_ota_http_url_host(url, host, sizeof(host));
+		if(strcmp(host, session->host))
+		{
+			session->connected = false;
+			strcpy(session->host, host);
+		}
+		esp_http_client_set_url(session->client, url);
+		esp_ota_hash_sha256(NULL, url, strlen(url), session->url_sha256);
+		session->url_format = esp_ota_desc_url_format(url);
+	}
+	session->etag[0] = '\0';
+	session->last_modified[0] = '\0';
+	session->desc_format = session->url_format;
+
+	if (range_end)
+	{
+		/* range_end is exclusive, the header is inclusive */
+		snprintf(range, sizeof(range), "bytes=%u-%u", range_start, range_end - 1);
+		esp_http_client_set_header(session->client, "Range", range);
+	}
+	else if (range_start)
+	{
+		snprintf(range, sizeof(range), "bytes=%u-", range_start);
+		esp_http_client_set_header(session->client, "Range", range);
 	}
-	*out = client;
+	else
+	{
+		esp_http_client_delete_header(session->client, "Range");
+	}
+
+	for(retry = 0;; retry++)
+	{
+		t = ESP_OTA_TIME_US();
+		err = esp_http_client_open(session->client, 0);
+		esp_ota_http_stage(&session->attempt.connect, t);
+		if (err == ESP_OK)
+		{
+			break;
+		}
+		esp_http_client_close(session->client);
+		if (!session->connected || retry)
+		{
+			session->connected = false;
+			debugPrintln("Failed to open HTTP connection: %d", err);
+			return err;
+		}
+		/* the server closed the kept-alive connection */
+		debugPrintln("connection is closed by server, reconnect");
+		session->connected = false;
+		session->attempt.reconnect_count++;
+	}
+
+	if(!session->connected)
+	{
+		session->stats.handshake_count++;
+		session->stats.handshake_time_us += ESP_OTA_TIME_US() - t;
+		session->attempt.handshake_count++;
+		session->connected = true;
+	}
+	session->stats.request_count++;
+	session->attempt.request_count++;
+	esp_ota_http_heap(&session->attempt);
+	return ESP_OK;
+}
+
+/* end of a response, the connection can't be reused if the body is not read */
+static void esp_ota_http_session_finish(esp_ota_http_session_handle_t session)
+{
+	if(!esp_http_client_is_complete_data_received(session->client))
+	{
+		esp_http_client_close(session->client);
+		session->connected = false;
+	}
+}
+
+void esp_ota_http_session_get_stats
+(
+	esp_ota_http_session_handle_t session,
+	esp_ota_http_session_stats_t *stats
+)
+{
+	memcpy(stats, &session->stats, sizeof(esp_ota_http_session_stats_t));
+}
+
+esp_err_t esp_ota_http_session_close(esp_ota_http_session_handle_t session)
+{
+	if(!session)
+	{
+		return ESP_ERR_INVALID_ARG;
+	}
+	debugPrintln
+		(
+			"session: %u requests, %u handshakes in %u us",
+			session->stats.request_count,
+			session->stats.handshake_count,
+			session->stats.handshake_time_us
+		);
+	esp_http_client_close(session->client);
+	esp_http_client_cleanup(session->client);
+	ESP_OTA_FREE(session);
 	return ESP_OK;
 }
 
-static void esp_ota_http_client_cleanup(esp_http_client_handle_t client)
+static int esp_ota_http_fetch_headers(esp_http_client_handle_t client, esp_ota_http_stats_t *stats)
 {
-	esp_http_client_close(client);
-	esp_http_client_cleanup(client);
+	uint32_t t = ESP_OTA_TIME_US();
+	int err;
+
+	err = esp_http_client_fetch_headers(client);
+	esp_ota_http_stage(&stats->headers, t);
+	return err;
 }
 
+/*
+ * body (ESP_OTA_NVS_DESC_CACHE_SIZE bytes, NULL: not kept) gets a copy of
+ * the descriptor, body_length is 0 when it didn't fit. modified is NULL for
+ * an unconditional request, false is a 304 response without a body.
+ */
 static esp_err_t esp_ota_http_get_desc_internal
 	(
-		esp_http_client_handle_t client,
-		char *upgrade_data_buf,
-		unsigned int *buffer_length
+		esp_ota_http_session_handle_t session,
+		esp_ota_desc_t *desc,
+		char *body,
+		unsigned int *body_length,
+		bool *modified
 	)
 {
+	esp_http_client_handle_t client = session->client;
+	esp_ota_http_stats_t *stats = &session->attempt;
 	esp_err_t err;
-	int total_length, read_length, length;
+	int total_length, read_length;
+	esp_ota_desc_parser_t parser;
+	char buffer[ESP_OTA_HTTP_DESC_READ_SIZE];
 
-	if((*buffer_length) < 2)
+	err = esp_ota_http_fetch_headers(client, stats);
+	if(err < 0)
 	{
-		return ESP_ERR_NO_MEM;
+		debugPrintln("http fetch header failed: %d", err);
+		return err;
 	}
-
-	err = esp_http_client_fetch_headers(client);
-#if 1
-	if(err == 0)
+	else if(esp_http_client_is_chunked_response(client))
 	{
 		debugPrintln("http header is chunked");
-		return ESP_FAIL;
 	}
-	else if(err > 0)
+	else
 	{
 		debugPrintln("http fetch header length: %d", err);
 	}
-	else
+
+	if(modified)
 	{
-		debugPrintln("http fetch header failed: %d", err);
-		return err;
+		*modified = (esp_http_client_get_status_code(client) != 304);
+		if(!*modified)
+		{
+			debugPrintln("descriptor is not modified");
+			return ESP_OK;
+		}
 	}
-#else
-	debugPrintln("http fetch header: %s(%d)", err > 0 ? "success":"fail", err);
-#endif
 
-	for (
-			total_length=0, length=*buffer_length;
-			length > 1;
-		)
+	/* parse the body piece by piece, until the connection/last chunk ends */
+	esp_ota_desc_parser_init_format(&parser, desc, session->desc_format);
+	for (total_length=0;;)
 	{
-		read_length = esp_http_client_read
+		read_length = esp_ota_http_read
 				(
 					client,
-					&upgrade_data_buf[total_length],
-					length
+					buffer,
+					sizeof(buffer),
+					stats
 				);
 		if (read_length == 0)
 		{
 			debugPrintln("Connection closed, all data received: %u(bytes)", total_length);
-			debugPrintln
-				(
-					"content[%u]: %.*s",
-					total_length,
-					total_length,
-					upgrade_data_buf
-				);
-			*buffer_length = total_length;
-			return ESP_OK;
+			break;
 		}
 		else if (read_length < 0)
 		{
 			debugPrintln("Error: SSL data read error");
+			esp_ota_desc_free(desc);
 			return read_length;
 		}
-		else if (read_length > 0)
+		if(body && (total_length + read_length) <= ESP_OTA_NVS_DESC_CACHE_SIZE)
 		{
-			if((total_length + read_length) < length)
-			{
-				total_length += read_length;
-				length -= read_length;
-				upgrade_data_buf[total_length] = '\0';
-				debugPrintln("http data total length: %d", read_length);
-			}
-			else
-			{
-				// truncated
-				total_length += length;
-				length = 0;
-				upgrade_data_buf[total_length] = '\0';
-				debugPrintln("http data is truncated: %u", total_length);
-				debugPrintln("truncated content: %.*s", total_length, upgrade_data_buf);
-				break;
-			}
+			memcpy(&body[total_length], buffer, read_length);
+		}
+		total_length += read_length;
+		if(esp_ota_desc_parser_feed(&parser, buffer, read_length))
+		{
+			debugPrintln("descriptor syntax error at %u(bytes)", total_length);
+			esp_ota_desc_free(desc);
+			return ESP_FAIL;
 		}
 	}
-	return ESP_ERR_NO_MEM;
+
+	if(esp_ota_desc_parser_finish(&parser))
+	{
+		esp_ota_desc_free(desc);
+		return ESP_FAIL;
+	}
+	debugPrintln("ota version: %u.%u", desc->version.major, desc->version.minor);
+	if(body_length)
+	{
+		*body_length = (total_length <= ESP_OTA_NVS_DESC_CACHE_SIZE) ? total_length : 0;
+	}
+	return ESP_OK;
+}
+
+esp_err_t esp_ota_http_session_get_desc
+(
+	esp_ota_http_session_handle_t session,
+	const char *url,
+	esp_ota_desc_t *desc
+)
+{
+	esp_err_t err;
+
+	esp_ota_http_attempt_begin(session);
+	err = esp_ota_http_session_request(session, url, 0, 0);
+	if(ESP_OK == err)
+	{
+		err = esp_ota_http_get_desc_internal(session, desc, NULL, NULL, NULL);
+		esp_ota_http_session_finish(session);
+	}
+	esp_ota_http_attempt_end(session, err);
+	return err;
 }
 
 esp_err_t esp_ota_http_get_desc(const esp_http_client_config_t *config, esp_ota_desc_t *desc)
 {
-	esp_http_client_handle_t client;
+	esp_ota_http_session_handle_t session;
 	esp_err_t err;
-	char *upgrade_data_buf;
-	unsigned int buffer_size, allocated_size;
 
-	err = esp_ota_http_client_open(config, &client);
+	err = esp_ota_http_session_open(config, &session);
 	if(ESP_OK != err)
 	{
 		return err;
 	}
+	err = esp_ota_http_session_get_desc(session, NULL, desc);
+	esp_ota_http_session_close(session);
+	return err;
+}
 
-	buffer_size = allocated_size = ESP_OTA_HTTP_UPGRADE_BUF_SIZE;
-	upgrade_data_buf = (char *)ESP_OTA_MALLOC(buffer_size);
-	assert(upgrade_data_buf);
+esp_err_t esp_ota_http_session_poll_desc
+(
+	esp_ota_http_session_handle_t session,
+	const char *url,
+	esp_ota_desc_t *desc,
+	bool *changed
+)
+{
+	esp_ota_nvs_desc_cache_t cache;
+	uint8_t url_sha256[32];
+	unsigned int body_length = 0;
+	char *body;
+	bool modified = true;
+	esp_err_t err;
 
-	while(1)
+	body = (char *)ESP_OTA_MALLOC(ESP_OTA_NVS_DESC_CACHE_SIZE);
+	if(!body)
 	{
-		buffer_size = allocated_size;
-		err = esp_ota_http_get_desc_internal
-		(
-			client,
-			upgrade_data_buf,
-			&buffer_size
-		);
-		esp_ota_http_client_cleanup(client);
+		return ESP_ERR_NO_MEM;
+	}
 
-		if(ESP_OK  == err)
-		{
-			if(esp_ota_desc_parse_json
-				(
-					upgrade_data_buf,
-					buffer_size,
-					desc
-				))
-			{
-				err = ESP_FAIL;
-				break;
-			}
+	if(url)
+	{
+		esp_ota_hash_sha256(NULL, url, strlen(url), url_sha256);
+	}
+	else
+	{
+		memcpy(url_sha256, session->url_sha256, sizeof(url_sha256));
+	}
 
-			debugPrintln("ota version: %u.%u", desc->version.major, desc->version.minor);
-			break;
+	/* validators are only sent for the url they came from */
+	if(ESP_OK == esp_ota_nvs_desc_cache_get(&cache, NULL) &&
+		!memcmp(cache.url_sha256, url_sha256, sizeof(url_sha256)))
+	{
+		if(cache.etag[0])
+		{
+			esp_http_client_set_header(session->client, "If-None-Match", cache.etag);
 		}
-		else if(ESP_ERR_NO_MEM == err)
+		if(cache.last_modified[0])
 		{
-			err = esp_ota_http_client_open(config, &client);
-			if(ESP_OK != err)
-			{
-				break;
-			}
+			esp_http_client_set_header(session->client, "If-Modified-Since", cache.last_modified);
+		}
+	}
+
+	esp_ota_http_attempt_begin(session);
+	err = esp_ota_http_session_request(session, url, 0, 0);
+	if(ESP_OK == err)
+	{
+		err = esp_ota_http_get_desc_internal
+			(
+				session,
+				desc,
+				body,
+				&body_length,
+				&modified
+			);
+		esp_ota_http_session_finish(session);
+	}
+	esp_ota_http_attempt_end(session, err);
+	esp_http_client_delete_header(session->client, "If-None-Match");
+	esp_http_client_delete_header(session->client, "If-Modified-Since");
 
-			allocated_size = (allocated_size * 4)/3;
-			upgrade_data_buf = realloc_safe(upgrade_data_buf, sizeof(char) * allocated_size);
-			assert(upgrade_data_buf);
+	if(ESP_OK == err && modified)
+	{
+		if(session->etag[0] || session->last_modified[0])
+		{
+			memset(&cache, 0, sizeof(esp_ota_nvs_desc_cache_t));
+			memcpy(cache.url_sha256, url_sha256, sizeof(cache.url_sha256));
+			strcpy(cache.etag, session->etag);
+			strcpy(cache.last_modified, session->last_modified);
+			cache.length = body_length;
+			esp_ota_nvs_desc_cache_set(&cache, body);
 		}
 		else
 		{
-			break;
+			/* nothing to send next time */
+			esp_ota_nvs_desc_cache_clear();
 		}
 	}
-	ESP_OTA_FREE(upgrade_data_buf);
+	ESP_OTA_FREE(body);
+	*changed = modified;
 	return err;
 }
 
-static int binary2hex
+esp_err_t esp_ota_http_poll_desc
 	(
-		unsigned char *buffer,
-		int length,
-		char *hex_buffer,
-		int hex_buffer_length
+		const esp_http_client_config_t *config,
+		esp_ota_desc_t *desc,
+		bool *changed
 	)
 {
-	int i;
+	esp_ota_http_session_handle_t session;
+	esp_err_t err;
+
+	err = esp_ota_http_session_open(config, &session);
+	if(ESP_OK != err)
+	{
+		return err;
+	}
+	err = esp_ota_http_session_poll_desc(session, NULL, desc, changed);
+	esp_ota_http_session_close(session);
+	return err;
+}
+
+esp_err_t esp_ota_http_desc_cache_load(esp_ota_desc_t *desc)
+{
+	esp_ota_nvs_desc_cache_t cache;
+	esp_ota_desc_parser_t parser;
+	char *body;
+	esp_err_t err;
+
+	body = (char *)ESP_OTA_MALLOC(ESP_OTA_NVS_DESC_CACHE_SIZE);
+	if(!body)
+	{
+		return ESP_ERR_NO_MEM;
+	}
+	err = esp_ota_nvs_desc_cache_get(&cache, body);
+	if(ESP_OK == err && !cache.length)
+	{
+		err = ESP_ERR_NOT_FOUND;
+	}
+	if(ESP_OK == err)
+	{
+		/* the Content-Type is not cached, a binary body starts with its magic */
+		esp_ota_desc_parser_init_format
+			(
+				&parser,
+				desc,
+				(cache.length >= 4 && !memcmp(body, ESP_OTA_DESC_BIN_MAGIC, 4)) ?
+					ESP_OTA_DESC_FORMAT_BIN : ESP_OTA_DESC_FORMAT_JSON
+			);
+		if(esp_ota_desc_parser_feed(&parser, body, cache.length) ||
+			esp_ota_desc_parser_finish(&parser))
+		{
+			esp_ota_desc_free(desc);
+			err = ESP_FAIL;
+		}
+	}
+	ESP_OTA_FREE(body);
+	return err;
+}
+
+static int binary2hex
+	(
+		unsigned char *buffer,
+		int length,
+		char *hex_buffer,
+		int hex_buffer_length
+	)
+{
+	int i;
 
 	if(((length * 2) + 1) > hex_buffer_length)
 		length = (hex_buffer_length - 1) / 2;
@@ -357,225 +834,2588 @@ static int binary2hex
 	return (i*2);
 }
 
-static esp_err_t esp_ota_http_upgrade_internal
-	(
-		esp_http_client_handle_t client,
-		char *upgrade_data_buf,
-		unsigned int *buffer_length,
-		mbedtls_sha256_context *ctx,
-		const esp_ota_desc_t *desc,
-		esp_ota_http_callback_t callback
-	)
+typedef struct
+{
+	const esp_ota_http_upgrade_config_t *config;
+	const esp_ota_desc_t *desc;
+	const esp_partition_t *partition;
+	esp_ota_http_stats_t *stats;
+	esp_ota_hash_t sha256;
+	esp_ota_flash_t flash;
+	esp_ota_http_progress_t progress;
+	esp_ota_nvs_checkpoint_t checkpoint;
+	esp_err_t write_err;
+
+	/* compressed and/or delta transfer, decoded into the flash stage */
+	bool decode;
+	bool compressed;
+	bool delta;
+	bool zsha256_check;
+	bool sync;
+	bool verify;	/* every flash block is checked against desc->blocks */
+	uint32_t image_length;
+	esp_ota_codec_t codec;
+	esp_ota_patch_t patch;
+	esp_ota_hash_t zsha256;
+
+	/* progress throttling */
+	uint32_t start_time;
+	uint32_t start_length;
+	uint32_t notify_time;
+	uint32_t notify_length;
+}esp_ota_http_upgrade_t;
+
+/* deliver progress when a threshold is crossed, the final event always */
+static void esp_ota_http_notify(esp_ota_http_upgrade_t *upgrade, bool done)
 {
-	esp_err_t err, ota_write_err, ota_end_err;
-	int ret, total_length, read_length, length, header_reported_length;
-	esp_ota_handle_t update_handle = 0;
-	const esp_partition_t *update_partition = NULL;
+	const esp_ota_http_upgrade_config_t *config = upgrade->config;
+	esp_ota_http_progress_t *progress = &upgrade->progress;
+	uint32_t now, elapsed;
+	bool due;
 
-	if((*buffer_length) < ((64*2)+2))
+	if(!config->callback)
 	{
-		return ESP_ERR_NO_MEM;
+		return;
 	}
-	length = (*buffer_length) - 32;
 
-	err = esp_http_client_fetch_headers(client);
-#if 1
-	if(err == 0)
+	now = ESP_OTA_TIME_US();
+	if(!done)
 	{
-		debugPrintln("%s header is chunked", "http");
-		return ESP_FAIL;
+		due = (!config->progress_bytes && !config->progress_interval_ms);
+		if(	config->progress_bytes &&
+			(uint32_t)progress->length - upgrade->notify_length >= config->progress_bytes)
+		{
+			due = true;
+		}
+		if(	config->progress_interval_ms &&
+			now - upgrade->notify_time >= config->progress_interval_ms * 1000)
+		{
+			due = true;
+		}
+		if(!due)
+		{
+			return;
+		}
 	}
-	else if(err > 0)
+	upgrade->notify_time = now;
+	upgrade->notify_length = progress->length;
+
+	elapsed = now - upgrade->start_time;
+	progress->elapsed_ms = elapsed / 1000;
+	progress->throughput = 0;
+	progress->eta_ms = -1;
+	if(elapsed && (uint32_t)progress->length > upgrade->start_length)
 	{
-		header_reported_length = err;
-		debugPrintln("%s fetch header length: %d", "http", header_reported_length);
+		progress->throughput = (uint32_t)
+			(((uint64_t)((uint32_t)progress->length - upgrade->start_length) * 1000000) / elapsed);
 	}
-	else
+	if(progress->throughput && progress->total_length >= progress->length)
 	{
-		debugPrintln("%s fetch header failed: %d", "http", err);
-		return err;
+		progress->eta_ms = (int32_t)
+			(((uint64_t)(progress->total_length - progress->length) * 1000) / progress->throughput);
 	}
-#else
-	debugPrintln("%s fetch header: %s(%d)", , "http", err > 0 ? "success":"fail", err);
-#endif
+	progress->done = done;
+	progress->callback_count++;
+	config->callback(progress, config->callback_arg);
+}
 
-	debugPrintln("Starting OTA...");
-	update_partition = esp_ota_get_next_update_partition(NULL);
-	if (update_partition == NULL)
+/* a flash block is one descriptor block, it is written only if the hash matches */
+static esp_err_t esp_ota_http_verify(esp_ota_http_upgrade_t *upgrade, const uint8_t *data, unsigned int length)
+{
+	const esp_ota_desc_t *desc = upgrade->desc;
+	uint32_t index = upgrade->flash.offset / desc->block_size;
+	uint8_t hash[32];
+
+	if(index >= desc->block_count)
 	{
-		debugPrintln("Passive OTA partition not found");
-		return ESP_FAIL;
+		debugPrintln("verify: block %u is out of the image", index);
+		return ESP_ERR_INVALID_SIZE;
 	}
-	debugPrintln("Writing to partition subtype %d at offset 0x%x",
-			 update_partition->subtype, update_partition->address);
-
-	err = esp_ota_begin(update_partition, OTA_SIZE_UNKNOWN, &update_handle);
-	if (err != ESP_OK)
+	esp_ota_hash_sha256(upgrade->config->hash_backend, data, length, hash);
+	if(memcmp(hash, &desc->blocks[index * ESP_OTA_DESC_BLOCK_HASH_SIZE], ESP_OTA_DESC_BLOCK_HASH_SIZE))
 	{
-		debugPrintln("esp_ota_begin failed, error=0x%x", err);
-		return err;
+		debugPrintln("verify: block %u is corrupted", index);
+		return ESP_ERR_INVALID_CRC;
 	}
+	return ESP_OK;
+}
+
+/* drop a rejected block, returns the image offset to fetch again from */
+static uint32_t esp_ota_http_discard(esp_ota_http_upgrade_t *upgrade)
+{
+	esp_ota_flash_discard(&upgrade->flash);
+	upgrade->progress.length = upgrade->flash.offset;
+	upgrade->write_err = ESP_OK;
+	upgrade->stats->block_retry_count++;
+	return upgrade->flash.offset;
+}
+
+static unsigned int esp_ota_http_block_size(const esp_ota_http_upgrade_t *upgrade)
+{
+	return upgrade->verify ? upgrade->desc->block_size : upgrade->config->block_size;
+}
 
-	for (
-			total_length=0, ota_write_err = ESP_FAIL;;
-		)
+static esp_err_t esp_ota_http_block(void *arg, const uint8_t *data, unsigned int length)
+{
+	esp_ota_http_upgrade_t *upgrade = (esp_ota_http_upgrade_t *)arg;
+	uint32_t t = ESP_OTA_TIME_US();
+	esp_err_t err;
+
+	if(upgrade->verify)
 	{
-		read_length = esp_http_client_read
-				(
-					client,
-					upgrade_data_buf,
-					length
-				);
-		if (read_length == 0)
-		{
-			debugPrintln("Connection closed, all data received: %u(bytes)", total_length);
-			err = ESP_OK;
-			break;
-		}
-		else if (read_length < 0)
+		err = esp_ota_http_verify(upgrade, data, length);
+		if(err != ESP_OK)
 		{
-			debugPrintln("Error: SSL data read error err=0x%x", read_length);
-			err = read_length;
-			if(callback)
-			{
-				callback(err, total_length, header_reported_length);
-			}
-			break;
-		}
-		else if (read_length > 0)
-		{
-		    if( ( ret = mbedtls_sha256_update_ret( ctx, upgrade_data_buf, read_length ) ) != 0 )
-		    {
-		    	debugPrintln("sha256: update failed: %d", ret);
-		    	ota_write_err = ESP_FAIL;
-		    	break;
-		    }
-
-			ota_write_err = esp_ota_write
-								(
-									update_handle,
-									(const void *)upgrade_data_buf,
-									read_length
-								);
-			if (ota_write_err != ESP_OK)
-			{
-				break;
-			}
-			total_length += read_length;
-			if(callback)
-			{
-				callback(0, total_length, header_reported_length);
-			}
-//			debugPrintln("Written image length %d", total_length);
+			esp_ota_http_stage(&upgrade->stats->sha256, t);
+			return err;
 		}
 	}
 
+	/* hash what goes to flash, so the midstate always matches the partition */
+	err = esp_ota_hash_update(&upgrade->sha256, data, length);
+	esp_ota_http_stage(&upgrade->stats->sha256, t);
+	esp_ota_http_heap(upgrade->stats);
+	if(err != ESP_OK)
+	{
+		debugPrintln("sha256: update failed: 0x%x", err);
+		return ESP_FAIL;
+	}
+	return ESP_OK;
+}
+
+static esp_err_t esp_ota_http_image_output(void *arg, const uint8_t *data, unsigned int length)
+{
+	esp_ota_http_upgrade_t *upgrade = (esp_ota_http_upgrade_t *)arg;
 
-	ota_end_err = esp_ota_end(update_handle);
+	upgrade->image_length += length;
+	return esp_ota_flash_write(&upgrade->flash, data, length);
+}
 
-    if( ( ret = mbedtls_sha256_finish_ret( ctx, &upgrade_data_buf[length] ) ) != 0 )
-    {
-		debugPrintln("sha256: finish failed: %d", ret);
+static esp_err_t esp_ota_http_patch_input(void *arg, const uint8_t *data, unsigned int length)
+{
+	esp_ota_http_upgrade_t *upgrade = (esp_ota_http_upgrade_t *)arg;
+
+	return esp_ota_patch_write(&upgrade->patch, data, length);
+}
+
+/* transfer -> [decompress] -> [patch] -> flash stage */
+static esp_err_t esp_ota_http_decode(esp_ota_http_upgrade_t *upgrade, const uint8_t *data, unsigned int length)
+{
+	if(upgrade->zsha256_check &&
+		ESP_OK != esp_ota_hash_update(&upgrade->zsha256, data, length))
+	{
+		debugPrintln("zsha256: update failed");
 		return ESP_FAIL;
-    }
+	}
+	if(upgrade->compressed)
+	{
+		return esp_ota_codec_write(&upgrade->codec, data, length);
+	}
+	return esp_ota_patch_write(&upgrade->patch, data, length);
+}
 
-    binary2hex
-		(
-			(unsigned char *)desc->sha256,
-			32,
-			upgrade_data_buf,
-			length + 32
-		);
-    debugPrintln("hash on description: %s", upgrade_data_buf);
-    binary2hex
-		(
-			(unsigned char *)&upgrade_data_buf[length],
-			32,
-			upgrade_data_buf,
-			length + 32
-		);
-	debugPrintln("hash calculated:     %s", upgrade_data_buf);
+/* start the image hash over, e.g. when a range request is ignored */
+static esp_err_t esp_ota_http_sha256_restart(esp_ota_http_upgrade_t *upgrade)
+{
+	esp_ota_hash_free(&upgrade->sha256);
+	return esp_ota_hash_init(&upgrade->sha256, upgrade->config->hash_backend);
+}
 
-    if(memcmp(desc->sha256, &upgrade_data_buf[length], 32))
-    {
-    	debugPrintln("sha256: is not match");
-    	return ESP_FAIL;
-    }
+static bool esp_ota_http_sha256_export
+	(
+		const esp_ota_hash_t *hash,
+		esp_ota_nvs_checkpoint_t *checkpoint
+	)
+{
+	esp_ota_hash_midstate_t midstate;
 
-	if(err != ESP_OK)
+	if(!esp_ota_hash_export(hash, &midstate))
 	{
-		return err;
+		return false;
+	}
+	memcpy(checkpoint->sha256_total, midstate.total, sizeof(checkpoint->sha256_total));
+	memcpy(checkpoint->sha256_state, midstate.state, sizeof(checkpoint->sha256_state));
+	return true;
+}
+
+static bool esp_ota_http_sha256_import
+	(
+		esp_ota_hash_t *hash,
+		const esp_ota_nvs_checkpoint_t *checkpoint
+	)
+{
+	esp_ota_hash_midstate_t midstate;
+
+	if(checkpoint->sha256_total[0] != checkpoint->offset || checkpoint->sha256_total[1])
+	{
+		return false;
 	}
-	else if (ota_write_err != ESP_OK)
+	memcpy(midstate.total, checkpoint->sha256_total, sizeof(midstate.total));
+	memcpy(midstate.state, checkpoint->sha256_state, sizeof(midstate.state));
+	return esp_ota_hash_import(hash, &midstate);
+}
+
+/* load a checkpoint of this image for the passive partition, 0: start over */
+static uint32_t esp_ota_http_resume_offset(esp_ota_http_upgrade_t *upgrade)
+{
+	esp_ota_nvs_checkpoint_t *checkpoint = &upgrade->checkpoint;
+
+	if(ESP_OK != esp_ota_nvs_checkpoint_get(checkpoint))
 	{
-		debugPrintln("Error: esp_ota_write failed! err=0x%x", err);
-		return ota_write_err;
+		return 0;
 	}
-	else if (ota_end_err != ESP_OK)
+	if(	checkpoint->partition_address != upgrade->partition->address ||
+		memcmp(checkpoint->desc_sha256, upgrade->desc->sha256, 32) ||
+		!checkpoint->offset ||
+		(checkpoint->offset % ESP_OTA_FLASH_SECTOR_SIZE) ||
+		checkpoint->offset >= upgrade->partition->size ||
+		(upgrade->desc->size && checkpoint->offset >= upgrade->desc->size) ||
+		!esp_ota_http_sha256_import(&upgrade->sha256, checkpoint))
 	{
-		debugPrintln("Error: esp_ota_end failed! err=0x%x. Image is invalid", ota_end_err);
-		return ota_end_err;
+		debugPrintln("checkpoint is not usable");
+		return 0;
 	}
+	debugPrintln("resume from checkpoint: %u(bytes)", checkpoint->offset);
+	return checkpoint->offset;
+}
 
-	err = esp_ota_set_boot_partition(update_partition);
-	if (err != ESP_OK)
+static void esp_ota_http_checkpoint(esp_ota_http_upgrade_t *upgrade)
+{
+	esp_ota_nvs_checkpoint_t *checkpoint = &upgrade->checkpoint;
+	uint32_t offset = upgrade->flash.offset;
+
+	if(	!upgrade->config->checkpoint_sectors ||
+		upgrade->decode ||
+		upgrade->sync ||
+		(offset % ESP_OTA_FLASH_SECTOR_SIZE) ||
+		offset < checkpoint->offset + (upgrade->config->checkpoint_sectors * ESP_OTA_FLASH_SECTOR_SIZE))
 	{
-		debugPrintln("esp_ota_set_boot_partition failed! err=0x%x", err);
-		return err;
+		return;
 	}
-	debugPrintln("esp_ota_set_boot_partition succeeded");
 
-	*buffer_length = total_length;
+	memset(checkpoint, 0, sizeof(esp_ota_nvs_checkpoint_t));
+	if(!esp_ota_http_sha256_export(&upgrade->sha256, checkpoint))
+	{
+		return;
+	}
+	checkpoint->offset = offset;
+	checkpoint->partition_address = upgrade->partition->address;
+	memcpy(checkpoint->desc_sha256, upgrade->desc->sha256, 32);
+	if(ESP_OK != esp_ota_nvs_checkpoint_set(checkpoint))
+	{
+		debugPrintln("checkpoint: save failed at %u(bytes)", offset);
+	}
+}
+
+/* one read and its write, at most a flash block, done: the transfer ended */
+static esp_err_t esp_ota_http_download_step
+	(
+		esp_http_client_handle_t client,
+		esp_ota_http_upgrade_t *upgrade,
+		bool *done
+	)
+{
+	int read_length;
+	unsigned int length;
+	uint8_t *buffer;
+	uint8_t read_buffer[ESP_OTA_HTTP_CODEC_READ_SIZE];
+
+	if(upgrade->decode)
+	{
+		buffer = read_buffer;
+		length = sizeof(read_buffer);
+	}
+	else
+	{
+		/* read straight into the flash block, it is written once full */
+		buffer = esp_ota_flash_get_buffer(&upgrade->flash, &length);
+	}
+	read_length = esp_ota_http_read
+			(
+				client,
+				(char *)buffer,
+				length,
+				upgrade->stats
+			);
+	*done = true;
+	if (read_length == 0)
+	{
+		debugPrintln("Connection closed, all data received: %u(bytes)", upgrade->progress.length);
+		return ESP_OK;
+	}
+	else if (read_length < 0)
+	{
+		debugPrintln("Error: SSL data read error err=0x%x", read_length);
+		return read_length;
+	}
+
+	if(upgrade->decode)
+	{
+		upgrade->write_err = esp_ota_http_decode(upgrade, buffer, read_length);
+	}
+	else
+	{
+		upgrade->write_err = esp_ota_flash_commit(&upgrade->flash, read_length);
+	}
+	if (upgrade->write_err != ESP_OK)
+	{
+		return ESP_OK;
+	}
+	esp_ota_http_checkpoint(upgrade);
+	upgrade->progress.length += read_length;
+	upgrade->progress.write_count = upgrade->flash.write_count;
+	esp_ota_http_notify(upgrade, false);
+	*done = false;
 	return ESP_OK;
 }
 
-esp_err_t esp_ota_http_upgrade
-(
-	const esp_http_client_config_t *config,
-	const esp_ota_desc_t *desc,
-	esp_ota_http_callback_t callback
-)
+static esp_err_t esp_ota_http_download
+	(
+		esp_http_client_handle_t client,
+		esp_ota_http_upgrade_t *upgrade
+	)
+{
+	esp_err_t err;
+	bool done;
+
+	upgrade->write_err = ESP_FAIL;
+	do
+	{
+		err = esp_ota_http_download_step(client, upgrade, &done);
+	}while(!done);
+	return err;
+}
+
+typedef struct
 {
 	esp_http_client_handle_t client;
+	esp_ota_ring_t ring;
+	SemaphoreHandle_t done;
 	esp_err_t err;
-	char *upgrade_data_buf;
-	unsigned int buffer_size;
-	mbedtls_sha256_context ctx;
-	int ret;
+	esp_ota_http_stats_t *stats;
+}esp_ota_http_reader_t;
 
-	err = esp_ota_http_client_open(config, &client);
-	if(ESP_OK != err)
+static void esp_ota_http_reader_task(void *arg)
+{
+	esp_ota_http_reader_t *reader = (esp_ota_http_reader_t *)arg;
+	uint8_t *buffer;
+	int read_length;
+
+	reader->err = ESP_OK;
+	while(NULL != (buffer = esp_ota_ring_acquire(&reader->ring)))
 	{
-		return err;
+		read_length = esp_ota_http_read
+				(
+					reader->client,
+					(char *)buffer,
+					reader->ring.size,
+					reader->stats
+				);
+		if (read_length <= 0)
+		{
+			if(read_length < 0)
+			{
+				debugPrintln("Error: SSL data read error err=0x%x", read_length);
+				reader->err = read_length;
+			}
+			esp_ota_ring_publish(&reader->ring, 0);
+			break;
+		}
+		esp_ota_ring_publish(&reader->ring, read_length);
 	}
+	xSemaphoreGive(reader->done);
+	vTaskDelete(NULL);
+}
 
-	buffer_size = ESP_OTA_HTTP_UPGRADE_BUF_SIZE;
-	upgrade_data_buf = (char *)ESP_OTA_MALLOC(buffer_size);
-	assert(upgrade_data_buf);
+static esp_err_t esp_ota_http_download_pipelined
+	(
+		esp_http_client_handle_t client,
+		esp_ota_http_upgrade_t *upgrade
+	)
+{
+	const esp_ota_http_upgrade_config_t *upgrade_config = upgrade->config;
+	esp_ota_http_progress_t *progress = &upgrade->progress;
+	esp_ota_http_reader_t reader;
+	const uint8_t *buffer;
+	unsigned int length;
+	esp_err_t err;
 
-	mbedtls_sha256_init( &ctx );
+	upgrade->write_err = ESP_FAIL;
 
-	if( ( ret = mbedtls_sha256_starts_ret( &ctx, 0 ) ) != 0 )
+	memset(&reader, 0, sizeof(reader));
+	reader.client = client;
+	reader.stats = upgrade->stats;
+	err = esp_ota_ring_init
+			(
+				&reader.ring,
+				upgrade_config->pipeline_depth,
+				upgrade_config->pipeline_buffer_size ?
+					upgrade_config->pipeline_buffer_size : ESP_OTA_HTTP_PIPELINE_BUF_SIZE
+			);
+	if(err != ESP_OK)
 	{
-		debugPrintln("sha256: start failed: %d", ret);
-		err = ESP_FAIL;
-		goto exit;
+		upgrade->write_err = err;
+		return ESP_OK;
+	}
+	reader.done = xSemaphoreCreateBinary();
+	if(!reader.done)
+	{
+		esp_ota_ring_deinit(&reader.ring);
+		upgrade->write_err = ESP_ERR_NO_MEM;
+		return ESP_OK;
 	}
 
-	err = esp_ota_http_upgrade_internal
+	if(pdPASS != xTaskCreate
+					(
+						esp_ota_http_reader_task,
+						"ota_reader",
+						ESP_OTA_HTTP_READER_STACK_SIZE,
+						&reader,
+						upgrade_config->pipeline_task_priority ?
+							upgrade_config->pipeline_task_priority : ESP_OTA_HTTP_READER_PRIORITY,
+						NULL
+					))
+	{
+		vSemaphoreDelete(reader.done);
+		esp_ota_ring_deinit(&reader.ring);
+		upgrade->write_err = ESP_ERR_NO_MEM;
+		return ESP_OK;
+	}
+
+	for(;;)
+	{
+		buffer = esp_ota_ring_peek(&reader.ring, &length);
+		if(!length)
+		{
+			break;
+		}
+
+		if(upgrade->decode)
+		{
+			upgrade->write_err = esp_ota_http_decode(upgrade, buffer, length);
+		}
+		else
+		{
+			upgrade->write_err = esp_ota_flash_write(&upgrade->flash, buffer, length);
+		}
+		esp_ota_ring_release(&reader.ring);
+		if (upgrade->write_err != ESP_OK)
+		{
+			break;
+		}
+		esp_ota_http_checkpoint(upgrade);
+
+		progress->length += length;
+		progress->write_count = upgrade->flash.write_count;
+		progress->reader_stalls = reader.ring.producer_stalls;
+		progress->reader_wait_us = reader.ring.producer_wait_us;
+		progress->writer_stalls = reader.ring.consumer_stalls;
+		progress->writer_wait_us = reader.ring.consumer_wait_us;
+		esp_ota_http_notify(upgrade, false);
+	}
+
+	if(length)
+	{
+		/* writer failed, stop the reader */
+		esp_ota_ring_abort(&reader.ring);
+	}
+	xSemaphoreTake(reader.done, portMAX_DELAY);
+
+	debugPrintln
 		(
-			client,
-			upgrade_data_buf,
-			&buffer_size,
-			&ctx,
-			desc,
-			callback
+			"pipeline: reader stalls %u (%u us), writer stalls %u (%u us)",
+			reader.ring.producer_stalls, reader.ring.producer_wait_us,
+			reader.ring.consumer_stalls, reader.ring.consumer_wait_us
 		);
 
-exit:
-	esp_ota_http_client_cleanup(client);
-	mbedtls_sha256_free( &ctx );
-	ESP_OTA_FREE(upgrade_data_buf);
+	err = reader.err;
+	vSemaphoreDelete(reader.done);
+	esp_ota_ring_deinit(&reader.ring);
+	return err;
+}
+
+/* the partition of an upgrade, NULL: none, the running partition is never written */
+static const esp_partition_t *esp_ota_http_target(const esp_ota_http_upgrade_config_t *upgrade_config)
+{
+	const esp_partition_t *partition;
+
+	partition = upgrade_config->partition;
+	if(!partition)
+	{
+		return esp_ota_get_next_update_partition(NULL);
+	}
+	if(partition->address == esp_ota_get_running_partition()->address)
+	{
+		debugPrintln("partition 0x%x is running", partition->address);
+		return NULL;
+	}
+	return partition;
+}
+
+/* a written and verified app becomes the boot partition */
+static esp_err_t esp_ota_http_activate
+	(
+		const esp_ota_http_upgrade_config_t *upgrade_config,
+		const esp_partition_t *partition
+	)
+{
+	esp_err_t err;
+
+	if(upgrade_config->no_activate || partition->type != ESP_PARTITION_TYPE_APP)
+	{
+		return ESP_OK;
+	}
+	err = esp_ota_set_boot_partition(partition);
+	if (err != ESP_OK)
+	{
+		debugPrintln("esp_ota_set_boot_partition failed! err=0x%x", err);
+		return err;
+	}
+	debugPrintln("esp_ota_set_boot_partition succeeded");
+	return ESP_OK;
+}
+
+/* end the flash stage, verify the image and switch the boot partition */
+static esp_err_t esp_ota_http_upgrade_complete
+	(
+		esp_ota_http_upgrade_t *upgrade,
+		esp_err_t err
+	)
+{
+	esp_err_t ota_end_err;
+	uint8_t sha256[32];
+	char sha256_hex[(32*2)+1];
+
+	ota_end_err = esp_ota_flash_end(&upgrade->flash, (err == ESP_OK && upgrade->write_err == ESP_OK));
+	/* the tail block is written by esp_ota_flash_end() */
+	upgrade->progress.write_count = upgrade->flash.write_count;
+
+    if(ESP_OK != esp_ota_hash_finish(&upgrade->sha256, sha256))
+    {
+		debugPrintln("sha256: finish failed");
+		return ESP_FAIL;
+    }
+
+    binary2hex
+		(
+			(unsigned char *)upgrade->desc->sha256,
+			32,
+			sha256_hex,
+			sizeof(sha256_hex)
+		);
+    debugPrintln("hash on description: %s", sha256_hex);
+    binary2hex
+		(
+			sha256,
+			32,
+			sha256_hex,
+			sizeof(sha256_hex)
+		);
+	debugPrintln("hash calculated:     %s", sha256_hex);
+
+	if(err != ESP_OK)
+	{
+		return err;
+	}
+	else if (upgrade->write_err != ESP_OK)
+	{
+		debugPrintln("Error: esp_ota_write failed! err=0x%x", upgrade->write_err);
+		return upgrade->write_err;
+	}
+	else if (ota_end_err != ESP_OK)
+	{
+		debugPrintln("Error: esp_ota_end failed! err=0x%x. Image is invalid", ota_end_err);
+		return ota_end_err;
+	}
+
+	if(upgrade->zsha256_check)
+	{
+		uint8_t zsha256[32];
+
+		if(ESP_OK != esp_ota_hash_finish(&upgrade->zsha256, zsha256) ||
+			memcmp(upgrade->desc->zsha256, zsha256, 32))
+		{
+			debugPrintln("zsha256: is not match");
+			return ESP_FAIL;
+		}
+	}
+
+    if(memcmp(upgrade->desc->sha256, sha256, 32))
+    {
+    	debugPrintln("sha256: is not match");
+    	if(upgrade->config->checkpoint_sectors)
+    	{
+    		/* never resume into a bad image */
+    		esp_ota_nvs_checkpoint_clear();
+    	}
+    	return ESP_FAIL;
+    }
+
+	/* the image is complete, a resume would find nothing left to fetch */
+	if(upgrade->config->checkpoint_sectors)
+	{
+		esp_ota_nvs_checkpoint_clear();
+	}
+	return esp_ota_http_activate(upgrade->config, upgrade->partition);
+}
+
+/* response headers of the image request, the flash stage is opened */
+static esp_err_t esp_ota_http_upgrade_start
+	(
+		esp_http_client_handle_t client,
+		esp_ota_http_upgrade_t *upgrade,
+		uint32_t offset
+	)
+{
+	uint32_t image_size;
+	esp_err_t err;
+
+	err = esp_ota_http_fetch_headers(client, upgrade->stats);
+	if(err < 0)
+	{
+		debugPrintln("%s fetch header failed: %d", "http", err);
+		return err;
+	}
+	else if(esp_http_client_is_chunked_response(client))
+	{
+		/* length is known only at the last chunk */
+		upgrade->progress.total_length = -1;
+		if(upgrade->decode && upgrade->desc->zsize)
+		{
+			upgrade->progress.total_length = upgrade->desc->zsize;
+		}
+		debugPrintln("%s header is chunked", "http");
+	}
+	else
+	{
+		upgrade->progress.total_length = err;
+		debugPrintln("%s fetch header length: %d", "http", upgrade->progress.total_length);
+	}
+
+	if(offset && esp_http_client_get_status_code(client) != 206)
+	{
+		/*
+		 * 416 or the range ignored: the checkpoint is dropped and the caller
+		 * requests the whole image, this response is not reused
+		 */
+		debugPrintln("http range is not supported: %d", esp_http_client_get_status_code(client));
+		esp_ota_nvs_checkpoint_clear();
+		memset(&upgrade->checkpoint, 0, sizeof(esp_ota_nvs_checkpoint_t));
+		esp_ota_http_sha256_restart(upgrade);
+		return ESP_OTA_HTTP_RESUME_REFUSED;
+	}
+
+	/* the image must fit, size from the descriptor or the response */
+	image_size = upgrade->desc->size;
+	if(!upgrade->decode && upgrade->progress.total_length >= 0)
+	{
+		if(image_size && image_size != offset + upgrade->progress.total_length)
+		{
+			debugPrintln("image size %u is expected", image_size);
+			return ESP_ERR_INVALID_SIZE;
+		}
+		image_size = offset + upgrade->progress.total_length;
+	}
+	if(image_size > upgrade->partition->size)
+	{
+		debugPrintln("image %u(bytes) is larger than the partition", image_size);
+		return ESP_ERR_INVALID_SIZE;
+	}
+
+	debugPrintln("Starting OTA...");
+	debugPrintln("Writing to partition subtype %d at offset 0x%x",
+			 upgrade->partition->subtype, upgrade->partition->address);
+
+	if(offset)
+	{
+		err = esp_ota_flash_resume
+				(
+					&upgrade->flash,
+					upgrade->partition,
+					upgrade->config->block_size,
+					offset,
+					image_size,
+					upgrade->config->erase_ahead_sectors,
+					upgrade->config->skip_same_sectors
+				);
+	}
+	else
+	{
+		if(upgrade->config->checkpoint_sectors)
+		{
+			/* the partition is erased, older checkpoints are stale */
+			esp_ota_nvs_checkpoint_clear();
+			memset(&upgrade->checkpoint, 0, sizeof(esp_ota_nvs_checkpoint_t));
+		}
+		err = esp_ota_flash_begin
+				(
+					&upgrade->flash,
+					upgrade->partition,
+					upgrade->config->block_size,
+					image_size,
+					upgrade->config->erase_ahead_sectors,
+					upgrade->config->skip_same_sectors
+				);
+	}
+	if (err != ESP_OK)
+	{
+		debugPrintln("esp_ota_flash_begin failed, error=0x%x", err);
+		return err;
+	}
+	upgrade->flash.block_callback = esp_ota_http_block;
+	upgrade->flash.block_callback_arg = upgrade;
+	upgrade->progress.block_size = upgrade->flash.block_size;
+	upgrade->progress.length = offset;
+	upgrade->start_length = offset;
+	upgrade->notify_length = offset;
+	if(upgrade->progress.total_length >= 0)
+	{
+		upgrade->progress.total_length += offset;
+	}
+	return ESP_OK;
+}
+
+/* end of the transfer, err is the download result */
+static esp_err_t esp_ota_http_upgrade_end(esp_ota_http_upgrade_t *upgrade, esp_err_t err)
+{
+	if(upgrade->decode && err == ESP_OK && upgrade->write_err == ESP_OK)
+	{
+		if(upgrade->compressed)
+		{
+			upgrade->write_err = esp_ota_codec_finish(&upgrade->codec);
+		}
+		if(upgrade->delta && upgrade->write_err == ESP_OK)
+		{
+			upgrade->write_err = esp_ota_patch_finish(&upgrade->patch);
+		}
+		debugPrintln("decode: %u(bytes) image", upgrade->image_length);
+		if(	upgrade->write_err == ESP_OK &&
+			upgrade->desc->size &&
+			upgrade->desc->size != upgrade->image_length)
+		{
+			debugPrintln("decode: image size %u is expected", upgrade->desc->size);
+			upgrade->write_err = ESP_ERR_INVALID_SIZE;
+		}
+	}
+
+	return esp_ota_http_upgrade_complete(upgrade, err);
+}
+
+static esp_err_t esp_ota_http_upgrade_internal
+	(
+		esp_http_client_handle_t client,
+		esp_ota_http_upgrade_t *upgrade,
+		uint32_t offset
+	)
+{
+	esp_err_t err;
+
+	err = esp_ota_http_upgrade_start(client, upgrade, offset);
+	if(err != ESP_OK)
+	{
+		return err;
+	}
+
+	if(upgrade->config->pipeline_depth)
+	{
+		err = esp_ota_http_download_pipelined(client, upgrade);
+	}
+	else
+	{
+		err = esp_ota_http_download(client, upgrade);
+	}
+	return esp_ota_http_upgrade_end(upgrade, err);
+}
+
+typedef struct
+{
+	const esp_partition_t *running;
+	uint8_t *blocks;
+	unsigned int count;
+}esp_ota_http_sync_t;
+
+/* block hashes of the running partition, same truncated SHA-256 as desc->blocks */
+static esp_err_t esp_ota_http_sync_init
+	(
+		esp_ota_http_sync_t *sync,
+		uint32_t block_size,
+		const esp_ota_hash_backend_t *backend
+	)
+{
+	esp_ota_hash_t ctx;
+	uint8_t buffer[ESP_OTA_HTTP_SYNC_READ_SIZE];
+	uint8_t hash[32];
+	uint32_t offset, n;
+	unsigned int i;
+
+	sync->running = esp_ota_get_running_partition();
+	if(!sync->running)
+	{
+		return ESP_FAIL;
+	}
+	sync->count = sync->running->size / block_size;
+	sync->blocks = (uint8_t *)ESP_OTA_MALLOC(sync->count * ESP_OTA_DESC_BLOCK_HASH_SIZE);
+	if(!sync->blocks)
+	{
+		return ESP_ERR_NO_MEM;
+	}
+
+	for(i = 0; i < sync->count; i++)
+	{
+		esp_ota_hash_init(&ctx, backend);
+		for(offset = 0; offset < block_size; offset += n)
+		{
+			n = block_size - offset;
+			if(n > sizeof(buffer))
+			{
+				n = sizeof(buffer);
+			}
+			if(ESP_OK != esp_partition_read(sync->running, (i * block_size) + offset, buffer, n))
+			{
+				break;
+			}
+			esp_ota_hash_update(&ctx, buffer, n);
+		}
+		if(offset < block_size)
+		{
+			/* unreadable, the rest is fetched */
+			esp_ota_hash_free(&ctx);
+			sync->count = i;
+			break;
+		}
+		esp_ota_hash_finish(&ctx, hash);
+		esp_ota_hash_free(&ctx);
+		memcpy(&sync->blocks[i * ESP_OTA_DESC_BLOCK_HASH_SIZE], hash, ESP_OTA_DESC_BLOCK_HASH_SIZE);
+	}
+	return ESP_OK;
+}
+
+/* running partition block with the content of image block i, -1: fetch it */
+static int esp_ota_http_sync_find
+	(
+		const esp_ota_http_sync_t *sync,
+		const esp_ota_desc_t *desc,
+		unsigned int i
+	)
+{
+	static const uint8_t zero[ESP_OTA_DESC_BLOCK_HASH_SIZE];
+	const uint8_t *hash = &desc->blocks[i * ESP_OTA_DESC_BLOCK_HASH_SIZE];
+	unsigned int j;
+
+	/* the short last block is never on the running partition as is */
+	if(	((i + 1) * desc->block_size) > desc->size ||
+		0 == memcmp(hash, zero, ESP_OTA_DESC_BLOCK_HASH_SIZE))
+	{
+		return -1;
+	}
+	/* the same position first, it is the most likely match */
+	if(i < sync->count && 0 == memcmp(&sync->blocks[i * ESP_OTA_DESC_BLOCK_HASH_SIZE], hash, ESP_OTA_DESC_BLOCK_HASH_SIZE))
+	{
+		return i;
+	}
+	for(j = 0; j < sync->count; j++)
+	{
+		if(0 == memcmp(&sync->blocks[j * ESP_OTA_DESC_BLOCK_HASH_SIZE], hash, ESP_OTA_DESC_BLOCK_HASH_SIZE))
+		{
+			return j;
+		}
+	}
+	return -1;
+}
+
+/* copy a block of the running partition through the flash buffer */
+static esp_err_t esp_ota_http_sync_copy
+	(
+		esp_ota_http_upgrade_t *upgrade,
+		const esp_ota_http_sync_t *sync,
+		unsigned int j
+	)
+{
+	uint32_t offset, end;
+	unsigned int length;
+	uint8_t *buffer;
+	esp_err_t err = ESP_OK;
+
+	for(offset = j * upgrade->desc->block_size, end = offset + upgrade->desc->block_size;
+		offset < end && err == ESP_OK;
+		offset += length)
+	{
+		buffer = esp_ota_flash_get_buffer(&upgrade->flash, &length);
+		if(length > end - offset)
+		{
+			length = end - offset;
+		}
+		err = esp_partition_read(sync->running, offset, buffer, length);
+		if(err == ESP_OK)
+		{
+			err = esp_ota_flash_commit(&upgrade->flash, length);
+		}
+		if(err == ESP_OK)
+		{
+			/* only what reached the flash stage counts */
+			upgrade->progress.length += length;
+		}
+	}
+	upgrade->progress.write_count = upgrade->flash.write_count;
+	esp_ota_http_notify(upgrade, false);
+	return err;
+}
+
+/* body of a range request, straight into the flash stage */
+static esp_err_t esp_ota_http_sync_range
+	(
+		esp_http_client_handle_t client,
+		esp_ota_http_upgrade_t *upgrade,
+		uint32_t length
+	)
+{
+	uint32_t received;
+	esp_err_t err;
+
+	err = esp_ota_http_fetch_headers(client, upgrade->stats);
+	if(err < 0)
+	{
+		debugPrintln("%s fetch header failed: %d", "http", err);
+		return err;
+	}
+	if(esp_http_client_get_status_code(client) != 206)
+	{
+		debugPrintln("http range is not supported: %d", esp_http_client_get_status_code(client));
+		return ESP_ERR_NOT_SUPPORTED;
+	}
+
+	received = upgrade->progress.length;
+	err = esp_ota_http_download(client, upgrade);
+	if(	err == ESP_OK && upgrade->write_err == ESP_OK &&
+		upgrade->progress.length - received != length)
+	{
+		debugPrintln("http range: %u(bytes) of %u", upgrade->progress.length - received, length);
+		return ESP_ERR_INVALID_SIZE;
+	}
+	return err;
+}
+
+/*
+ * Chunk sync: the image is rebuilt block by block, blocks found on the
+ * running partition are copied and each run of missing blocks is fetched
+ * with one Range request. A data partition has no local copies, the image
+ * is one run and only the blocks that fail their hash are fetched again.
+ */
+static esp_err_t esp_ota_http_sync
+	(
+		esp_ota_http_session_handle_t session,
+		const char *url,
+		esp_ota_http_upgrade_t *upgrade
+	)
+{
+	const esp_ota_desc_t *desc = upgrade->desc;
+	esp_ota_http_sync_t sync;
+	unsigned int i, n, copied, fetched;
+	uint32_t start, end, failed;
+	esp_err_t err;
+	int j, retry;
+
+	memset(&sync, 0, sizeof(sync));
+	if(upgrade->partition->type == ESP_PARTITION_TYPE_APP)
+	{
+		err = esp_ota_http_sync_init(&sync, desc->block_size, upgrade->config->hash_backend);
+		if(err != ESP_OK)
+		{
+			return err;
+		}
+	}
+
+	if(upgrade->config->checkpoint_sectors)
+	{
+		/* the partition is erased, older checkpoints are stale */
+		esp_ota_nvs_checkpoint_clear();
+	}
+	err = esp_ota_flash_begin
+			(
+				&upgrade->flash,
+				upgrade->partition,
+				esp_ota_http_block_size(upgrade),
+				desc->size,
+				upgrade->config->erase_ahead_sectors,
+				upgrade->config->skip_same_sectors
+			);
+	if (err != ESP_OK)
+	{
+		debugPrintln("esp_ota_flash_begin failed, error=0x%x", err);
+		ESP_OTA_FREE(sync.blocks);
+		return err;
+	}
+	upgrade->flash.block_callback = esp_ota_http_block;
+	upgrade->flash.block_callback_arg = upgrade;
+	upgrade->progress.block_size = upgrade->flash.block_size;
+	upgrade->progress.total_length = desc->size;
+	upgrade->write_err = ESP_OK;
+
+	for(i = 0, copied = 0, fetched = 0;
+		i < desc->block_count && err == ESP_OK && upgrade->write_err == ESP_OK;
+		i = n)
+	{
+		j = esp_ota_http_sync_find(&sync, desc, i);
+		if(j >= 0)
+		{
+			upgrade->write_err = esp_ota_http_sync_copy(upgrade, &sync, j);
+			if(upgrade->write_err != ESP_ERR_INVALID_CRC)
+			{
+				copied++;
+				n = i + 1;
+				continue;
+			}
+			/* the local block doesn't verify, fetch it */
+			esp_ota_http_discard(upgrade);
+		}
+
+		for(n = i + 1; n < desc->block_count && esp_ota_http_sync_find(&sync, desc, n) < 0; n++);
+		end = n * desc->block_size;
+		if(end > desc->size)
+		{
+			end = desc->size;
+		}
+		for(start = i * desc->block_size, failed = start, retry = 0;; retry++)
+		{
+			err = esp_ota_http_session_request(session, url, start, end);
+			if(err != ESP_OK)
+			{
+				break;
+			}
+			/* the url is kept by the client */
+			url = NULL;
+			err = esp_ota_http_sync_range(session->client, upgrade, end - start);
+			esp_ota_http_session_finish(session);
+			if(	upgrade->verify && end == desc->size &&
+				err == ESP_OK && upgrade->write_err == ESP_OK)
+			{
+				/* verify the last partial block while it can be fetched again */
+				upgrade->write_err = esp_ota_flash_flush(&upgrade->flash);
+			}
+			if(err != ESP_OK || upgrade->write_err != ESP_ERR_INVALID_CRC)
+			{
+				break;
+			}
+			if(upgrade->flash.offset > failed)
+			{
+				/* a later block of the run, the retries are per block */
+				failed = upgrade->flash.offset;
+				retry = 0;
+			}
+			if(retry >= ESP_OTA_HTTP_BLOCK_RETRIES)
+			{
+				break;
+			}
+			start = esp_ota_http_discard(upgrade);
+		}
+		fetched += n - i;
+	}
+	debugPrintln("sync: %u blocks copied, %u blocks fetched", copied, fetched);
+
+	ESP_OTA_FREE(sync.blocks);
+	return esp_ota_http_upgrade_complete(upgrade, err);
+}
+
+/* everything of an upgrade before its first request */
+static esp_err_t esp_ota_http_upgrade_setup
+	(
+		esp_ota_http_session_handle_t session,
+		esp_ota_http_upgrade_t *upgrade,
+		const esp_ota_desc_t *desc,
+		const esp_ota_http_upgrade_config_t *upgrade_config
+	)
+{
+	esp_err_t err;
+	int ret;
+
+	memset(upgrade, 0, sizeof(esp_ota_http_upgrade_t));
+	upgrade->config = upgrade_config;
+	upgrade->desc = desc;
+	upgrade->stats = &session->attempt;
+	upgrade->progress.total_length = -1;
+	upgrade->start_time = ESP_OTA_TIME_US();
+	upgrade->notify_time = upgrade->start_time;
+
+	upgrade->partition = esp_ota_http_target(upgrade_config);
+	if (upgrade->partition == NULL)
+	{
+		debugPrintln("Passive OTA partition not found");
+		return ESP_FAIL;
+	}
+	if(desc->base_size && upgrade->partition->type != ESP_PARTITION_TYPE_APP)
+	{
+		/* the base of a delta is the running app */
+		debugPrintln("delta to a data partition");
+		return ESP_ERR_NOT_SUPPORTED;
+	}
+
+	err = esp_ota_hash_init(&upgrade->sha256, upgrade_config->hash_backend);
+	if(ESP_OK != err)
+	{
+		debugPrintln("sha256: start failed: 0x%x", err);
+		return ESP_FAIL;
+	}
+
+	if(desc->base_size)
+	{
+		err = esp_ota_patch_init
+			(
+				&upgrade->patch,
+				esp_ota_get_running_partition(),
+				desc->base_size,
+				esp_ota_http_image_output,
+				upgrade
+			);
+		if(ESP_OK == err)
+		{
+			err = esp_ota_patch_check_base(&upgrade->patch, desc->base_sha256);
+		}
+		if(ESP_OK != err)
+		{
+			/* ESP_ERR_INVALID_VERSION: not our base, use the full image */
+			debugPrintln("delta from %u.%u: 0x%x", desc->base_version >> 8, desc->base_version & 0xff, err);
+			return err;
+		}
+		upgrade->delta = true;
+	}
+
+	if(desc->codec != ESP_OTA_DESC_CODEC_NONE)
+	{
+		err = esp_ota_codec_init
+			(
+				&upgrade->codec,
+				desc->codec,
+				desc->window_bits,
+				desc->lookahead_bits,
+				upgrade->delta ? esp_ota_http_patch_input : esp_ota_http_image_output,
+				upgrade
+			);
+		if(ESP_OK != err)
+		{
+			debugPrintln("codec %u: init failed: 0x%x", desc->codec, err);
+			return err;
+		}
+		upgrade->compressed = true;
+	}
+
+	if(upgrade->compressed || upgrade->delta)
+	{
+		upgrade->decode = true;
+		for(ret = 0; ret < 32 && !desc->zsha256[ret]; ret++);
+		if(ret < 32)
+		{
+			upgrade->zsha256_check = true;
+			esp_ota_hash_init(&upgrade->zsha256, upgrade_config->hash_backend);
+		}
+	}
+
+	/* flash blocks are descriptor blocks, a corrupted one never reaches flash */
+	upgrade->verify =
+		(	desc->blocks && !upgrade->decode &&
+			!(desc->block_size % ESP_OTA_FLASH_PAGE_SIZE) &&
+			desc->block_size <= ESP_OTA_HTTP_VERIFY_BLOCK_MAX);
+	return ESP_OK;
+}
+
+/* final progress event, the resources and stats of the attempt */
+static void esp_ota_http_upgrade_release
+	(
+		esp_ota_http_session_handle_t session,
+		esp_ota_http_upgrade_t *upgrade,
+		esp_err_t err
+	)
+{
+	upgrade->progress.err = err;
+	esp_ota_http_notify(upgrade, true);
+	debugPrintln
+		(
+			"progress: %u callbacks, %u(bytes/s) in %u ms",
+			upgrade->progress.callback_count,
+			upgrade->progress.throughput,
+			upgrade->progress.elapsed_ms
+		);
+	if(upgrade->compressed)
+	{
+		esp_ota_codec_deinit(&upgrade->codec);
+	}
+	if(upgrade->zsha256_check)
+	{
+		esp_ota_hash_free(&upgrade->zsha256);
+	}
+	esp_ota_hash_free(&upgrade->sha256);
+
+	session->attempt.erase.count = upgrade->flash.erase_count;
+	session->attempt.erase.time_us = upgrade->flash.erase_time_us;
+	session->attempt.erase.max_us = upgrade->flash.erase_max_us;
+	session->attempt.write.count = upgrade->flash.write_count;
+	session->attempt.write.time_us = upgrade->flash.write_time_us;
+	session->attempt.write.max_us = upgrade->flash.write_max_us;
+	session->attempt.skip_count = upgrade->flash.skip_count;
+	session->attempt.blank_count = upgrade->flash.blank_count;
+	esp_ota_http_attempt_end(session, err);
+}
+
+esp_err_t esp_ota_http_session_upgrade
+(
+	esp_ota_http_session_handle_t session,
+	const char *url,
+	const esp_ota_desc_t *desc,
+	const esp_ota_http_upgrade_config_t *upgrade_config
+)
+{
+	static const esp_ota_http_upgrade_config_t default_upgrade_config;
+	esp_ota_http_upgrade_t *upgrade;
+	esp_err_t err;
+	uint32_t offset;
+
+	if(!upgrade_config)
+	{
+		upgrade_config = &default_upgrade_config;
+	}
+
+	esp_ota_http_attempt_begin(session);
+	upgrade = (esp_ota_http_upgrade_t *)ESP_OTA_MALLOC(sizeof(esp_ota_http_upgrade_t));
+	if(!upgrade)
+	{
+		esp_ota_http_attempt_end(session, ESP_ERR_NO_MEM);
+		return ESP_ERR_NO_MEM;
+	}
+	err = esp_ota_http_upgrade_setup(session, upgrade, desc, upgrade_config);
+	if(ESP_OK != err)
+	{
+		goto exit;
+	}
+
+	if(	desc->blocks && !upgrade->decode &&
+		(upgrade->partition->type == ESP_PARTITION_TYPE_APP || upgrade->verify))
+	{
+		/* blocks are copied from the running app, a rejected block is fetched again */
+		upgrade->sync = true;
+		err = esp_ota_http_sync(session, url, upgrade);
+		goto exit;
+	}
+
+	/* offsets in a compressed or patch stream do not map to the partition */
+	offset = 0;
+	if(upgrade_config->checkpoint_sectors && !upgrade->decode)
+	{
+		offset = esp_ota_http_resume_offset(upgrade);
+		if(!offset)
+		{
+			esp_ota_http_sha256_restart(upgrade);
+		}
+	}
+
+	err = esp_ota_http_session_request(session, url, offset, 0);
+	if(ESP_OK != err)
+	{
+		goto exit;
+	}
+
+	err = esp_ota_http_upgrade_internal
+		(
+			session->client,
+			upgrade,
+			offset
+		);
+	if(err == ESP_OTA_HTTP_RESUME_REFUSED)
+	{
+		esp_ota_http_session_finish(session);
+		err = esp_ota_http_session_request(session, url, 0, 0);
+		if(ESP_OK != err)
+		{
+			goto exit;
+		}
+		err = esp_ota_http_upgrade_internal(session->client, upgrade, 0);
+	}
+
+	esp_ota_http_session_finish(session);
+exit:
+	esp_ota_http_upgrade_release(session, upgrade, err);
+
+	ESP_OTA_FREE(upgrade);
+	return err;
+}
+
+esp_err_t esp_ota_http_upgrade_ext
+(
+	const esp_http_client_config_t *config,
+	const esp_ota_desc_t *desc,
+	const esp_ota_http_upgrade_config_t *upgrade_config
+)
+{
+	esp_ota_http_session_handle_t session;
+	esp_err_t err;
+
+	err = esp_ota_http_session_open(config, &session);
+	if(ESP_OK != err)
+	{
+		return err;
+	}
+	err = esp_ota_http_session_upgrade(session, NULL, desc, upgrade_config);
+	esp_ota_http_session_close(session);
+	return err;
+}
+
+static void esp_ota_http_legacy_callback(const esp_ota_http_progress_t *progress, void *arg)
+{
+	esp_ota_http_callback_t callback = *(esp_ota_http_callback_t *)arg;
+
+	callback(progress->err, progress->length, progress->total_length);
+}
+
+esp_err_t esp_ota_http_upgrade
+(
+	const esp_http_client_config_t *config,
+	const esp_ota_desc_t *desc,
+	esp_ota_http_callback_t callback
+)
+{
+	esp_ota_http_upgrade_config_t upgrade_config;
+
+	memset(&upgrade_config, 0, sizeof(upgrade_config));
+	if(callback)
+	{
+		upgrade_config.callback = esp_ota_http_legacy_callback;
+		upgrade_config.callback_arg = &callback;
+	}
+	return esp_ota_http_upgrade_ext(config, desc, &upgrade_config);
+}
+
+/*
+ * Step-driven upgrade: the stages of esp_ota_http_session_upgrade(), one
+ * of them or one read per esp_ota_http_upgrade_step()
+ */
+
+#define ESP_OTA_HTTP_STEP_REQUEST	(0)
+#define ESP_OTA_HTTP_STEP_HEADERS	(1)
+#define ESP_OTA_HTTP_STEP_DATA		(2)
+#define ESP_OTA_HTTP_STEP_COMPLETE	(3)
+#define ESP_OTA_HTTP_STEP_DONE		(4)
+
+struct esp_ota_http_async
+{
+	esp_ota_http_session_handle_t session;
+	bool own_session;
+	const char *url;
+	esp_ota_http_upgrade_config_t config;
+	esp_ota_http_upgrade_t upgrade;
+	uint32_t offset;
+	int state;
+	esp_err_t err;
+
+	/* to release on cancel */
+	bool response;
+	bool flash;
+};
+
+static void esp_ota_http_async_response_end(esp_ota_http_upgrade_handle_t async)
+{
+	if(async->response)
+	{
+		esp_ota_http_session_finish(async->session);
+		async->response = false;
+	}
+}
+
+esp_err_t esp_ota_http_session_upgrade_begin
+(
+	esp_ota_http_session_handle_t session,
+	const char *url,
+	const esp_ota_desc_t *desc,
+	const esp_ota_http_upgrade_config_t *upgrade_config,
+	esp_ota_http_upgrade_handle_t *out
+)
+{
+	esp_ota_http_upgrade_handle_t async;
+	esp_ota_http_upgrade_t *upgrade;
+	esp_err_t err;
+
+	if(desc && (desc->codec != ESP_OTA_DESC_CODEC_NONE || desc->base_size))
+	{
+		/*
+		 * a read can inflate or patch-copy far more than a flash block, and a
+		 * delta hashes the whole base before the first step
+		 */
+		debugPrintln("step: only plain images");
+		return ESP_ERR_NOT_SUPPORTED;
+	}
+
+	async = (esp_ota_http_upgrade_handle_t)ESP_OTA_MALLOC(sizeof(struct esp_ota_http_async));
+	if(!async)
+	{
+		return ESP_ERR_NO_MEM;
+	}
+	memset(async, 0, sizeof(struct esp_ota_http_async));
+	async->session = session;
+	async->url = url;
+	if(upgrade_config)
+	{
+		memcpy(&async->config, upgrade_config, sizeof(esp_ota_http_upgrade_config_t));
+	}
+
+	/* bounded steps: the partition is erased along the way, no reader task */
+	if(!async->config.erase_ahead_sectors && !async->config.skip_same_sectors)
+	{
+		async->config.erase_ahead_sectors = 1;
+	}
+	async->config.pipeline_depth = 0;
+
+	esp_ota_http_attempt_begin(session);
+	upgrade = &async->upgrade;
+	err = esp_ota_http_upgrade_setup(session, upgrade, desc, &async->config);
+	if(ESP_OK != err)
+	{
+		esp_ota_http_upgrade_release(session, upgrade, err);
+		ESP_OTA_FREE(async);
+		return err;
+	}
+
+	/* chunk sync takes a request per range, the image is fetched whole */
+	upgrade->verify = false;
+	if(async->config.checkpoint_sectors)
+	{
+		async->offset = esp_ota_http_resume_offset(upgrade);
+		if(!async->offset)
+		{
+			esp_ota_http_sha256_restart(upgrade);
+		}
+	}
+	async->state = ESP_OTA_HTTP_STEP_REQUEST;
+	*out = async;
+	return ESP_OK;
+}
+
+esp_err_t esp_ota_http_upgrade_begin
+(
+	const esp_http_client_config_t *config,
+	const esp_ota_desc_t *desc,
+	const esp_ota_http_upgrade_config_t *upgrade_config,
+	esp_ota_http_upgrade_handle_t *out
+)
+{
+	esp_ota_http_session_handle_t session;
+	esp_err_t err;
+
+	err = esp_ota_http_session_open(config, &session);
+	if(ESP_OK != err)
+	{
+		return err;
+	}
+	err = esp_ota_http_session_upgrade_begin(session, NULL, desc, upgrade_config, out);
+	if(ESP_OK != err)
+	{
+		esp_ota_http_session_close(session);
+		return err;
+	}
+	(*out)->own_session = true;
+	return ESP_OK;
+}
+
+esp_err_t esp_ota_http_upgrade_step(esp_ota_http_upgrade_handle_t async)
+{
+	esp_ota_http_upgrade_t *upgrade;
+	esp_err_t err;
+	bool done;
+
+	if(!async)
+	{
+		return ESP_ERR_INVALID_ARG;
+	}
+	upgrade = &async->upgrade;
+
+	switch(async->state)
+	{
+	case ESP_OTA_HTTP_STEP_REQUEST:
+		err = esp_ota_http_session_request(async->session, async->url, async->offset, 0);
+		if(ESP_OK != err)
+		{
+			break;
+		}
+		async->response = true;
+		async->state = ESP_OTA_HTTP_STEP_HEADERS;
+		return ESP_ERR_OTA_HTTP_IN_PROGRESS;
+
+	case ESP_OTA_HTTP_STEP_HEADERS:
+		err = esp_ota_http_upgrade_start(async->session->client, upgrade, async->offset);
+		if(err == ESP_OTA_HTTP_RESUME_REFUSED)
+		{
+			esp_ota_http_async_response_end(async);
+			async->offset = 0;
+			async->state = ESP_OTA_HTTP_STEP_REQUEST;
+			return ESP_ERR_OTA_HTTP_IN_PROGRESS;
+		}
+		if(ESP_OK != err)
+		{
+			break;
+		}
+		async->flash = true;
+		upgrade->write_err = ESP_FAIL;
+		async->state = ESP_OTA_HTTP_STEP_DATA;
+		return ESP_ERR_OTA_HTTP_IN_PROGRESS;
+
+	case ESP_OTA_HTTP_STEP_DATA:
+		err = esp_ota_http_download_step(async->session->client, upgrade, &done);
+		if(done)
+		{
+			/* hash, image check and boot partition are the next step */
+			esp_ota_http_async_response_end(async);
+			async->err = err;
+			async->state = ESP_OTA_HTTP_STEP_COMPLETE;
+		}
+		return ESP_ERR_OTA_HTTP_IN_PROGRESS;
+
+	case ESP_OTA_HTTP_STEP_COMPLETE:
+		err = esp_ota_http_upgrade_end(upgrade, async->err);
+		async->flash = false;
+		break;
+
+	default:
+		return async->err;
+	}
+
+	esp_ota_http_async_response_end(async);
+	async->err = err;
+	async->state = ESP_OTA_HTTP_STEP_DONE;
+	return err;
+}
+
+void esp_ota_http_upgrade_get_progress
+(
+	esp_ota_http_upgrade_handle_t async,
+	esp_ota_http_progress_t *progress
+)
+{
+	memcpy(progress, &async->upgrade.progress, sizeof(esp_ota_http_progress_t));
+}
+
+static void esp_ota_http_async_free(esp_ota_http_upgrade_handle_t async, esp_err_t err)
+{
+	esp_ota_http_upgrade_release(async->session, &async->upgrade, err);
+	if(async->own_session)
+	{
+		esp_ota_http_session_close(async->session);
+	}
+	ESP_OTA_FREE(async);
+}
+
+esp_err_t esp_ota_http_upgrade_cancel(esp_ota_http_upgrade_handle_t async)
+{
+	if(!async)
+	{
+		return ESP_ERR_INVALID_ARG;
+	}
+	debugPrintln("upgrade is cancelled at %u(bytes)", async->upgrade.progress.length);
+	esp_ota_http_async_response_end(async);
+	if(async->flash)
+	{
+		/* the update handle and flash buffer, nothing is flushed */
+		esp_ota_flash_end(&async->upgrade.flash, false);
+	}
+	esp_ota_http_async_free(async, ESP_ERR_OTA_HTTP_CANCELLED);
+	return ESP_OK;
+}
+
+esp_err_t esp_ota_http_upgrade_finish(esp_ota_http_upgrade_handle_t async)
+{
+	esp_err_t err;
+
+	if(!async)
+	{
+		return ESP_ERR_INVALID_ARG;
+	}
+	if(async->state != ESP_OTA_HTTP_STEP_DONE)
+	{
+		esp_ota_http_upgrade_cancel(async);
+		return ESP_ERR_INVALID_STATE;
+	}
+	err = async->err;
+	esp_ota_http_async_free(async, err);
+	return err;
+}
+
+/*
+ * Mirrors: the image is split into ranges, one worker per mirror claims the
+ * next free range, fetches it with a Range request and writes it directly
+ * into the partition. A failed range is given to the other mirrors, a mirror
+ * that keeps failing stops. Fast mirrors claim more ranges.
+ *
+ * End-game: when no free range is left, an idle mirror also fetches the busy
+ * range with the most bytes left, from its next unwritten block. Blocks go to
+ * the first mirror that has all of their bytes, the others drop them, so a
+ * slow mirror holds back at most the block it is reading.
+ */
+
+#define ESP_OTA_HTTP_RANGE_FREE	(0)
+#define ESP_OTA_HTTP_RANGE_BUSY	(1)
+#define ESP_OTA_HTTP_RANGE_DONE	(2)
+
+typedef struct
+{
+	uint8_t state;
+	uint8_t failed;		/* mirrors it failed on, bit per mirror */
+	uint8_t workers;	/* mirrors fetching it, more than one in the end-game */
+	bool erased;		/* by its first mirror, the end-game waits for it */
+	bool broken;		/* a taken block was not written, the range starts over */
+	uint32_t next;		/* image offset of the next block to write */
+	uint32_t length;	/* bytes of it in progress.length */
+}esp_ota_http_range_t;
+
+typedef struct
+{
+	esp_ota_http_upgrade_t upgrade;	/* shared progress, hash and stats */
+	SemaphoreHandle_t lock;			/* ranges, progress and stats, never held for flash or callbacks */
+	SemaphoreHandle_t notify_lock;	/* one progress callback at a time */
+	esp_ota_http_range_t *ranges;
+	unsigned int range_count;
+	uint32_t range_size;
+	unsigned int done_count;
+	uint8_t mirror_mask;
+	uint8_t dead_mask;				/* mirrors that stopped */
+	esp_err_t err;
+}esp_ota_http_mirrors_t;
+
+typedef struct
+{
+	esp_ota_http_mirrors_t *mirrors;
+	esp_ota_http_session_handle_t session;
+	unsigned int index;
+	uint32_t start;				/* image offset the claimed range is fetched from */
+	bool erase;					/* first mirror of the claimed range */
+	unsigned int range_count;	/* ranges this mirror wrote blocks of */
+	esp_err_t err;				/* last error of this mirror */
+	SemaphoreHandle_t done;
+}esp_ota_http_mirror_t;
+
+static void esp_ota_http_stage_add(esp_ota_http_stage_stats_t *stage, const esp_ota_http_stage_stats_t *other)
+{
+	stage->count += other->count;
+	stage->time_us += other->time_us;
+	if(other->max_us > stage->max_us)
+	{
+		stage->max_us = other->max_us;
+	}
+}
+
+/* network counters of another session of the same attempt */
+static void esp_ota_http_stats_add(esp_ota_http_stats_t *stats, const esp_ota_http_stats_t *other)
+{
+	unsigned int i;
+
+	esp_ota_http_stage_add(&stats->connect, &other->connect);
+	esp_ota_http_stage_add(&stats->headers, &other->headers);
+	esp_ota_http_stage_add(&stats->read, &other->read);
+	stats->read_bytes += other->read_bytes;
+	for(i = 0; i < ESP_OTA_HTTP_STATS_READ_BUCKETS; i++)
+	{
+		stats->read_histogram[i] += other->read_histogram[i];
+	}
+	stats->request_count += other->request_count;
+	stats->handshake_count += other->handshake_count;
+	stats->reconnect_count += other->reconnect_count;
+	if(other->free_heap_min < stats->free_heap_min)
+	{
+		stats->free_heap_min = other->free_heap_min;
+	}
+}
+
+/* image offset where range i ends */
+static uint32_t esp_ota_http_range_end(const esp_ota_http_mirrors_t *mirrors, unsigned int i)
+{
+	uint32_t end = (i + 1) * mirrors->range_size;
+
+	return (end > mirrors->upgrade.desc->size) ? mirrors->upgrade.desc->size : end;
+}
+
+/* next range for this mirror, -1: nothing left, -2: wait, a busy range may fail */
+static int esp_ota_http_mirror_claim(esp_ota_http_mirror_t *mirror)
+{
+	esp_ota_http_mirrors_t *mirrors = mirror->mirrors;
+	esp_ota_http_range_t *range;
+	uint8_t bit = 1 << mirror->index;
+	uint32_t left = 0;
+	unsigned int i;
+	int ret = -1, busy = -1;
+
+	for(i = 0; i < mirrors->range_count && mirrors->err == ESP_OK; i++)
+	{
+		range = &mirrors->ranges[i];
+		if(range->state == ESP_OTA_HTTP_RANGE_BUSY)
+		{
+			ret = -2;
+			if(	range->erased && !((range->workers | range->failed) & bit) &&
+				esp_ota_http_range_end(mirrors, i) - range->next > left)
+			{
+				busy = i;
+				left = esp_ota_http_range_end(mirrors, i) - range->next;
+			}
+		}
+		else if(range->state != ESP_OTA_HTTP_RANGE_FREE)
+		{
+			continue;
+		}
+		else if(!(range->failed & bit))
+		{
+			range->state = ESP_OTA_HTTP_RANGE_BUSY;
+			range->workers = bit;
+			range->next = i * mirrors->range_size;
+			mirror->start = range->next;
+			mirror->erase = true;
+			return i;
+		}
+		else if(((range->failed | mirrors->dead_mask) & mirrors->mirror_mask) == mirrors->mirror_mask)
+		{
+			debugPrintln("mirror: range %u failed on every mirror", i);
+			mirrors->err = ESP_FAIL;
+		}
+		else
+		{
+			ret = -2;
+		}
+	}
+	if(mirrors->err != ESP_OK)
+	{
+		return -1;
+	}
+	if(busy >= 0)
+	{
+		/* end-game: nothing free for this mirror, race a busy range from its next block */
+		range = &mirrors->ranges[busy];
+		range->workers |= bit;
+		mirror->start = range->next;
+		mirror->erase = false;
+		debugPrintln("mirror %u: end-game on range %u at %u", mirror->index, busy, mirror->start);
+		return busy;
+	}
+	return ret;
+}
+
+/*
+ * A completed block of range i at offset, under mirrors->lock: true if it is
+ * the next block of the range and this mirror writes it, false if another
+ * mirror was faster.
+ */
+static bool esp_ota_http_mirror_take(esp_ota_http_mirrors_t *mirrors, unsigned int i, uint32_t offset, uint32_t length)
+{
+	esp_ota_http_range_t *range = &mirrors->ranges[i];
+
+	if(range->broken || offset != range->next)
+	{
+		return false;
+	}
+	range->next += length;
+	range->length += length;
+	mirrors->upgrade.progress.length += length;
+	return true;
+}
+
+/* this mirror stops working on range i, the last one decides its state */
+static void esp_ota_http_mirror_leave(esp_ota_http_mirror_t *mirror, unsigned int i, esp_err_t err)
+{
+	esp_ota_http_mirrors_t *mirrors = mirror->mirrors;
+	esp_ota_http_range_t *range = &mirrors->ranges[i];
+
+	range->workers &= ~(1 << mirror->index);
+	if(err != ESP_OK)
+	{
+		range->failed |= 1 << mirror->index;
+	}
+	if(range->workers)
+	{
+		return;
+	}
+	if(range->erased && !range->broken && range->next == esp_ota_http_range_end(mirrors, i))
+	{
+		range->state = ESP_OTA_HTTP_RANGE_DONE;
+		mirrors->done_count++;
+		return;
+	}
+	/* the range is erased and fetched again */
+	mirrors->upgrade.progress.length -= range->length;
+	range->state = ESP_OTA_HTTP_RANGE_FREE;
+	range->erased = false;
+	range->broken = false;
+	range->length = 0;
+}
+
+/* progress.length is updated under mirrors->lock, the callback runs outside it */
+static void esp_ota_http_mirror_notify(esp_ota_http_mirrors_t *mirrors)
+{
+	xSemaphoreTake(mirrors->notify_lock, portMAX_DELAY);
+	esp_ota_http_notify(&mirrors->upgrade, false);
+	xSemaphoreGive(mirrors->notify_lock);
+}
+
+/* fetch range i from mirror->start into the partition */
+static esp_err_t esp_ota_http_mirror_range(esp_ota_http_mirror_t *mirror, unsigned int i)
+{
+	esp_ota_http_mirrors_t *mirrors = mirror->mirrors;
+	esp_ota_http_upgrade_t *upgrade = &mirrors->upgrade;
+	esp_ota_http_range_t *range = &mirrors->ranges[i];
+	esp_ota_http_session_handle_t session = mirror->session;
+	esp_ota_flash_t flash;
+	uint32_t start, end, offset, t;
+	unsigned int length;
+	uint8_t *buffer;
+	int read_length;
+	bool take, wrote = false;
+	esp_err_t err;
+
+	start = mirror->start;
+	end = esp_ota_http_range_end(mirrors, i);
+
+	err = esp_ota_http_session_request(session, NULL, start, end);
+	if(err == ESP_OK)
+	{
+		err = esp_ota_http_fetch_headers(session->client, &session->attempt);
+		if(err < 0)
+		{
+			debugPrintln("%s fetch header failed: %d", "http", err);
+		}
+		else if(esp_http_client_get_status_code(session->client) != 206)
+		{
+			debugPrintln("mirror %u: http range is not supported: %d", mirror->index, esp_http_client_get_status_code(session->client));
+			err = ESP_ERR_NOT_SUPPORTED;
+		}
+		else
+		{
+			err = ESP_OK;
+		}
+	}
+
+	if(err == ESP_OK && mirror->erase)
+	{
+		/* erased here, also when the range is fetched again from another mirror */
+		t = ESP_OTA_TIME_US();
+		err = esp_partition_erase_range
+				(
+					upgrade->partition,
+					start,
+					((end - start) + ESP_OTA_FLASH_SECTOR_SIZE - 1) & ~(ESP_OTA_FLASH_SECTOR_SIZE - 1)
+				);
+		xSemaphoreTake(mirrors->lock, portMAX_DELAY);
+		esp_ota_http_stage(&upgrade->stats->erase, t);
+		range->erased = (err == ESP_OK);
+		xSemaphoreGive(mirrors->lock);
+	}
+	if(err == ESP_OK)
+	{
+		err = esp_ota_flash_open(&flash, upgrade->partition, upgrade->config->block_size, start);
+	}
+	if(err != ESP_OK)
+	{
+		xSemaphoreTake(mirrors->lock, portMAX_DELAY);
+		esp_ota_http_mirror_leave(mirror, i, err);
+		xSemaphoreGive(mirrors->lock);
+		esp_ota_http_session_finish(session);
+		return err;
+	}
+
+	for(offset = start; offset < end && err == ESP_OK; offset += read_length)
+	{
+		xSemaphoreTake(mirrors->lock, portMAX_DELAY);
+		take = !range->broken && range->next < end;
+		xSemaphoreGive(mirrors->lock);
+		if(!take)
+		{
+			/* the other mirrors of the range took every block */
+			break;
+		}
+
+		buffer = esp_ota_flash_get_buffer(&flash, &length);
+		if(length > end - offset)
+		{
+			length = end - offset;
+		}
+		read_length = esp_ota_http_read(session->client, (char *)buffer, length, &session->attempt);
+		if(read_length <= 0)
+		{
+			debugPrintln("mirror %u: range %u ends at %u(bytes): %d", mirror->index, i, offset - start, read_length);
+			err = read_length ? read_length : ESP_ERR_INVALID_SIZE;
+			break;
+		}
+		if((unsigned int)read_length < length)
+		{
+			err = esp_ota_flash_commit(&flash, read_length);
+			continue;
+		}
+
+		/* the block is complete, the first mirror to get here writes it */
+		length = flash.length + read_length;
+		xSemaphoreTake(mirrors->lock, portMAX_DELAY);
+		take = esp_ota_http_mirror_take(mirrors, i, flash.offset, length);
+		xSemaphoreGive(mirrors->lock);
+		if(!take)
+		{
+			esp_ota_flash_discard(&flash);
+			if(offset + read_length < end)
+			{
+				err = esp_ota_flash_skip(&flash, length);
+			}
+			continue;
+		}
+
+		err = esp_ota_flash_commit(&flash, read_length);
+		if(err == ESP_OK)
+		{
+			err = esp_ota_flash_flush(&flash);
+		}
+		if(err != ESP_OK)
+		{
+			/* the block is lost, the range starts over */
+			xSemaphoreTake(mirrors->lock, portMAX_DELAY);
+			range->broken = true;
+			xSemaphoreGive(mirrors->lock);
+		}
+		wrote = true;
+		esp_ota_http_mirror_notify(mirrors);
+	}
+	esp_ota_flash_end(&flash, false);
+
+	xSemaphoreTake(mirrors->lock, portMAX_DELAY);
+	upgrade->stats->write.count += flash.write_count;
+	upgrade->stats->blank_count += flash.blank_count;
+	upgrade->stats->write.time_us += flash.write_time_us;
+	if(flash.write_max_us > upgrade->stats->write.max_us)
+	{
+		upgrade->stats->write.max_us = flash.write_max_us;
+	}
+	upgrade->progress.write_count = upgrade->stats->write.count;
+	if(err == ESP_OK && wrote)
+	{
+		mirror->range_count++;
+	}
+	esp_ota_http_mirror_leave(mirror, i, err);
+	xSemaphoreGive(mirrors->lock);
+
+	esp_ota_http_session_finish(session);
+	return err;
+}
+
+static void esp_ota_http_mirror_run(esp_ota_http_mirror_t *mirror)
+{
+	esp_ota_http_mirrors_t *mirrors = mirror->mirrors;
+	unsigned int errors = 0;
+	esp_err_t err;
+	int i;
+
+	for(;;)
+	{
+		xSemaphoreTake(mirrors->lock, portMAX_DELAY);
+		i = esp_ota_http_mirror_claim(mirror);
+		xSemaphoreGive(mirrors->lock);
+		if(i == -1)
+		{
+			break;
+		}
+		if(i < 0)
+		{
+			vTaskDelay(ESP_OTA_HTTP_MIRROR_WAIT_MS / portTICK_PERIOD_MS);
+			continue;
+		}
+
+		err = esp_ota_http_mirror_range(mirror, i);
+		if(err == ESP_OK)
+		{
+			errors = 0;
+			continue;
+		}
+		mirror->err = err;
+		if(++errors >= ESP_OTA_HTTP_MIRROR_ERRORS)
+		{
+			debugPrintln("mirror %u: stopped, error=0x%x", mirror->index, err);
+			break;
+		}
+	}
+
+	xSemaphoreTake(mirrors->lock, portMAX_DELAY);
+	mirrors->dead_mask |= 1 << mirror->index;
+	xSemaphoreGive(mirrors->lock);
+}
+
+static void esp_ota_http_mirror_task(void *arg)
+{
+	esp_ota_http_mirror_t *mirror = (esp_ota_http_mirror_t *)arg;
+
+	esp_ota_http_mirror_run(mirror);
+	xSemaphoreGive(mirror->done);
+	vTaskDelete(NULL);
+}
+
+/* hash the first size bytes of a partition into an initialized hash */
+static esp_err_t esp_ota_http_partition_hash
+	(
+		esp_ota_hash_t *hash,
+		const esp_partition_t *partition,
+		uint32_t size
+	)
+{
+	uint8_t buffer[ESP_OTA_HTTP_SYNC_READ_SIZE];
+	uint32_t offset, length;
+	esp_err_t err;
+
+	for(offset = 0; offset < size; offset += length)
+	{
+		length = size - offset;
+		if(length > sizeof(buffer))
+		{
+			length = sizeof(buffer);
+		}
+		err = esp_partition_read(partition, offset, buffer, length);
+		if(err != ESP_OK)
+		{
+			return err;
+		}
+		esp_ota_hash_update(hash, buffer, length);
+	}
+	return ESP_OK;
+}
+
+/* ranges are written out of order, the image is hashed from the partition */
+static esp_err_t esp_ota_http_mirror_complete(esp_ota_http_upgrade_t *upgrade)
+{
+	uint8_t sha256[32];
+	uint32_t t;
+	esp_err_t err;
+
+	t = ESP_OTA_TIME_US();
+	err = esp_ota_http_partition_hash(&upgrade->sha256, upgrade->partition, upgrade->desc->size);
+	if(err != ESP_OK)
+	{
+		return err;
+	}
+	esp_ota_hash_finish(&upgrade->sha256, sha256);
+	esp_ota_http_stage(&upgrade->stats->sha256, t);
+
+	if(memcmp(upgrade->desc->sha256, sha256, 32))
+	{
+		debugPrintln("sha256: is not match");
+		return ESP_FAIL;
+	}
+	return esp_ota_http_activate(upgrade->config, upgrade->partition);
+}
+
+esp_err_t esp_ota_http_upgrade_mirrors
+(
+	const esp_http_client_config_t *configs,
+	unsigned int count,
+	const esp_ota_desc_t *desc,
+	const esp_ota_http_upgrade_config_t *upgrade_config
+)
+{
+	static const esp_ota_http_upgrade_config_t default_upgrade_config;
+	esp_ota_http_mirrors_t *mirrors;
+	esp_ota_http_mirror_t *mirror;
+	esp_ota_http_upgrade_t *upgrade;
+	unsigned int i;
+	esp_err_t err;
+
+	if(!configs || !count || count > ESP_OTA_HTTP_MIRRORS_MAX || !desc || !desc->size)
+	{
+		return ESP_ERR_INVALID_ARG;
+	}
+	if(desc->codec != ESP_OTA_DESC_CODEC_NONE || desc->base_size)
+	{
+		/* a compressed or patch stream can't be split at image offsets */
+		debugPrintln("mirrors: only plain images");
+		return ESP_ERR_NOT_SUPPORTED;
+	}
+	if(!upgrade_config)
+	{
+		upgrade_config = &default_upgrade_config;
+	}
+
+	mirrors = (esp_ota_http_mirrors_t *)ESP_OTA_MALLOC(sizeof(esp_ota_http_mirrors_t));
+	mirror = (esp_ota_http_mirror_t *)ESP_OTA_MALLOC(count * sizeof(esp_ota_http_mirror_t));
+	if(!mirrors || !mirror)
+	{
+		ESP_OTA_FREE(mirrors);
+		ESP_OTA_FREE(mirror);
+		return ESP_ERR_NO_MEM;
+	}
+	memset(mirrors, 0, sizeof(esp_ota_http_mirrors_t));
+	memset(mirror, 0, count * sizeof(esp_ota_http_mirror_t));
+
+	upgrade = &mirrors->upgrade;
+	upgrade->config = upgrade_config;
+	upgrade->desc = desc;
+	upgrade->progress.total_length = desc->size;
+	upgrade->progress.block_size = upgrade_config->block_size ?
+		upgrade_config->block_size : ESP_OTA_FLASH_BLOCK_SIZE;
+
+	mirrors->range_size = upgrade_config->mirror_range_size ?
+		upgrade_config->mirror_range_size : ESP_OTA_HTTP_MIRROR_RANGE_SIZE;
+	mirrors->range_count = (desc->size + mirrors->range_size - 1) / mirrors->range_size;
+	mirrors->ranges = (esp_ota_http_range_t *)ESP_OTA_MALLOC(mirrors->range_count * sizeof(esp_ota_http_range_t));
+	mirrors->lock = xSemaphoreCreateMutex();
+	mirrors->notify_lock = xSemaphoreCreateMutex();
+
+	for(i = 0, err = ESP_OK; i < count && err == ESP_OK; i++)
+	{
+		mirror[i].mirrors = mirrors;
+		mirror[i].index = i;
+		mirror[i].done = xSemaphoreCreateBinary();
+		err = mirror[i].done ? esp_ota_http_session_open(&configs[i], &mirror[i].session) : ESP_ERR_NO_MEM;
+		mirrors->mirror_mask |= 1 << i;
+	}
+	/* the first session holds the statistics of the attempt */
+	for(i = count; i-- > 0;)
+	{
+		if(mirror[i].session)
+		{
+			esp_ota_http_attempt_begin(mirror[i].session);
+		}
+	}
+	upgrade->stats = mirror[0].session ? &mirror[0].session->attempt : NULL;
+	upgrade->start_time = ESP_OTA_TIME_US();
+	upgrade->notify_time = upgrade->start_time;
+
+	if(err != ESP_OK)
+	{
+		goto exit;
+	}
+	if(!mirrors->ranges || !mirrors->lock || !mirrors->notify_lock)
+	{
+		err = ESP_ERR_NO_MEM;
+		goto exit;
+	}
+	if(mirrors->range_size % ESP_OTA_FLASH_SECTOR_SIZE)
+	{
+		err = ESP_ERR_INVALID_ARG;
+		goto exit;
+	}
+	memset(mirrors->ranges, 0, mirrors->range_count * sizeof(esp_ota_http_range_t));
+
+	upgrade->partition = esp_ota_http_target(upgrade_config);
+	if (upgrade->partition == NULL)
+	{
+		debugPrintln("Passive OTA partition not found");
+		err = ESP_FAIL;
+		goto exit;
+	}
+	if(desc->size > upgrade->partition->size)
+	{
+		err = ESP_ERR_INVALID_SIZE;
+		goto exit;
+	}
+	if(upgrade_config->checkpoint_sectors)
+	{
+		/* the partition is overwritten, older checkpoints are stale */
+		esp_ota_nvs_checkpoint_clear();
+	}
+	esp_ota_hash_init(&upgrade->sha256, upgrade_config->hash_backend);
+
+	/* the first mirror runs in the calling task */
+	for(i = 1; i < count; i++)
+	{
+		if(pdPASS != xTaskCreate
+						(
+							esp_ota_http_mirror_task,
+							"ota_mirror",
+							ESP_OTA_HTTP_MIRROR_STACK_SIZE,
+							&mirror[i],
+							uxTaskPriorityGet(NULL),
+							NULL
+						))
+		{
+			mirror[i].err = ESP_ERR_NO_MEM;
+			mirrors->dead_mask |= 1 << i;
+			xSemaphoreGive(mirror[i].done);
+		}
+	}
+	esp_ota_http_mirror_run(&mirror[0]);
+	for(i = 1; i < count; i++)
+	{
+		xSemaphoreTake(mirror[i].done, portMAX_DELAY);
+	}
+
+	err = mirrors->err;
+	for(i = 0; i < count; i++)
+	{
+		debugPrintln("mirror %u: %u ranges, error=0x%x", i, mirror[i].range_count, mirror[i].err);
+		if(err == ESP_OK && mirrors->done_count < mirrors->range_count)
+		{
+			err = mirror[i].err;
+		}
+	}
+	if(err == ESP_OK && mirrors->done_count < mirrors->range_count)
+	{
+		err = ESP_FAIL;
+	}
+	if(err == ESP_OK)
+	{
+		err = esp_ota_http_mirror_complete(upgrade);
+	}
+
+exit:
+	upgrade->progress.err = err;
+	if(upgrade->stats)
+	{
+		esp_ota_http_notify(upgrade, true);
+	}
+	esp_ota_hash_free(&upgrade->sha256);
+	for(i = count; i-- > 0;)
+	{
+		if(mirror[i].session)
+		{
+			if(i)
+			{
+				esp_ota_http_stats_add(&mirror[0].session->attempt, &mirror[i].session->attempt);
+			}
+			else
+			{
+				esp_ota_http_attempt_end(mirror[i].session, err);
+			}
+			esp_ota_http_session_close(mirror[i].session);
+		}
+		if(mirror[i].done)
+		{
+			vSemaphoreDelete(mirror[i].done);
+		}
+	}
+	if(mirrors->lock)
+	{
+		vSemaphoreDelete(mirrors->lock);
+	}
+	if(mirrors->notify_lock)
+	{
+		vSemaphoreDelete(mirrors->notify_lock);
+	}
+	ESP_OTA_FREE(mirrors->ranges);
+	ESP_OTA_FREE(mirrors);
+	ESP_OTA_FREE(mirror);
+	return err;
+}
+
+/* the body of a manifest request, at most ESP_OTA_HTTP_MANIFEST_SIZE - 1 bytes */
+static esp_err_t esp_ota_http_get_manifest_internal
+	(
+		esp_ota_http_session_handle_t session,
+		char *body,
+		esp_ota_desc_manifest_t *manifest
+	)
+{
+	esp_http_client_handle_t client = session->client;
+	int length, read_length;
+	esp_err_t err;
+
+	err = esp_ota_http_fetch_headers(client, &session->attempt);
+	if(err < 0)
+	{
+		debugPrintln("http fetch header failed: %d", err);
+		return err;
+	}
+
+	for(length = 0;;)
+	{
+		read_length = esp_ota_http_read
+				(
+					client,
+					&body[length],
+					ESP_OTA_HTTP_MANIFEST_SIZE - length,
+					&session->attempt
+				);
+		if(read_length == 0)
+		{
+			break;
+		}
+		else if(read_length < 0)
+		{
+			debugPrintln("Error: SSL data read error");
+			return read_length;
+		}
+		length += read_length;
+		if(length >= ESP_OTA_HTTP_MANIFEST_SIZE)
+		{
+			debugPrintln("manifest is larger than %u(bytes)", ESP_OTA_HTTP_MANIFEST_SIZE - 1);
+			return ESP_ERR_INVALID_SIZE;
+		}
+	}
+
+	if(esp_ota_desc_parse_manifest(body, length, manifest))
+	{
+		return ESP_FAIL;
+	}
+	return ESP_OK;
+}
+
+esp_err_t esp_ota_http_session_get_manifest
+(
+	esp_ota_http_session_handle_t session,
+	const char *url,
+	esp_ota_desc_manifest_t *manifest
+)
+{
+	esp_err_t err;
+	char *body;
+
+	esp_ota_http_attempt_begin(session);
+	body = (char *)ESP_OTA_MALLOC(ESP_OTA_HTTP_MANIFEST_SIZE);
+	if(!body)
+	{
+		esp_ota_http_attempt_end(session, ESP_ERR_NO_MEM);
+		return ESP_ERR_NO_MEM;
+	}
+	err = esp_ota_http_session_request(session, url, 0, 0);
+	if(ESP_OK == err)
+	{
+		err = esp_ota_http_get_manifest_internal(session, body, manifest);
+		esp_ota_http_session_finish(session);
+	}
+	ESP_OTA_FREE(body);
+	esp_ota_http_attempt_end(session, err);
+	return err;
+}
+
+/* progress of one manifest component, tagged with its index */
+typedef struct
+{
+	const esp_ota_http_upgrade_config_t *upgrade_config;
+	uint8_t component;
+	uint8_t component_count;
+}esp_ota_http_component_t;
+
+static void esp_ota_http_component_callback(const esp_ota_http_progress_t *progress, void *arg)
+{
+	const esp_ota_http_component_t *component = (const esp_ota_http_component_t *)arg;
+	esp_ota_http_progress_t tagged;
+
+	memcpy(&tagged, progress, sizeof(esp_ota_http_progress_t));
+	tagged.component = component->component;
+	tagged.component_count = component->component_count;
+	component->upgrade_config->callback(&tagged, component->upgrade_config->callback_arg);
+}
+
+/* partition by label, app partitions first, "": the next OTA app partition */
+static const esp_partition_t *esp_ota_http_component_partition(const esp_ota_desc_component_t *component)
+{
+	const esp_partition_t *partition;
+
+	if(!component->partition[0])
+	{
+		return esp_ota_get_next_update_partition(NULL);
+	}
+	partition = esp_partition_find_first(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_ANY, component->partition);
+	if(!partition)
+	{
+		partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, component->partition);
+	}
+	return partition;
+}
+
+/* the partition already holds the image of desc */
+static bool esp_ota_http_component_current
+	(
+		const esp_partition_t *partition,
+		const esp_ota_desc_t *desc,
+		const esp_ota_hash_backend_t *backend
+	)
+{
+	esp_ota_hash_t hash;
+	uint8_t sha256[32];
+	esp_err_t err;
+
+	if(!desc->size || desc->size > partition->size)
+	{
+		return false;
+	}
+	err = esp_ota_hash_init(&hash, backend);
+	if(err != ESP_OK)
+	{
+		return false;
+	}
+	err = esp_ota_http_partition_hash(&hash, partition, desc->size);
+	if(err == ESP_OK)
+	{
+		err = esp_ota_hash_finish(&hash, sha256);
+	}
+	esp_ota_hash_free(&hash);
+	return (err == ESP_OK && 0 == memcmp(sha256, desc->sha256, 32));
+}
+
+esp_err_t esp_ota_http_session_upgrade_manifest
+(
+	esp_ota_http_session_handle_t session,
+	const char *base_url,
+	const esp_ota_desc_manifest_t *manifest,
+	const esp_ota_http_upgrade_config_t *upgrade_config,
+	esp_ota_http_component_result_t *results
+)
+{
+	static const esp_ota_http_upgrade_config_t default_upgrade_config;
+	const esp_partition_t *partitions[ESP_OTA_DESC_MANIFEST_COMPONENTS];
+	const esp_partition_t *running;
+	esp_ota_http_component_result_t result[ESP_OTA_DESC_MANIFEST_COMPONENTS];
+	esp_ota_http_upgrade_config_t config;
+	esp_ota_http_component_t component;
+	const esp_ota_desc_component_t *c;
+	unsigned int i, j, pass;
+	bool activate;
+	int app;
+	uint32_t t;
+	char *url;
+	esp_err_t err;
+
+	if(!manifest || !manifest->count || manifest->count > ESP_OTA_DESC_MANIFEST_COMPONENTS)
+	{
+		return ESP_ERR_INVALID_ARG;
+	}
+	if(!upgrade_config)
+	{
+		upgrade_config = &default_upgrade_config;
+	}
+	memset(result, 0, sizeof(result));
+	running = esp_ota_get_running_partition();
+
+	/* every target is checked before anything is written */
+	err = ESP_OK;
+	for(i = 0, app = -1; i < manifest->count && err == ESP_OK; i++)
+	{
+		c = &manifest->components[i];
+		partitions[i] = esp_ota_http_component_partition(c);
+		if(!partitions[i])
+		{
+			debugPrintln("%s: partition \"%s\" not found", c->name, c->partition);
+			err = ESP_ERR_NOT_FOUND;
+		}
+		else if(partitions[i]->address == running->address)
+		{
+			debugPrintln("%s: partition 0x%x is running", c->name, partitions[i]->address);
+			err = ESP_ERR_INVALID_ARG;
+		}
+		else if(c->desc.size > partitions[i]->size)
+		{
+			debugPrintln("%s: image %u(bytes) is larger than the partition", c->name, c->desc.size);
+			err = ESP_ERR_INVALID_SIZE;
+		}
+		else if(partitions[i]->type == ESP_PARTITION_TYPE_APP)
+		{
+			/* one boot partition to switch */
+			err = (app < 0) ? ESP_OK : ESP_ERR_INVALID_ARG;
+			app = i;
+		}
+		for(j = 0; j < i && err == ESP_OK; j++)
+		{
+			if(partitions[j]->address == partitions[i]->address)
+			{
+				debugPrintln("%s: partition 0x%x is written twice", c->name, partitions[i]->address);
+				err = ESP_ERR_INVALID_ARG;
+			}
+		}
+		result[i].err = err;
+	}
+
+	url = (err == ESP_OK) ? (char *)ESP_OTA_MALLOC(ESP_OTA_HTTP_URL_LENGTH) : NULL;
+	if(err == ESP_OK && !url)
+	{
+		err = ESP_ERR_NO_MEM;
+	}
+
+	/*
+	 * the app goes to the passive slot first, data partitions have no
+	 * second copy and are overwritten last
+	 */
+	activate = false;
+	for(pass = 0; pass < 2 && err == ESP_OK; pass++)
+	{
+		for(i = 0; i < manifest->count && err == ESP_OK; i++)
+		{
+			if((partitions[i]->type == ESP_PARTITION_TYPE_APP) != (pass == 0))
+			{
+				continue;
+			}
+			c = &manifest->components[i];
+			t = ESP_OTA_TIME_US();
+			if(partitions[i]->type == ESP_PARTITION_TYPE_APP)
+			{
+				/* the running app, else the passive slot written by an earlier call */
+				activate = !esp_ota_http_component_current(running, &c->desc, upgrade_config->hash_backend);
+				result[i].current =
+					(	!activate ||
+						esp_ota_http_component_current(partitions[i], &c->desc, upgrade_config->hash_backend));
+			}
+			else
+			{
+				result[i].current = esp_ota_http_component_current(partitions[i], &c->desc, upgrade_config->hash_backend);
+			}
+			if(!result[i].current)
+			{
+				err = esp_ota_http_url_resolve(base_url, c->url, url, ESP_OTA_HTTP_URL_LENGTH);
+			}
+			if(!result[i].current && err == ESP_OK)
+			{
+				memcpy(&config, upgrade_config, sizeof(esp_ota_http_upgrade_config_t));
+				config.partition = partitions[i];
+				config.no_activate = true;
+				if(upgrade_config->callback)
+				{
+					component.upgrade_config = upgrade_config;
+					component.component = i;
+					component.component_count = manifest->count;
+					config.callback = esp_ota_http_component_callback;
+					config.callback_arg = &component;
+				}
+				err = esp_ota_http_session_upgrade(session, url, &c->desc, &config);
+				result[i].read_bytes = session->attempt.read_bytes;
+			}
+			result[i].err = err;
+			result[i].elapsed_ms = (ESP_OTA_TIME_US() - t) / 1000;
+			debugPrintln
+				(
+					"%s: %s, %u(bytes) in %u ms, err=0x%x",
+					c->name,
+					result[i].current ? "current" : "written",
+					result[i].read_bytes,
+					result[i].elapsed_ms,
+					err
+				);
+		}
+	}
+	ESP_OTA_FREE(url);
+
+	/* all components are in place and verified */
+	if(err == ESP_OK && activate)
+	{
+		err = esp_ota_http_activate(upgrade_config, partitions[app]);
+		result[app].err = err;
+	}
+	if(results)
+	{
+		memcpy(results, result, manifest->count * sizeof(esp_ota_http_component_result_t));
+	}
+	return err;
+}
+
+esp_err_t esp_ota_http_upgrade_manifest
+(
+	const esp_http_client_config_t *config,
+	const esp_ota_http_upgrade_config_t *upgrade_config,
+	esp_ota_http_component_result_t *results
+)
+{
+	esp_ota_http_session_handle_t session;
+	esp_ota_desc_manifest_t *manifest;
+	esp_err_t err;
+
+	manifest = (esp_ota_desc_manifest_t *)ESP_OTA_MALLOC(sizeof(esp_ota_desc_manifest_t));
+	if(!manifest)
+	{
+		return ESP_ERR_NO_MEM;
+	}
+	err = esp_ota_http_session_open(config, &session);
+	if(ESP_OK != err)
+	{
+		ESP_OTA_FREE(manifest);
+		return err;
+	}
+	err = esp_ota_http_session_get_manifest(session, NULL, manifest);
+	if(ESP_OK == err)
+	{
+		err = esp_ota_http_session_upgrade_manifest(session, config->url, manifest, upgrade_config, results);
+		esp_ota_desc_manifest_free(manifest);
+	}
+	esp_ota_http_session_close(session);
+	ESP_OTA_FREE(manifest);
 	return err;
 }
 
@@ -61,6 +61,145 @@
 
 typedef void (*esp_ota_http_callback_t)(int err, int length, int total_length);
 
+typedef struct
+{
+	int err;
+	int length;
+	int total_length;	/* -1: unknown, chunked transfer */
+	unsigned int block_size;
+	uint32_t write_count;
+
+	/* pipelined mode back-pressure */
+	uint32_t reader_stalls;		/* ring full: flash/hash is the bottleneck */
+	uint32_t reader_wait_us;
+	uint32_t writer_stalls;		/* ring empty: network is the bottleneck */
+	uint32_t writer_wait_us;
+
+	uint32_t elapsed_ms;
+	uint32_t throughput;		/* bytes/s of this transfer */
+	int32_t eta_ms;				/* -1: unknown */
+	uint32_t callback_count;	/* including this one */
+	bool done;					/* final event, err is the result */
+
+	/* esp_ota_http_upgrade_manifest(): component index of count, 0 of 0: one image */
+	uint8_t component;
+	uint8_t component_count;
+}esp_ota_http_progress_t;
+
+typedef void (*esp_ota_http_progress_callback_t)(const esp_ota_http_progress_t *progress, void *arg);
+
+typedef struct
+{
+	unsigned int block_size;	/* flash write block, 0: ESP_OTA_FLASH_BLOCK_SIZE */
+	esp_ota_http_progress_callback_t callback;
+	void *callback_arg;
+
+	/* pipelined mode: a reader task feeds the hash/flash writer */
+	unsigned int pipeline_depth;		/* ring buffers, 0: disabled */
+	unsigned int pipeline_buffer_size;	/* 0: ESP_OTA_HTTP_PIPELINE_BUF_SIZE */
+	unsigned int pipeline_task_priority;	/* 0: ESP_OTA_HTTP_READER_PRIORITY */
+
+	/*
+	 * resume mode: progress is saved to NVS every checkpoint_sectors flash
+	 * sectors, the next call continues with "Range: bytes=N-", or starts
+	 * over when the server does not answer 206
+	 * 0: disabled
+	 */
+	unsigned int checkpoint_sectors;
+
+	/*
+	 * progress is delivered after progress_bytes or progress_interval_ms,
+	 * whichever comes first, the final event (done) is always delivered
+	 * 0, 0: every read
+	 */
+	uint32_t progress_bytes;
+	uint32_t progress_interval_ms;
+
+	/*
+	 * erase-ahead mode: flash sectors are erased just ahead of the writes,
+	 * overlapped with the network reads (pipelined mode), instead of the
+	 * whole image at the start, see esp_ota_http_stats_t.erase
+	 * 0: disabled
+	 */
+	unsigned int erase_ahead_sectors;
+
+	/*
+	 * write avoidance: every flash sector is compared with the partition
+	 * and only erased/written when it differs, e.g. a retried or resumed
+	 * upgrade, see esp_ota_http_stats_t.skip_count
+	 */
+	bool skip_same_sectors;
+
+	/* esp_ota_http_upgrade_mirrors(): bytes per Range request (flash sectors), 0: 32K */
+	uint32_t mirror_range_size;
+
+	/* SHA-256 of the image and blocks, NULL: ESP_OTA_HASH_DEFAULT (esp_ota_hash.h) */
+	const esp_ota_hash_backend_t *hash_backend;
+
+	/*
+	 * partition to write, NULL: the next OTA app partition
+	 * a data partition is written in place (no second copy to fall back
+	 * to), delta images and chunk sync need an app partition
+	 */
+	const esp_partition_t *partition;
+
+	/* the app is written and verified, the boot partition is left as it is */
+	bool no_activate;
+}esp_ota_http_upgrade_config_t;
+
+typedef struct
+{
+	uint32_t request_count;
+	uint32_t handshake_count;
+	uint32_t handshake_time_us;
+}esp_ota_http_session_stats_t;
+
+#define ESP_OTA_HTTP_STATS_READ_BUCKETS	(6)
+#define ESP_OTA_HTTP_MIRRORS_MAX		(8)
+
+typedef struct
+{
+	uint32_t count;
+	uint32_t time_us;
+	uint32_t max_us;
+}esp_ota_http_stage_stats_t;
+
+/*
+ * One esp_ota_http_get_desc()/esp_ota_http_upgrade() attempt, collected
+ * always (a timer read per stage call), see esp_ota_http_get_stats().
+ */
+typedef struct
+{
+	int err;
+	uint32_t total_us;
+
+	esp_ota_http_stage_stats_t connect;	/* esp_http_client_open, TLS handshake */
+	esp_ota_http_stage_stats_t headers;
+	esp_ota_http_stage_stats_t read;
+	esp_ota_http_stage_stats_t sha256;
+	esp_ota_http_stage_stats_t erase;
+	esp_ota_http_stage_stats_t write;
+	uint32_t skip_count;	/* flash sectors already holding the image */
+	uint32_t blank_count;	/* 0xFF flash pages left erased, direct writes only */
+
+	uint32_t read_bytes;
+	/* read sizes: <64, <256, <1K, <4K, <16K, >=16K bytes */
+	uint32_t read_histogram[ESP_OTA_HTTP_STATS_READ_BUCKETS];
+
+	uint32_t request_count;
+	uint32_t handshake_count;
+	uint32_t reconnect_count;	/* kept-alive connection was closed by the server */
+	uint32_t block_retry_count;	/* blocks rejected by the descriptor hash and fetched again */
+	uint32_t retry_after;		/* seconds of a Retry-After header, 0: none or an HTTP-date */
+	uint32_t free_heap_min;
+
+	/* ESP_OTA_PORT_ALLOC_STATS builds only */
+	uint32_t alloc_count;
+	uint32_t alloc_peak;		/* bytes above the start of the attempt */
+}esp_ota_http_stats_t;
+
+typedef struct esp_ota_http_session *esp_ota_http_session_handle_t;
+
 /** @brief esp_ota_nvs_set
  *
  *
@@ -72,6 +211,34 @@ esp_err_t esp_ota_http_get_desc
 		esp_ota_desc_t *desc
 	);
 
+/** @brief esp_ota_http_poll_desc
+ *
+ * Conditional esp_ota_http_get_desc(): the ETag/Last-Modified of the last
+ * descriptor of this url (NVS, esp_ota_nvs_desc_cache_t) go along as
+ * If-None-Match/If-Modified-Since. On 304 Not Modified nothing is read or
+ * parsed, desc is not set and changed is false. A changed descriptor is
+ * parsed into desc and cached with its validators.
+ *
+ * Unchanged is not "up to date": after a failed upgrade the descriptor is
+ * still the one of the server, see esp_ota_http_desc_cache_load().
+ */
+esp_err_t esp_ota_http_poll_desc
+	(
+		const esp_http_client_config_t *config,
+		esp_ota_desc_t *desc,
+		bool *changed
+	);
+
+/** @brief esp_ota_http_desc_cache_load
+ *
+ * Parse the descriptor cached by the last changed poll.
+ *
+ * @return  ESP_ERR_NOT_FOUND: only validators are cached (larger than
+ *          ESP_OTA_NVS_DESC_CACHE_SIZE), poll with esp_ota_http_get_desc()
+ *          ESP_ERR_NVS_NOT_FOUND: nothing cached
+ */
+esp_err_t esp_ota_http_desc_cache_load(esp_ota_desc_t *desc);
+
 esp_err_t esp_ota_http_upgrade
 	(
 		const esp_http_client_config_t *config,
@@ -79,4 +246,269 @@ esp_err_t esp_ota_http_upgrade
 		esp_ota_http_callback_t callback
 	);
 
+/** @brief esp_ota_http_upgrade_ext
+ *
+ * Same as esp_ota_http_upgrade() with runtime options.
+ *
+ * @param upgrade_config  NULL: defaults
+ * @return  ESP_ERR_INVALID_VERSION: desc is a delta for another base image
+ *          ESP_ERR_NOT_SUPPORTED: desc has a block list, the server has no Range support
+ *          ESP_ERR_INVALID_CRC: a block kept failing its hash in desc->blocks
+ *          ESP_ERR_INVALID_SIZE: the image doesn't fit the partition, or
+ *          Content-Length doesn't match desc->size
+ */
+esp_err_t esp_ota_http_upgrade_ext
+	(
+		const esp_http_client_config_t *config,
+		const esp_ota_desc_t *desc,
+		const esp_ota_http_upgrade_config_t *upgrade_config
+	);
+
+/** @brief esp_ota_http_upgrade_mirrors
+ *
+ * Same as esp_ota_http_upgrade_ext() with the image on several servers:
+ * ranges of the image are fetched from all mirrors at once, one task and
+ * TLS connection per mirror, and written directly into the partition. A
+ * range that fails on a mirror is fetched from another one. When no range
+ * is left, idle mirrors also fetch the busy ones and every block is written
+ * by the first mirror that has it (end-game). The image is verified by
+ * reading it back. Plain images only, no checkpoints.
+ *
+ * @param configs  count (up to ESP_OTA_HTTP_MIRRORS_MAX) configs of the image url
+ * @return  ESP_ERR_NOT_SUPPORTED: desc is compressed or a delta
+ */
+esp_err_t esp_ota_http_upgrade_mirrors
+	(
+		const esp_http_client_config_t *configs,
+		unsigned int count,
+		const esp_ota_desc_t *desc,
+		const esp_ota_http_upgrade_config_t *upgrade_config
+	);
+
+/*
+ * Step-driven upgrade for a main loop, nothing blocks for the whole
+ * download: every esp_ota_http_upgrade_step() does one stage (request,
+ * response headers, final check and boot partition) or one read of at most
+ * a flash block and its write. The partition is erased along the way
+ * (erase_ahead_sectors defaults to 1), pipelining and chunk sync are not
+ * used. A step still waits for the network up to the timeout_ms of the
+ * esp_http_client config, the TLS handshake is part of the first one.
+ * Plain images only: a compressed or delta step would not be bounded.
+ *
+ *	esp_ota_http_upgrade_begin(&config, &desc, NULL, &handle);
+ *	while((err = esp_ota_http_upgrade_step(handle)) == ESP_ERR_OTA_HTTP_IN_PROGRESS)
+ *	{
+ *		... the application's own work
+ *	}
+ *	err = esp_ota_http_upgrade_finish(handle);
+ *
+ * desc and url must stay valid until finish/cancel.
+ */
+
+/* esp_ota_http_upgrade_step(): more steps to go */
+#define ESP_ERR_OTA_HTTP_IN_PROGRESS	(ESP_ERR_OTA_BASE + 0x80)
+/* progress.err of a cancelled upgrade */
+#define ESP_ERR_OTA_HTTP_CANCELLED		(ESP_ERR_OTA_BASE + 0x81)
+
+typedef struct esp_ota_http_async *esp_ota_http_upgrade_handle_t;
+
+/** @brief esp_ota_http_upgrade_begin
+ *
+ *
+ * @return  ESP_ERR_NOT_SUPPORTED: desc is compressed or a delta, use
+ *          esp_ota_http_upgrade_ext()
+ */
+esp_err_t esp_ota_http_upgrade_begin
+	(
+		const esp_http_client_config_t *config,
+		const esp_ota_desc_t *desc,
+		const esp_ota_http_upgrade_config_t *upgrade_config,
+		esp_ota_http_upgrade_handle_t *handle
+	);
+
+/** @brief esp_ota_http_upgrade_step
+ *
+ *
+ * @return  ESP_ERR_OTA_HTTP_IN_PROGRESS: call again, else the result as
+ *          esp_ota_http_upgrade_ext() (ESP_OK: the boot partition is set)
+ */
+esp_err_t esp_ota_http_upgrade_step(esp_ota_http_upgrade_handle_t handle);
+
+void esp_ota_http_upgrade_get_progress
+	(
+		esp_ota_http_upgrade_handle_t handle,
+		esp_ota_http_progress_t *progress
+	);
+
+/** @brief esp_ota_http_upgrade_finish
+ *
+ * Release the handle after the last step.
+ *
+ * @return  the result of the upgrade, ESP_ERR_INVALID_STATE: steps were
+ *          left, the upgrade is cancelled
+ */
+esp_err_t esp_ota_http_upgrade_finish(esp_ota_http_upgrade_handle_t handle);
+
+/** @brief esp_ota_http_upgrade_cancel
+ *
+ * Stop at any step: the connection, update handle, flash buffer and hash
+ * contexts are released, the partition is left as it is (a checkpoint
+ * stays usable). The final progress event has ESP_ERR_OTA_HTTP_CANCELLED.
+ */
+esp_err_t esp_ota_http_upgrade_cancel(esp_ota_http_upgrade_handle_t handle);
+
+/** @brief esp_ota_http_get_stats
+ *
+ * Statistics of the last descriptor or upgrade attempt, also of a session.
+ */
+void esp_ota_http_get_stats(esp_ota_http_stats_t *stats);
+
+/*
+ * Session: descriptor and image are requested over one esp_http_client,
+ * the TLS connection is kept open between requests (HTTP keep-alive) and
+ * only re-established when the server closes it or the host changes.
+ */
+
+/** @brief esp_ota_http_session_open
+ *
+ * The connection is made by the first request.
+ */
+esp_err_t esp_ota_http_session_open
+	(
+		const esp_http_client_config_t *config,
+		esp_ota_http_session_handle_t *out
+	);
+
+/** @brief esp_ota_http_session_get_desc
+ *
+ *
+ * @param url  NULL: config->url
+ */
+esp_err_t esp_ota_http_session_get_desc
+	(
+		esp_ota_http_session_handle_t session,
+		const char *url,
+		esp_ota_desc_t *desc
+	);
+
+/** @brief esp_ota_http_session_poll_desc
+ *
+ * esp_ota_http_poll_desc() over the session.
+ *
+ * @param url  NULL: url of the previous request
+ */
+esp_err_t esp_ota_http_session_poll_desc
+	(
+		esp_ota_http_session_handle_t session,
+		const char *url,
+		esp_ota_desc_t *desc,
+		bool *changed
+	);
+
+/** @brief esp_ota_http_session_upgrade
+ *
+ *
+ * @param url  NULL: url of the previous request
+ */
+esp_err_t esp_ota_http_session_upgrade
+	(
+		esp_ota_http_session_handle_t session,
+		const char *url,
+		const esp_ota_desc_t *desc,
+		const esp_ota_http_upgrade_config_t *upgrade_config
+	);
+
+/** @brief esp_ota_http_session_upgrade_begin
+ *
+ * esp_ota_http_upgrade_begin() over the session, it stays open after finish.
+ *
+ * @param url  NULL: url of the previous request
+ */
+esp_err_t esp_ota_http_session_upgrade_begin
+	(
+		esp_ota_http_session_handle_t session,
+		const char *url,
+		const esp_ota_desc_t *desc,
+		const esp_ota_http_upgrade_config_t *upgrade_config,
+		esp_ota_http_upgrade_handle_t *handle
+	);
+
+void esp_ota_http_session_get_stats
+	(
+		esp_ota_http_session_handle_t session,
+		esp_ota_http_session_stats_t *stats
+	);
+
+esp_err_t esp_ota_http_session_close(esp_ota_http_session_handle_t session);
+
+/*
+ * Manifest (esp_ota_desc.h): app, data and filesystem partitions of one
+ * release are updated over one session. All targets are checked first
+ * (found, not running, large enough, one app), components whose partition
+ * already holds the image are skipped, the app is written to the passive
+ * slot first and the data partitions after it. The boot partition is
+ * switched only when every component is written and verified.
+ *
+ * Data partitions have no second copy: they are written in place, a
+ * failure among them leaves the ones written before updated and the old
+ * app booting. A new call skips what is already in place, the app in the
+ * passive slot included, and finishes the rest.
+ */
+typedef struct
+{
+	esp_err_t err;
+	bool current;			/* the partition held the image, nothing was fetched */
+	uint32_t read_bytes;
+	uint32_t elapsed_ms;	/* including the check of the partition */
+}esp_ota_http_component_result_t;
+
+/** @brief esp_ota_http_session_get_manifest
+ *
+ * A manifest of at most ESP_OTA_HTTP_MANIFEST_SIZE - 1 bytes.
+ *
+ * @param url  NULL: url of the previous request
+ * @return  ESP_OK: release with esp_ota_desc_manifest_free()
+ */
+esp_err_t esp_ota_http_session_get_manifest
+	(
+		esp_ota_http_session_handle_t session,
+		const char *url,
+		esp_ota_desc_manifest_t *manifest
+	);
+
+/** @brief esp_ota_http_session_upgrade_manifest
+ *
+ * Every component is an esp_ota_http_session_upgrade() with
+ * upgrade_config, its progress events carry the component index.
+ *
+ * @param base_url  url of the manifest, relative component urls, NULL: none
+ * @param results  manifest->count entries, NULL: not needed
+ * @return  ESP_ERR_NOT_FOUND: no partition of a component label
+ *          ESP_ERR_INVALID_ARG: a component targets the running partition,
+ *          a partition twice, or a second app
+ *          ESP_ERR_INVALID_SIZE: an image doesn't fit its partition
+ *          else the error of the failed component
+ */
+esp_err_t esp_ota_http_session_upgrade_manifest
+	(
+		esp_ota_http_session_handle_t session,
+		const char *base_url,
+		const esp_ota_desc_manifest_t *manifest,
+		const esp_ota_http_upgrade_config_t *upgrade_config,
+		esp_ota_http_component_result_t *results
+	);
+
+/** @brief esp_ota_http_upgrade_manifest
+ *
+ * Fetch the manifest of config->url and apply it over the same session.
+ *
+ * @param results  ESP_OTA_DESC_MANIFEST_COMPONENTS entries, NULL: not needed
+ */
+esp_err_t esp_ota_http_upgrade_manifest
+	(
+		const esp_http_client_config_t *config,
+		const esp_ota_http_upgrade_config_t *upgrade_config,
+		esp_ota_http_component_result_t *results
+	);
+
 #endif
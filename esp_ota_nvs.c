@@ -49,6 +49,7 @@
 *****************************************************************************/
 
 #include <stdint.h>
+#include <stddef.h>
 #include <string.h>
 
 #include "esp_system.h"
@@ -81,6 +82,22 @@
 #define ESP_OTA_NVS_RESTART_COUNTER_KEY	"restart_conter"
 #endif
 
+#ifndef ESP_OTA_NVS_CHECKPOINT_KEY
+#define ESP_OTA_NVS_CHECKPOINT_KEY	"ota_checkpoint"
+#endif
+
+#ifndef ESP_OTA_NVS_DESC_CACHE_KEY
+#define ESP_OTA_NVS_DESC_CACHE_KEY	"ota_desc_cache"
+#endif
+
+#ifndef ESP_OTA_NVS_DESC_BODY_KEY
+#define ESP_OTA_NVS_DESC_BODY_KEY	"ota_desc_body"
+#endif
+
+#ifndef ESP_OTA_NVS_SCHED_KEY
+#define ESP_OTA_NVS_SCHED_KEY	"ota_sched"
+#endif
+
 #define ESP_OTA_FLAG_UPGRADE	(1<<0)
 #define ESP_OTA_FLAG_DOWNGRADE	(1<<1)
 
@@ -360,6 +377,309 @@ esp_err_t esp_ota_nvs_factory(uint8_t version_major, uint8_t version_minor)
 	return esp_ota_nvs_set(&ota_write);
 }
 
+esp_err_t esp_ota_nvs_checkpoint_set(esp_ota_nvs_checkpoint_t *checkpoint)
+{
+	nvs_handle my_handle;
+	esp_err_t err;
+
+	checkpoint->crc = crc8((uint8_t *)checkpoint, offsetof(esp_ota_nvs_checkpoint_t, crc));
+
+	// Open
+	err = nvs_open(ESP_OTA_NVS_STORAGE, NVS_READWRITE, &my_handle);
+	if (err != ESP_OK)
+	{
+		debugPrintln("%s: return error: 0x%x", "nvs_open", err);
+		return err;
+	}
+
+	err = nvs_set_blob(my_handle, ESP_OTA_NVS_CHECKPOINT_KEY, checkpoint, sizeof(esp_ota_nvs_checkpoint_t));
+	if (err != ESP_OK)
+	{
+		debugPrintln("%s: return error: 0x%x", "nvs_set_blob", err);
+		nvs_close(my_handle);
+		return err;
+	}
+
+	err = nvs_commit(my_handle);
+	if (err != ESP_OK)
+	{
+		debugPrintln("%s: return error: 0x%x", "nvs_commit", err);
+	}
+
+	// Close
+	nvs_close(my_handle);
+	return err;
+}
+
+esp_err_t esp_ota_nvs_checkpoint_get(esp_ota_nvs_checkpoint_t *checkpoint)
+{
+	nvs_handle my_handle;
+	esp_err_t err;
+	size_t length;
+
+	// Open
+	err = nvs_open(ESP_OTA_NVS_STORAGE, NVS_READONLY, &my_handle);
+	if (err != ESP_OK)
+	{
+		debugPrintln("%s: return error: 0x%x", "nvs_open", err);
+		return err;
+	}
+
+	length = sizeof(esp_ota_nvs_checkpoint_t);
+	err = nvs_get_blob(my_handle, ESP_OTA_NVS_CHECKPOINT_KEY, checkpoint, &length);
+
+	// Close
+	nvs_close(my_handle);
+	if (err != ESP_OK)
+	{
+		debugPrintln("%s: return error: 0x%x", "nvs_get_blob", err);
+		return err;
+	}
+	if(length != sizeof(esp_ota_nvs_checkpoint_t) ||
+		checkpoint->crc != crc8((uint8_t *)checkpoint, offsetof(esp_ota_nvs_checkpoint_t, crc)))
+	{
+		debugPrintln("%s: checkpoint is invalid", "nvs_get_blob");
+		return ESP_FAIL;
+	}
+	return ESP_OK;
+}
+
+esp_err_t esp_ota_nvs_checkpoint_clear(void)
+{
+	nvs_handle my_handle;
+	esp_err_t err;
+
+	// Open
+	err = nvs_open(ESP_OTA_NVS_STORAGE, NVS_READWRITE, &my_handle);
+	if (err != ESP_OK)
+	{
+		debugPrintln("%s: return error: 0x%x", "nvs_open", err);
+		return err;
+	}
+
+	err = nvs_erase_key(my_handle, ESP_OTA_NVS_CHECKPOINT_KEY);
+	if (err == ESP_ERR_NVS_NOT_FOUND)
+	{
+		nvs_close(my_handle);
+		return ESP_OK;
+	}
+	else if (err != ESP_OK)
+	{
+		debugPrintln("%s: return error: 0x%x", "nvs_erase_key", err);
+		nvs_close(my_handle);
+		return err;
+	}
+
+	err = nvs_commit(my_handle);
+
+	// Close
+	nvs_close(my_handle);
+	return err;
+}
+
+esp_err_t esp_ota_nvs_desc_cache_set(esp_ota_nvs_desc_cache_t *cache, const char *body)
+{
+	nvs_handle my_handle;
+	esp_err_t err;
+
+	if(!body || cache->length > ESP_OTA_NVS_DESC_CACHE_SIZE)
+	{
+		cache->length = 0;
+	}
+	cache->body_crc = cache->length ? crc8((uint8_t *)body, cache->length) : 0;
+	cache->crc = crc8((uint8_t *)cache, offsetof(esp_ota_nvs_desc_cache_t, crc));
+
+	// Open
+	err = nvs_open(ESP_OTA_NVS_STORAGE, NVS_READWRITE, &my_handle);
+	if (err != ESP_OK)
+	{
+		debugPrintln("%s: return error: 0x%x", "nvs_open", err);
+		return err;
+	}
+
+	// the body first, a cache entry never points to an older body
+	if(cache->length)
+	{
+		err = nvs_set_blob(my_handle, ESP_OTA_NVS_DESC_BODY_KEY, body, cache->length);
+	}
+	else
+	{
+		err = nvs_erase_key(my_handle, ESP_OTA_NVS_DESC_BODY_KEY);
+		if (err == ESP_ERR_NVS_NOT_FOUND)
+		{
+			err = ESP_OK;
+		}
+	}
+	if (err == ESP_OK)
+	{
+		err = nvs_set_blob(my_handle, ESP_OTA_NVS_DESC_CACHE_KEY, cache, sizeof(esp_ota_nvs_desc_cache_t));
+	}
+	if (err != ESP_OK)
+	{
+		debugPrintln("%s: return error: 0x%x", "nvs_set_blob", err);
+		nvs_close(my_handle);
+		return err;
+	}
+
+	err = nvs_commit(my_handle);
+	if (err != ESP_OK)
+	{
+		debugPrintln("%s: return error: 0x%x", "nvs_commit", err);
+	}
+
+	// Close
+	nvs_close(my_handle);
+	return err;
+}
+
+esp_err_t esp_ota_nvs_desc_cache_get(esp_ota_nvs_desc_cache_t *cache, char *body)
+{
+	nvs_handle my_handle;
+	esp_err_t err;
+	size_t length;
+
+	// Open
+	err = nvs_open(ESP_OTA_NVS_STORAGE, NVS_READONLY, &my_handle);
+	if (err != ESP_OK)
+	{
+		debugPrintln("%s: return error: 0x%x", "nvs_open", err);
+		return err;
+	}
+
+	length = sizeof(esp_ota_nvs_desc_cache_t);
+	err = nvs_get_blob(my_handle, ESP_OTA_NVS_DESC_CACHE_KEY, cache, &length);
+	if (err == ESP_OK &&
+		(length != sizeof(esp_ota_nvs_desc_cache_t) ||
+		cache->crc != crc8((uint8_t *)cache, offsetof(esp_ota_nvs_desc_cache_t, crc)) ||
+		cache->length > ESP_OTA_NVS_DESC_CACHE_SIZE))
+	{
+		debugPrintln("%s: descriptor cache is invalid", "nvs_get_blob");
+		err = ESP_FAIL;
+	}
+	if (err == ESP_OK && body && cache->length)
+	{
+		length = cache->length;
+		err = nvs_get_blob(my_handle, ESP_OTA_NVS_DESC_BODY_KEY, body, &length);
+		if (err == ESP_OK &&
+			(length != cache->length || cache->body_crc != crc8((uint8_t *)body, length)))
+		{
+			debugPrintln("%s: descriptor body is invalid", "nvs_get_blob");
+			err = ESP_FAIL;
+		}
+	}
+
+	// Close
+	nvs_close(my_handle);
+	if (err != ESP_OK)
+	{
+		debugPrintln("%s: return error: 0x%x", "nvs_get_blob", err);
+	}
+	return err;
+}
+
+esp_err_t esp_ota_nvs_desc_cache_clear(void)
+{
+	nvs_handle my_handle;
+	esp_err_t err;
+
+	// Open
+	err = nvs_open(ESP_OTA_NVS_STORAGE, NVS_READWRITE, &my_handle);
+	if (err != ESP_OK)
+	{
+		debugPrintln("%s: return error: 0x%x", "nvs_open", err);
+		return err;
+	}
+
+	err = nvs_erase_key(my_handle, ESP_OTA_NVS_DESC_CACHE_KEY);
+	if (err == ESP_OK || err == ESP_ERR_NVS_NOT_FOUND)
+	{
+		err = nvs_erase_key(my_handle, ESP_OTA_NVS_DESC_BODY_KEY);
+	}
+	if (err == ESP_ERR_NVS_NOT_FOUND)
+	{
+		err = ESP_OK;
+	}
+	if (err == ESP_OK)
+	{
+		err = nvs_commit(my_handle);
+	}
+	else
+	{
+		debugPrintln("%s: return error: 0x%x", "nvs_erase_key", err);
+	}
+
+	// Close
+	nvs_close(my_handle);
+	return err;
+}
+
+esp_err_t esp_ota_nvs_sched_set(esp_ota_nvs_sched_t *sched)
+{
+	nvs_handle my_handle;
+	esp_err_t err;
+
+	sched->crc = crc8((uint8_t *)sched, offsetof(esp_ota_nvs_sched_t, crc));
+
+	// Open
+	err = nvs_open(ESP_OTA_NVS_STORAGE, NVS_READWRITE, &my_handle);
+	if (err != ESP_OK)
+	{
+		debugPrintln("%s: return error: 0x%x", "nvs_open", err);
+		return err;
+	}
+
+	err = nvs_set_blob(my_handle, ESP_OTA_NVS_SCHED_KEY, sched, sizeof(esp_ota_nvs_sched_t));
+	if (err != ESP_OK)
+	{
+		debugPrintln("%s: return error: 0x%x", "nvs_set_blob", err);
+		nvs_close(my_handle);
+		return err;
+	}
+
+	err = nvs_commit(my_handle);
+	if (err != ESP_OK)
+	{
+		debugPrintln("%s: return error: 0x%x", "nvs_commit", err);
+	}
+
+	// Close
+	nvs_close(my_handle);
+	return err;
+}
+
+esp_err_t esp_ota_nvs_sched_get(esp_ota_nvs_sched_t *sched)
+{
+	nvs_handle my_handle;
+	esp_err_t err;
+	size_t length;
+
+	// Open
+	err = nvs_open(ESP_OTA_NVS_STORAGE, NVS_READONLY, &my_handle);
+	if (err != ESP_OK)
+	{
+		debugPrintln("%s: return error: 0x%x", "nvs_open", err);
+		return err;
+	}
+
+	length = sizeof(esp_ota_nvs_sched_t);
+	err = nvs_get_blob(my_handle, ESP_OTA_NVS_SCHED_KEY, sched, &length);
+
+	// Close
+	nvs_close(my_handle);
+	if (err != ESP_OK)
+	{
+		debugPrintln("%s: return error: 0x%x", "nvs_get_blob", err);
+		return err;
+	}
+	if(length != sizeof(esp_ota_nvs_sched_t) ||
+		sched->crc != crc8((uint8_t *)sched, offsetof(esp_ota_nvs_sched_t, crc)))
+	{
+		debugPrintln("%s: sched is invalid", "nvs_get_blob");
+		return ESP_FAIL;
+	}
+	return ESP_OK;
+}
+
 /*
  * EOF
  */
@@ -104,4 +104,99 @@ esp_err_t esp_ota_nvs_set_upgrade_complete(void);
 
 esp_err_t esp_ota_nvs_factory(uint8_t version_major, uint8_t version_minor);
 
+/*
+ * Progress of an interrupted upgrade, offset is flash sector aligned and
+ * sha256_total/sha256_state hold the SHA-256 midstate of the first
+ * offset bytes of the image.
+ */
+typedef struct
+{
+	uint32_t offset;
+	uint32_t partition_address;
+	uint8_t desc_sha256[32];
+	uint32_t sha256_total[2];
+	uint32_t sha256_state[8];
+	uint8_t crc;
+}esp_ota_nvs_checkpoint_t;
+
+/** @brief esp_ota_nvs_checkpoint_set
+ *
+ *
+ * @param checkpoint  crc is calculated
+ */
+esp_err_t esp_ota_nvs_checkpoint_set(esp_ota_nvs_checkpoint_t *checkpoint);
+
+/** @brief esp_ota_nvs_checkpoint_get
+ *
+ *
+ * @return  ESP_ERR_NVS_NOT_FOUND: no checkpoint, ESP_FAIL: crc error
+ */
+esp_err_t esp_ota_nvs_checkpoint_get(esp_ota_nvs_checkpoint_t *checkpoint);
+
+esp_err_t esp_ota_nvs_checkpoint_clear(void);
+
+/*
+ * Last descriptor with its HTTP validators, for conditional polling. The
+ * body is only kept up to ESP_OTA_NVS_DESC_CACHE_SIZE bytes (one NVS blob),
+ * a larger descriptor is cached as validators only (length 0).
+ */
+#define ESP_OTA_NVS_ETAG_LENGTH		(64)
+#define ESP_OTA_NVS_DATE_LENGTH		(32)	/* "Sun, 06 Nov 1994 08:49:37 GMT" */
+
+#ifndef ESP_OTA_NVS_DESC_CACHE_SIZE
+#define ESP_OTA_NVS_DESC_CACHE_SIZE	(1536)
+#endif
+
+typedef struct
+{
+	uint8_t url_sha256[32];
+	char etag[ESP_OTA_NVS_ETAG_LENGTH];
+	char last_modified[ESP_OTA_NVS_DATE_LENGTH];
+	uint32_t length;	/* body bytes, 0: not stored */
+	uint8_t body_crc;
+	uint8_t crc;
+}esp_ota_nvs_desc_cache_t;
+
+/** @brief esp_ota_nvs_desc_cache_set
+ *
+ *
+ * @param cache  crc and body_crc are calculated
+ * @param body  cache->length bytes, NULL: validators only
+ */
+esp_err_t esp_ota_nvs_desc_cache_set(esp_ota_nvs_desc_cache_t *cache, const char *body);
+
+/** @brief esp_ota_nvs_desc_cache_get
+ *
+ *
+ * @param body  NULL: validators only, else ESP_OTA_NVS_DESC_CACHE_SIZE bytes
+ * @return  ESP_ERR_NVS_NOT_FOUND: nothing cached, ESP_FAIL: crc error
+ */
+esp_err_t esp_ota_nvs_desc_cache_get(esp_ota_nvs_desc_cache_t *cache, char *body);
+
+esp_err_t esp_ota_nvs_desc_cache_clear(void);
+
+/* esp_ota_sched state, kept across reboots */
+typedef struct
+{
+	uint32_t failures;		/* consecutive failed checks */
+	uint32_t retry_after;	/* seconds asked by the server, 0: none */
+	uint32_t next_time;		/* wall clock of the next check, 0: no clock */
+	uint32_t count;			/* checks done */
+	uint8_t crc;
+}esp_ota_nvs_sched_t;
+
+/** @brief esp_ota_nvs_sched_set
+ *
+ *
+ * @param sched  crc is calculated
+ */
+esp_err_t esp_ota_nvs_sched_set(esp_ota_nvs_sched_t *sched);
+
+/** @brief esp_ota_nvs_sched_get
+ *
+ *
+ * @return  ESP_ERR_NVS_NOT_FOUND: no state, ESP_FAIL: crc error
+ */
+esp_err_t esp_ota_nvs_sched_get(esp_ota_nvs_sched_t *sched);
+
 #endif
@@ -0,0 +1,290 @@
+/*****************************************************************************
+* File Name: esp_ota_patch.c
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "esp_system.h"
+#include "esp_partition.h"
+
+#include "esp_ota_hash.h"
+#include "esp_ota_patch.h"
+
+#ifdef ESP_OTA_DEBUG_ENABLED
+#ifndef debugPrintln
+#define debugPrintln(fmt,args...)	\
+	printf("esp-ota-patch: " fmt "%s", ## args, "\r\n")
+#endif
+#else
+#define debugPrintln(...)
+#endif
+
+enum
+{
+	ESP_OTA_PATCH_MAGIC_STATE = 0,
+	ESP_OTA_PATCH_OP_STATE,
+	ESP_OTA_PATCH_ARGS_STATE,
+	ESP_OTA_PATCH_DATA_STATE,
+	ESP_OTA_PATCH_END_STATE
+};
+
+static inline uint32_t esp_ota_patch_u32(const uint8_t *p)
+{
+	return ((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+static esp_err_t esp_ota_patch_copy(esp_ota_patch_t *patch, uint32_t offset, uint32_t length)
+{
+	unsigned int n;
+	esp_err_t err;
+
+	if(offset > patch->base_size || length > patch->base_size - offset)
+	{
+		debugPrintln("copy out of base: %u+%u", offset, length);
+		return ESP_ERR_INVALID_SIZE;
+	}
+
+	for(; length; length -= n, offset += n)
+	{
+		n = (length < ESP_OTA_PATCH_READ_SIZE) ? length : ESP_OTA_PATCH_READ_SIZE;
+		err = esp_partition_read(patch->base, offset, patch->buffer, n);
+		if(err != ESP_OK)
+		{
+			debugPrintln("base read failed at %u: 0x%x", offset, err);
+			return err;
+		}
+		err = patch->callback(patch->callback_arg, patch->buffer, n);
+		if(err != ESP_OK)
+		{
+			return err;
+		}
+		patch->output_length += n;
+	}
+	return ESP_OK;
+}
+
+/* arguments of the current op are complete */
+static esp_err_t esp_ota_patch_op(esp_ota_patch_t *patch)
+{
+	esp_err_t err;
+
+	patch->field_length = 0;
+	if(patch->op == ESP_OTA_PATCH_OP_COPY)
+	{
+		err = esp_ota_patch_copy
+			(
+				patch,
+				esp_ota_patch_u32(&patch->field[0]),
+				esp_ota_patch_u32(&patch->field[4])
+			);
+		patch->state = ESP_OTA_PATCH_OP_STATE;
+		return err;
+	}
+
+	patch->length = esp_ota_patch_u32(&patch->field[0]);
+	patch->state = patch->length ? ESP_OTA_PATCH_DATA_STATE : ESP_OTA_PATCH_OP_STATE;
+	return ESP_OK;
+}
+
+esp_err_t esp_ota_patch_init
+	(
+		esp_ota_patch_t *patch,
+		const esp_partition_t *base,
+		uint32_t base_size,
+		esp_ota_patch_output_t callback,
+		void *callback_arg
+	)
+{
+	memset(patch, 0, sizeof(esp_ota_patch_t));
+	if(!base || !base_size || base_size > base->size)
+	{
+		debugPrintln("invalid base size: %u", base_size);
+		return ESP_ERR_INVALID_ARG;
+	}
+	patch->base = base;
+	patch->base_size = base_size;
+	patch->state = ESP_OTA_PATCH_MAGIC_STATE;
+	patch->callback = callback;
+	patch->callback_arg = callback_arg;
+	return ESP_OK;
+}
+
+esp_err_t esp_ota_patch_check_base(esp_ota_patch_t *patch, const uint8_t *sha256)
+{
+	esp_ota_hash_t ctx;
+	uint8_t hash[32];
+	uint32_t offset;
+	unsigned int n;
+	esp_err_t err = ESP_OK;
+
+	esp_ota_hash_init(&ctx, NULL);
+	for(offset = 0; offset < patch->base_size; offset += n)
+	{
+		n = patch->base_size - offset;
+		if(n > ESP_OTA_PATCH_READ_SIZE)
+		{
+			n = ESP_OTA_PATCH_READ_SIZE;
+		}
+		err = esp_partition_read(patch->base, offset, patch->buffer, n);
+		if(err != ESP_OK)
+		{
+			break;
+		}
+		esp_ota_hash_update(&ctx, patch->buffer, n);
+	}
+	if(err == ESP_OK)
+	{
+		esp_ota_hash_finish(&ctx, hash);
+		if(memcmp(hash, sha256, 32))
+		{
+			debugPrintln("base sha256: is not match");
+			err = ESP_ERR_INVALID_VERSION;
+		}
+	}
+	esp_ota_hash_free(&ctx);
+	return err;
+}
+
+esp_err_t esp_ota_patch_write(esp_ota_patch_t *patch, const uint8_t *data, unsigned int length)
+{
+	unsigned int n;
+	esp_err_t err;
+
+	while(length)
+	{
+		switch(patch->state)
+		{
+		case ESP_OTA_PATCH_MAGIC_STATE:
+			patch->field[patch->field_length++] = *data++;
+			length--;
+			if(patch->field_length < 4)
+			{
+				break;
+			}
+			if(memcmp(patch->field, ESP_OTA_PATCH_MAGIC, 4))
+			{
+				debugPrintln("bad magic");
+				return ESP_ERR_INVALID_ARG;
+			}
+			patch->field_length = 0;
+			patch->state = ESP_OTA_PATCH_OP_STATE;
+			break;
+
+		case ESP_OTA_PATCH_OP_STATE:
+			patch->op = *data++;
+			length--;
+			if(patch->op == ESP_OTA_PATCH_OP_END)
+			{
+				patch->state = ESP_OTA_PATCH_END_STATE;
+			}
+			else if(patch->op == ESP_OTA_PATCH_OP_COPY || patch->op == ESP_OTA_PATCH_OP_DATA)
+			{
+				patch->state = ESP_OTA_PATCH_ARGS_STATE;
+			}
+			else
+			{
+				debugPrintln("unknown op: 0x%02x", patch->op);
+				return ESP_ERR_INVALID_ARG;
+			}
+			break;
+
+		case ESP_OTA_PATCH_ARGS_STATE:
+			patch->field[patch->field_length++] = *data++;
+			length--;
+			if(patch->field_length < ((patch->op == ESP_OTA_PATCH_OP_COPY) ? 8 : 4))
+			{
+				break;
+			}
+			err = esp_ota_patch_op(patch);
+			if(err != ESP_OK)
+			{
+				return err;
+			}
+			break;
+
+		case ESP_OTA_PATCH_DATA_STATE:
+			n = (length < patch->length) ? length : patch->length;
+			err = patch->callback(patch->callback_arg, data, n);
+			if(err != ESP_OK)
+			{
+				return err;
+			}
+			patch->output_length += n;
+			patch->length -= n;
+			data += n;
+			length -= n;
+			if(!patch->length)
+			{
+				patch->state = ESP_OTA_PATCH_OP_STATE;
+			}
+			break;
+
+		default:
+			debugPrintln("data after the end op: %u(bytes)", length);
+			return ESP_ERR_INVALID_SIZE;
+		}
+	}
+	return ESP_OK;
+}
+
+esp_err_t esp_ota_patch_finish(esp_ota_patch_t *patch)
+{
+	if(patch->state != ESP_OTA_PATCH_END_STATE)
+	{
+		debugPrintln("truncated patch, state %u", patch->state);
+		return ESP_ERR_INVALID_SIZE;
+	}
+	return ESP_OK;
+}
+
+/*
+ * EOF
+ */
@@ -0,0 +1,130 @@
+/*****************************************************************************
+* File Name: esp_ota_patch.h
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+
+/*******************************************************************************
+* User defined Macros
+*******************************************************************************/
+
+#ifndef ESP_OTA_PATCH_H
+#define ESP_OTA_PATCH_H
+
+#ifndef ESP_OTA_PATCH_READ_SIZE
+#define ESP_OTA_PATCH_READ_SIZE	(256)
+#endif
+
+#define ESP_OTA_PATCH_MAGIC		"EOP1"
+
+#define ESP_OTA_PATCH_OP_END	(0x00)
+#define ESP_OTA_PATCH_OP_COPY	(0x01)
+#define ESP_OTA_PATCH_OP_DATA	(0x02)
+
+typedef esp_err_t (*esp_ota_patch_output_t)(void *arg, const uint8_t *data, unsigned int length);
+
+/*
+ * Streaming patch against a base partition (tools/esp_ota_patch.py),
+ * all integers are little endian:
+ *   "EOP1"
+ *   0x01, offset[4], length[4]  copy length bytes of the base from offset
+ *   0x02, length[4], data[]     literal data
+ *   0x00                        end of patch
+ * The new image is the concatenation of the op outputs.
+ */
+typedef struct
+{
+	const esp_partition_t *base;
+	uint32_t base_size;
+
+	uint8_t state;
+	uint8_t op;
+	uint8_t field_length;
+	uint8_t field[8];
+	uint32_t length;
+
+	uint32_t output_length;
+	uint8_t buffer[ESP_OTA_PATCH_READ_SIZE];
+	esp_ota_patch_output_t callback;
+	void *callback_arg;
+}esp_ota_patch_t;
+
+/** @brief esp_ota_patch_init
+ *
+ *
+ * @param base  partition holding the base image, usually the running one
+ * @param base_size  copy ops must stay inside
+ */
+esp_err_t esp_ota_patch_init
+	(
+		esp_ota_patch_t *patch,
+		const esp_partition_t *base,
+		uint32_t base_size,
+		esp_ota_patch_output_t callback,
+		void *callback_arg
+	);
+
+/** @brief esp_ota_patch_check_base
+ *
+ * Hash the base image, the patch only applies to the exact base.
+ */
+esp_err_t esp_ota_patch_check_base(esp_ota_patch_t *patch, const uint8_t *sha256);
+
+esp_err_t esp_ota_patch_write(esp_ota_patch_t *patch, const uint8_t *data, unsigned int length);
+
+/** @brief esp_ota_patch_finish
+ *
+ *
+ * @return  ESP_ERR_INVALID_SIZE: the end op is missing
+ */
+esp_err_t esp_ota_patch_finish(esp_ota_patch_t *patch);
+
+#endif
@@ -0,0 +1,340 @@
+/*****************************************************************************
+* File Name: esp_ota_port.c
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "esp_libc.h"
+
+#include "esp_system.h"
+#include "esp_timer.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_ota_port.h"
+
+#if defined(ESP_OTA_PORT_ARENA)
+
+#define ESP_OTA_PORT_ARENA_ALIGN	(8)
+/* bit 0 of the block size */
+#define ESP_OTA_PORT_ARENA_FREED	(1)
+
+#define ESP_OTA_PORT_ARENA_SIZE(size)	\
+	(((size) + (ESP_OTA_PORT_ARENA_ALIGN - 1)) & ~(ESP_OTA_PORT_ARENA_ALIGN - 1))
+
+typedef struct
+{
+	uint32_t size;	/* aligned, ESP_OTA_PORT_ARENA_FREED once freed */
+	uint32_t prev;	/* header offset + 1 of the block below, 0: first */
+}esp_ota_port_arena_block_t;
+
+static struct
+{
+	uint8_t *region;
+	uint32_t size;
+	uint32_t top;	/* end of the last block */
+	uint32_t last;	/* header offset + 1 of the last block, 0: empty */
+	esp_ota_port_alloc_stats_t stats;
+}esp_ota_port_arena;
+
+esp_err_t esp_ota_port_arena_init(void *region, size_t size)
+{
+	uint32_t pad;
+
+	if(esp_ota_port_arena.last)
+	{
+		return ESP_ERR_INVALID_STATE;
+	}
+	memset(&esp_ota_port_arena, 0, sizeof(esp_ota_port_arena));
+	if(!region)
+	{
+		return ESP_OK;
+	}
+
+	pad = (ESP_OTA_PORT_ARENA_ALIGN - ((uintptr_t)region % ESP_OTA_PORT_ARENA_ALIGN)) % ESP_OTA_PORT_ARENA_ALIGN;
+	if(size <= (pad + sizeof(esp_ota_port_arena_block_t)))
+	{
+		return ESP_ERR_INVALID_SIZE;
+	}
+	esp_ota_port_arena.region = (uint8_t *)region + pad;
+	esp_ota_port_arena.size = (size - pad) & ~(ESP_OTA_PORT_ARENA_ALIGN - 1);
+	return ESP_OK;
+}
+
+/* bytes after the header at offset, 0 if there is no room for a header */
+static inline uint32_t esp_ota_port_arena_room(uint32_t offset)
+{
+	if((esp_ota_port_arena.size - offset) < sizeof(esp_ota_port_arena_block_t))
+	{
+		return 0;
+	}
+	return esp_ota_port_arena.size - offset - sizeof(esp_ota_port_arena_block_t);
+}
+
+static inline void esp_ota_port_arena_account(void)
+{
+	esp_ota_port_arena.stats.current = esp_ota_port_arena.top;
+	if(esp_ota_port_arena.stats.current > esp_ota_port_arena.stats.peak)
+	{
+		esp_ota_port_arena.stats.peak = esp_ota_port_arena.stats.current;
+	}
+}
+
+void *esp_ota_port_arena_malloc(size_t size)
+{
+	esp_ota_port_arena_block_t *block = NULL;
+	uint32_t offset;
+
+	vTaskSuspendAll();
+	offset = esp_ota_port_arena.top;
+	if(	esp_ota_port_arena.region &&
+		size <= esp_ota_port_arena_room(offset) &&
+		ESP_OTA_PORT_ARENA_SIZE(size) <= esp_ota_port_arena_room(offset))
+	{
+		block = (esp_ota_port_arena_block_t *)&esp_ota_port_arena.region[offset];
+		block->size = ESP_OTA_PORT_ARENA_SIZE(size);
+		block->prev = esp_ota_port_arena.last;
+		esp_ota_port_arena.last = offset + 1;
+		esp_ota_port_arena.top = offset + sizeof(esp_ota_port_arena_block_t) + block->size;
+		esp_ota_port_arena.stats.count++;
+		esp_ota_port_arena_account();
+	}
+	xTaskResumeAll();
+	return block ? (block + 1) : NULL;
+}
+
+void esp_ota_port_arena_free(void *ptr)
+{
+	esp_ota_port_arena_block_t *block;
+
+	if(!ptr)
+	{
+		return;
+	}
+
+	vTaskSuspendAll();
+	block = (esp_ota_port_arena_block_t *)ptr - 1;
+	block->size |= ESP_OTA_PORT_ARENA_FREED;
+	/* release the freed blocks on top */
+	while(esp_ota_port_arena.last)
+	{
+		block = (esp_ota_port_arena_block_t *)&esp_ota_port_arena.region[esp_ota_port_arena.last - 1];
+		if(!(block->size & ESP_OTA_PORT_ARENA_FREED))
+		{
+			break;
+		}
+		esp_ota_port_arena.top = esp_ota_port_arena.last - 1;
+		esp_ota_port_arena.last = block->prev;
+	}
+	esp_ota_port_arena.stats.current = esp_ota_port_arena.top;
+	xTaskResumeAll();
+}
+
+void *esp_ota_port_arena_realloc(void *ptr, size_t size)
+{
+	esp_ota_port_arena_block_t *block;
+	uint32_t offset, old_size;
+	void *p = NULL;
+
+	if(!ptr)
+	{
+		return esp_ota_port_arena_malloc(size);
+	}
+
+	vTaskSuspendAll();
+	block = (esp_ota_port_arena_block_t *)ptr - 1;
+	offset = (uint8_t *)block - esp_ota_port_arena.region;
+	old_size = block->size;
+	if((offset + 1) == esp_ota_port_arena.last)
+	{
+		/* the last block grows or shrinks in place */
+		if(	size <= esp_ota_port_arena_room(offset) &&
+			ESP_OTA_PORT_ARENA_SIZE(size) <= esp_ota_port_arena_room(offset))
+		{
+			block->size = ESP_OTA_PORT_ARENA_SIZE(size);
+			esp_ota_port_arena.top = offset + sizeof(esp_ota_port_arena_block_t) + block->size;
+			esp_ota_port_arena.stats.count++;
+			esp_ota_port_arena_account();
+			p = ptr;
+		}
+		xTaskResumeAll();
+		return p;
+	}
+	xTaskResumeAll();
+
+	if(size <= old_size)
+	{
+		return ptr;
+	}
+	p = esp_ota_port_arena_malloc(size);
+	if(!p)
+	{
+		return NULL;
+	}
+	memcpy(p, ptr, old_size);
+	esp_ota_port_arena_free(ptr);
+	return p;
+}
+
+bool esp_ota_port_get_alloc_stats(esp_ota_port_alloc_stats_t *stats)
+{
+	memcpy(stats, &esp_ota_port_arena.stats, sizeof(esp_ota_port_alloc_stats_t));
+	return true;
+}
+
+void esp_ota_port_alloc_reset_peak(void)
+{
+	esp_ota_port_arena.stats.peak = esp_ota_port_arena.stats.current;
+}
+
+#elif defined(ESP_OTA_PORT_ALLOC_STATS)
+
+/* keeps the alignment of the block returned to the caller */
+#define ESP_OTA_PORT_ALLOC_HEADER	(8)
+
+static esp_ota_port_alloc_stats_t esp_ota_port_alloc_stats;
+
+static inline void esp_ota_port_account(size_t size)
+{
+	esp_ota_port_alloc_stats.current += size;
+	if(esp_ota_port_alloc_stats.current > esp_ota_port_alloc_stats.peak)
+	{
+		esp_ota_port_alloc_stats.peak = esp_ota_port_alloc_stats.current;
+	}
+}
+
+void *esp_ota_port_malloc(size_t size)
+{
+	uint8_t *p;
+
+	p = (uint8_t *)os_malloc(size + ESP_OTA_PORT_ALLOC_HEADER);
+	if(!p)
+	{
+		return NULL;
+	}
+	*(size_t *)p = size;
+	esp_ota_port_alloc_stats.count++;
+	esp_ota_port_account(size);
+	return p + ESP_OTA_PORT_ALLOC_HEADER;
+}
+
+void esp_ota_port_free(void *ptr)
+{
+	uint8_t *p = (uint8_t *)ptr;
+
+	if(!p)
+	{
+		return;
+	}
+	p -= ESP_OTA_PORT_ALLOC_HEADER;
+	esp_ota_port_alloc_stats.current -= *(size_t *)p;
+	os_free(p);
+}
+
+void *esp_ota_port_realloc(void *ptr, size_t size)
+{
+	uint8_t *p = (uint8_t *)ptr;
+	size_t old_size;
+
+	if(!p)
+	{
+		return esp_ota_port_malloc(size);
+	}
+	p -= ESP_OTA_PORT_ALLOC_HEADER;
+	old_size = *(size_t *)p;
+	p = (uint8_t *)os_realloc(p, size + ESP_OTA_PORT_ALLOC_HEADER);
+	if(!p)
+	{
+		return NULL;
+	}
+	*(size_t *)p = size;
+	esp_ota_port_alloc_stats.count++;
+	esp_ota_port_alloc_stats.current -= old_size;
+	esp_ota_port_account(size);
+	return p + ESP_OTA_PORT_ALLOC_HEADER;
+}
+
+bool esp_ota_port_get_alloc_stats(esp_ota_port_alloc_stats_t *stats)
+{
+	memcpy(stats, &esp_ota_port_alloc_stats, sizeof(esp_ota_port_alloc_stats_t));
+	return true;
+}
+
+void esp_ota_port_alloc_reset_peak(void)
+{
+	esp_ota_port_alloc_stats.peak = esp_ota_port_alloc_stats.current;
+}
+
+#else
+
+bool esp_ota_port_get_alloc_stats(esp_ota_port_alloc_stats_t *stats)
+{
+	memset(stats, 0, sizeof(esp_ota_port_alloc_stats_t));
+	return false;
+}
+
+void esp_ota_port_alloc_reset_peak(void)
+{
+}
+
+#endif
+
+#ifndef ESP_OTA_PORT_ARENA
+esp_err_t esp_ota_port_arena_init(void *region, size_t size)
+{
+	return ESP_ERR_NOT_SUPPORTED;
+}
+#endif
+
+/*
+ * EOF
+ */
@@ -0,0 +1,141 @@
+/*****************************************************************************
+* File Name: esp_ota_port.h
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+
+/*******************************************************************************
+* User defined Macros
+*******************************************************************************/
+
+#ifndef ESP_OTA_PORT_H
+#define ESP_OTA_PORT_H
+
+/*
+ * Platform hooks of all esp_ota modules, each one can be overridden from
+ * the build (e.g. a host build with its own clock and allocator).
+ */
+
+#ifndef ESP_OTA_TIME_US
+#define ESP_OTA_TIME_US()	((uint32_t)esp_timer_get_time())
+#endif
+
+typedef struct
+{
+	uint32_t count;		/* allocations */
+	uint32_t current;	/* bytes */
+	uint32_t peak;		/* bytes, since esp_ota_port_alloc_reset_peak() */
+}esp_ota_port_alloc_stats_t;
+
+#if defined(ESP_OTA_PORT_ARENA)
+/*
+ * zero-heap allocator, every block is carved from the region handed to
+ * esp_ota_port_arena_init(), blocks are stacked and the top is released
+ * as soon as the blocks on it are freed
+ */
+void *esp_ota_port_arena_malloc(size_t size);
+void *esp_ota_port_arena_realloc(void *ptr, size_t size);
+void esp_ota_port_arena_free(void *ptr);
+
+#define ESP_OTA_MALLOC	esp_ota_port_arena_malloc
+#define ESP_OTA_REALLOC	esp_ota_port_arena_realloc
+#define ESP_OTA_FREE	esp_ota_port_arena_free
+#elif defined(ESP_OTA_PORT_ALLOC_STATS)
+/* accounting allocator, every block carries its size */
+void *esp_ota_port_malloc(size_t size);
+void *esp_ota_port_realloc(void *ptr, size_t size);
+void esp_ota_port_free(void *ptr);
+
+#define ESP_OTA_MALLOC	esp_ota_port_malloc
+#define ESP_OTA_REALLOC	esp_ota_port_realloc
+#define ESP_OTA_FREE	esp_ota_port_free
+#endif
+
+#ifndef ESP_OTA_MALLOC
+#define ESP_OTA_MALLOC	os_malloc
+#endif
+
+#ifndef ESP_OTA_REALLOC
+#define ESP_OTA_REALLOC	os_realloc
+#endif
+
+#ifndef ESP_OTA_FREE
+#define ESP_OTA_FREE	os_free
+#endif
+
+/** @brief esp_ota_port_arena_init
+ *
+ * Hands the region all esp_ota buffers are carved from (descriptor bodies,
+ * json tokens, download and flash buffers, hash state), the region must
+ * outlive every esp_ota call. Size it from the peak of
+ * esp_ota_port_get_alloc_stats() after a full upgrade. The http client
+ * and TLS buffers of esp_http_client are not part of it.
+ *
+ * @param  region: NULL detaches the current region
+ *
+ * @return  ESP_ERR_INVALID_STATE: blocks of the current region still in use
+ *          ESP_ERR_NOT_SUPPORTED: ESP_OTA_PORT_ARENA is not enabled
+ */
+esp_err_t esp_ota_port_arena_init(void *region, size_t size);
+
+/** @brief esp_ota_port_get_alloc_stats
+ *
+ * With ESP_OTA_PORT_ARENA current and peak are the bytes of the region in
+ * use, block headers and not yet released blocks included.
+ *
+ * @return  false: ESP_OTA_PORT_ALLOC_STATS or ESP_OTA_PORT_ARENA is not
+ *          enabled, stats are zero
+ */
+bool esp_ota_port_get_alloc_stats(esp_ota_port_alloc_stats_t *stats);
+
+void esp_ota_port_alloc_reset_peak(void);
+
+#endif
@@ -0,0 +1,174 @@
+/*****************************************************************************
+* File Name: esp_ota_ring.c
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "esp_libc.h"
+
+#include "esp_system.h"
+#include "esp_timer.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "esp_ota_port.h"
+#include "esp_ota_ring.h"
+
+static void esp_ota_ring_take(SemaphoreHandle_t sem, uint32_t *stalls, uint32_t *wait_us)
+{
+	uint32_t t;
+
+	if(pdTRUE == xSemaphoreTake(sem, 0))
+	{
+		return;
+	}
+
+	/* the other side is the bottleneck */
+	(*stalls)++;
+	t = ESP_OTA_TIME_US();
+	xSemaphoreTake(sem, portMAX_DELAY);
+	*wait_us += ESP_OTA_TIME_US() - t;
+}
+
+esp_err_t esp_ota_ring_init(esp_ota_ring_t *ring, unsigned int depth, unsigned int size)
+{
+	if(depth < 2 || !size)
+	{
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	memset(ring, 0, sizeof(esp_ota_ring_t));
+	ring->depth = depth;
+	ring->size = size;
+
+	ring->buffer = (uint8_t *)ESP_OTA_MALLOC(depth * size);
+	ring->length = (unsigned int *)ESP_OTA_MALLOC(depth * sizeof(unsigned int));
+	ring->data = xSemaphoreCreateCounting(depth, 0);
+	ring->space = xSemaphoreCreateCounting(depth, depth);
+	if(!ring->buffer || !ring->length || !ring->data || !ring->space)
+	{
+		esp_ota_ring_deinit(ring);
+		return ESP_ERR_NO_MEM;
+	}
+	return ESP_OK;
+}
+
+void esp_ota_ring_deinit(esp_ota_ring_t *ring)
+{
+	if(ring->data)
+	{
+		vSemaphoreDelete(ring->data);
+		ring->data = NULL;
+	}
+	if(ring->space)
+	{
+		vSemaphoreDelete(ring->space);
+		ring->space = NULL;
+	}
+	if(ring->length)
+	{
+		ESP_OTA_FREE(ring->length);
+		ring->length = NULL;
+	}
+	if(ring->buffer)
+	{
+		ESP_OTA_FREE(ring->buffer);
+		ring->buffer = NULL;
+	}
+}
+
+uint8_t *esp_ota_ring_acquire(esp_ota_ring_t *ring)
+{
+	if(ring->abort)
+	{
+		return NULL;
+	}
+	esp_ota_ring_take(ring->space, &ring->producer_stalls, &ring->producer_wait_us);
+	if(ring->abort)
+	{
+		return NULL;
+	}
+	return &ring->buffer[(ring->head % ring->depth) * ring->size];
+}
+
+void esp_ota_ring_publish(esp_ota_ring_t *ring, unsigned int length)
+{
+	ring->length[ring->head % ring->depth] = length;
+	ring->head++;
+	xSemaphoreGive(ring->data);
+}
+
+const uint8_t *esp_ota_ring_peek(esp_ota_ring_t *ring, unsigned int *length)
+{
+	unsigned int index;
+
+	esp_ota_ring_take(ring->data, &ring->consumer_stalls, &ring->consumer_wait_us);
+	index = ring->tail % ring->depth;
+	*length = ring->length[index];
+	return &ring->buffer[index * ring->size];
+}
+
+void esp_ota_ring_release(esp_ota_ring_t *ring)
+{
+	ring->tail++;
+	xSemaphoreGive(ring->space);
+}
+
+void esp_ota_ring_abort(esp_ota_ring_t *ring)
+{
+	ring->abort = true;
+	xSemaphoreGive(ring->space);
+}
+
+/*
+ * EOF
+ */
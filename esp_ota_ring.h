@@ -0,0 +1,123 @@
+/*****************************************************************************
+* File Name: esp_ota_ring.h
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+
+/*******************************************************************************
+* User defined Macros
+*******************************************************************************/
+
+#ifndef ESP_OTA_RING_H
+#define ESP_OTA_RING_H
+
+/*
+ * Single-producer/single-consumer ring of fixed size buffers.
+ * head is only written by the producer and tail only by the consumer,
+ * the semaphores are used to block when the ring is full or empty.
+ */
+typedef struct
+{
+	uint8_t *buffer;
+	unsigned int *length;
+	unsigned int size;
+	unsigned int depth;
+	volatile unsigned int head;
+	volatile unsigned int tail;
+	volatile bool abort;
+	SemaphoreHandle_t data;
+	SemaphoreHandle_t space;
+
+	/* back-pressure */
+	uint32_t producer_stalls;
+	uint32_t producer_wait_us;
+	uint32_t consumer_stalls;
+	uint32_t consumer_wait_us;
+}esp_ota_ring_t;
+
+esp_err_t esp_ota_ring_init(esp_ota_ring_t *ring, unsigned int depth, unsigned int size);
+
+void esp_ota_ring_deinit(esp_ota_ring_t *ring);
+
+/** @brief esp_ota_ring_acquire
+ *
+ * Producer: wait for a free buffer of ring->size bytes.
+ *
+ * @return  NULL: ring is aborted
+ */
+uint8_t *esp_ota_ring_acquire(esp_ota_ring_t *ring);
+
+/** @brief esp_ota_ring_publish
+ *
+ * Producer: hand the acquired buffer to the consumer,
+ * length 0 marks the end of the stream.
+ */
+void esp_ota_ring_publish(esp_ota_ring_t *ring, unsigned int length);
+
+/** @brief esp_ota_ring_peek
+ *
+ * Consumer: wait for the next published buffer.
+ */
+const uint8_t *esp_ota_ring_peek(esp_ota_ring_t *ring, unsigned int *length);
+
+/** @brief esp_ota_ring_release
+ *
+ * Consumer: give the buffer returned by esp_ota_ring_peek() back.
+ */
+void esp_ota_ring_release(esp_ota_ring_t *ring);
+
+/** @brief esp_ota_ring_abort
+ *
+ * Consumer: stop the producer, pending and later acquire calls return NULL.
+ */
+void esp_ota_ring_abort(esp_ota_ring_t *ring);
+
+#endif
@@ -0,0 +1,252 @@
+/*****************************************************************************
+* File Name: esp_ota_sched.c
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "esp_system.h"
+#include "esp_timer.h"
+
+#include "esp_ota_nvs.h"
+#include "esp_ota_sched.h"
+
+#ifdef ESP_OTA_DEBUG_ENABLED
+#ifndef debugPrintln
+#define debugPrintln(fmt,args...)	\
+	printf("esp-ota-sched: " fmt "%s", ## args, "\r\n")
+#endif
+#else
+#define debugPrintln(...)
+#endif
+
+/* wall clock in seconds, next_time is not used before it is set (SNTP) */
+#ifndef ESP_OTA_SCHED_TIME
+#define ESP_OTA_SCHED_TIME()	((uint32_t)time(NULL))
+#endif
+
+/* seconds since boot, ESP_OTA_TIME_US() wraps too early for these waits */
+#ifndef ESP_OTA_SCHED_UPTIME
+#define ESP_OTA_SCHED_UPTIME()	((uint32_t)(esp_timer_get_time() / 1000000))
+#endif
+
+#ifndef ESP_OTA_SCHED_TIME_VALID
+#define ESP_OTA_SCHED_TIME_VALID	(1577836800)	/* 2020-01-01 */
+#endif
+
+/* salts of the jitter, the boot spread differs from the regular one */
+#define ESP_OTA_SCHED_SALT_BOOT		(0x5bd1e995)
+#define ESP_OTA_SCHED_SALT_CHECK	(0x1b873593)
+
+/* uniform in [0, range), the same for a device and check count */
+static uint32_t esp_ota_sched_random(const esp_ota_sched_t *sched, uint32_t salt, uint32_t range)
+{
+	uint32_t x = sched->config.device_id ^ salt ^ (sched->state.count * 0x9e3779b9);
+
+	x ^= x >> 16;
+	x *= 0x7feb352d;
+	x ^= x >> 15;
+	x *= 0x846ca68b;
+	x ^= x >> 16;
+	return range ? (x % range) : 0;
+}
+
+static uint32_t esp_ota_sched_device_id(void)
+{
+	uint8_t mac[6];
+	uint32_t id = 2166136261u;
+	unsigned int i;
+
+	if(ESP_OK != esp_read_mac(mac, ESP_MAC_WIFI_STA))
+	{
+		return 0;
+	}
+	for(i = 0; i < sizeof(mac); i++)
+	{
+		id = (id ^ mac[i]) * 16777619u;
+	}
+	return id;
+}
+
+/* wait after a failure: the exponential step, half of it random */
+static uint32_t esp_ota_sched_backoff(const esp_ota_sched_t *sched)
+{
+	uint32_t backoff = sched->config.backoff_min;
+	uint32_t i;
+
+	for(i = 1; i < sched->state.failures && backoff < sched->config.backoff_max; i++)
+	{
+		backoff <<= 1;
+	}
+	if(backoff > sched->config.backoff_max)
+	{
+		backoff = sched->config.backoff_max;
+	}
+	return (backoff / 2) + esp_ota_sched_random(sched, ESP_OTA_SCHED_SALT_CHECK, (backoff / 2) + 1);
+}
+
+static void esp_ota_sched_set(esp_ota_sched_t *sched, uint32_t delay)
+{
+	uint32_t now = ESP_OTA_SCHED_TIME();
+
+	sched->delay = delay;
+	sched->start_time = ESP_OTA_SCHED_UPTIME();
+	sched->state.next_time = (now >= ESP_OTA_SCHED_TIME_VALID) ? (now + delay) : 0;
+	debugPrintln
+		(
+			"next check in %u s, %u failures, retry after %u s",
+			delay,
+			sched->state.failures,
+			sched->state.retry_after
+		);
+}
+
+esp_err_t esp_ota_sched_init(esp_ota_sched_t *sched, const esp_ota_sched_config_t *config)
+{
+	uint32_t now, delay;
+
+	memset(sched, 0, sizeof(esp_ota_sched_t));
+	if(config)
+	{
+		memcpy(&sched->config, config, sizeof(esp_ota_sched_config_t));
+	}
+	if(!sched->config.interval)
+	{
+		sched->config.interval = ESP_OTA_SCHED_INTERVAL;
+	}
+	if(!sched->config.jitter)
+	{
+		sched->config.jitter = sched->config.interval / 4;
+	}
+	if(!sched->config.startup)
+	{
+		sched->config.startup = sched->config.jitter;
+	}
+	if(!sched->config.backoff_min)
+	{
+		sched->config.backoff_min = ESP_OTA_SCHED_BACKOFF_MIN;
+	}
+	if(!sched->config.backoff_max)
+	{
+		sched->config.backoff_max = sched->config.interval;
+	}
+	if(!sched->config.device_id)
+	{
+		sched->config.device_id = esp_ota_sched_device_id();
+	}
+
+	if(ESP_OK != esp_ota_nvs_sched_get(&sched->state))
+	{
+		memset(&sched->state, 0, sizeof(esp_ota_nvs_sched_t));
+	}
+
+	/* the rest of the last wait when the clock tells, else what the server or the failures ask for */
+	now = ESP_OTA_SCHED_TIME();
+	delay = 0;
+	if(sched->state.next_time && now >= ESP_OTA_SCHED_TIME_VALID)
+	{
+		delay = (sched->state.next_time > now) ? (sched->state.next_time - now) : 0;
+	}
+	else if(sched->state.retry_after || sched->state.failures)
+	{
+		delay = sched->state.failures ? esp_ota_sched_backoff(sched) : 0;
+		if(delay < sched->state.retry_after)
+		{
+			delay = sched->state.retry_after;
+		}
+	}
+	esp_ota_sched_set(sched, delay + esp_ota_sched_random(sched, ESP_OTA_SCHED_SALT_BOOT, sched->config.startup));
+	return ESP_OK;
+}
+
+uint32_t esp_ota_sched_next(const esp_ota_sched_t *sched)
+{
+	uint32_t elapsed = ESP_OTA_SCHED_UPTIME() - sched->start_time;
+
+	return (elapsed < sched->delay) ? (sched->delay - elapsed) : 0;
+}
+
+esp_err_t esp_ota_sched_done(esp_ota_sched_t *sched, esp_err_t result, uint32_t retry_after)
+{
+	uint32_t delay;
+
+	if(retry_after > ESP_OTA_SCHED_RETRY_AFTER_MAX)
+	{
+		retry_after = ESP_OTA_SCHED_RETRY_AFTER_MAX;
+	}
+	sched->state.retry_after = retry_after;
+	sched->state.count++;
+	if(result == ESP_OK)
+	{
+		sched->state.failures = 0;
+		delay = (retry_after ? retry_after : sched->config.interval) +
+			esp_ota_sched_random(sched, ESP_OTA_SCHED_SALT_CHECK, sched->config.jitter);
+	}
+	else
+	{
+		if(sched->state.failures < 0xffffffff)
+		{
+			sched->state.failures++;
+		}
+		delay = esp_ota_sched_backoff(sched);
+		if(delay < retry_after)
+		{
+			delay = retry_after;
+		}
+	}
+	esp_ota_sched_set(sched, delay);
+	return esp_ota_nvs_sched_set(&sched->state);
+}
+
+/*
+ * EOF
+ */
@@ -0,0 +1,137 @@
+/*****************************************************************************
+* File Name: esp_ota_sched.h
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+
+/*******************************************************************************
+* User defined Macros
+*******************************************************************************/
+
+#ifndef ESP_OTA_SCHED_H
+#define ESP_OTA_SCHED_H
+
+/*
+ * When to check for an update. Every device waits the interval plus its
+ * own jitter (seeded by the device id), failures back off exponentially
+ * and the server can ask for a longer wait ("Retry-After" header or the
+ * "retry_after" descriptor field). The first check after boot is spread
+ * over config.startup seconds, so a fleet restarting after a power event
+ * doesn't hit the server at once. The state is kept in NVS.
+ *
+ *	esp_ota_sched_init(&sched, NULL);
+ *	for(;;)
+ *	{
+ *		vTaskDelay(esp_ota_sched_next(&sched) * 1000 / portTICK_PERIOD_MS);
+ *		err = esp_ota_http_poll_desc(&config, &desc, &changed);
+ *		esp_ota_http_get_stats(&stats);
+ *		esp_ota_sched_done(&sched, err, MAX(stats.retry_after, desc.retry_after));
+ *		...
+ *	}
+ */
+
+#ifndef ESP_OTA_SCHED_INTERVAL
+#define ESP_OTA_SCHED_INTERVAL		(6 * 3600)
+#endif
+
+#ifndef ESP_OTA_SCHED_BACKOFF_MIN
+#define ESP_OTA_SCHED_BACKOFF_MIN	(60)
+#endif
+
+/* server values above this are clamped */
+#ifndef ESP_OTA_SCHED_RETRY_AFTER_MAX
+#define ESP_OTA_SCHED_RETRY_AFTER_MAX	(7 * 24 * 3600)
+#endif
+
+/* all in seconds, 0: default */
+typedef struct
+{
+	uint32_t interval;		/* between successful checks, ESP_OTA_SCHED_INTERVAL */
+	uint32_t jitter;		/* added to every wait, interval / 4 */
+	uint32_t startup;		/* first check after boot, jitter */
+	uint32_t backoff_min;	/* first retry after a failure, ESP_OTA_SCHED_BACKOFF_MIN */
+	uint32_t backoff_max;	/* interval */
+	uint32_t device_id;		/* jitter seed, the station MAC */
+}esp_ota_sched_config_t;
+
+typedef struct
+{
+	esp_ota_sched_config_t config;
+	esp_ota_nvs_sched_t state;
+	uint32_t delay;			/* seconds from start_time */
+	uint32_t start_time;	/* seconds since boot */
+}esp_ota_sched_t;
+
+/** @brief esp_ota_sched_init
+ *
+ * Load the state from NVS and schedule the first check after boot.
+ *
+ * @param config  NULL: defaults
+ */
+esp_err_t esp_ota_sched_init(esp_ota_sched_t *sched, const esp_ota_sched_config_t *config);
+
+/** @brief esp_ota_sched_next
+ *
+ *
+ * @return  seconds until the next check, 0: now
+ */
+uint32_t esp_ota_sched_next(const esp_ota_sched_t *sched);
+
+/** @brief esp_ota_sched_done
+ *
+ * Result of a check, schedules the next one and saves the state.
+ *
+ * @param result  ESP_OK: the server answered (also 304), else a failure
+ * @param retry_after  seconds asked by the server, 0: none
+ */
+esp_err_t esp_ota_sched_done(esp_ota_sched_t *sched, esp_err_t result, uint32_t retry_after);
+
+#endif
@@ -0,0 +1,568 @@
+/*****************************************************************************
+* File Name: esp_ota_bench.c
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "esp_system.h"
+#include "esp_timer.h"
+
+#include "esp_partition.h"
+#include "esp_ota_ops.h"
+#include "esp_http_client.h"
+
+#include "esp_ota_port.h"
+#include "esp_ota_hash.h"
+#include "esp_ota_desc.h"
+#include "esp_ota_http.h"
+
+#include "esp_ota_host.h"
+
+/*
+ * esp_ota_http_upgrade_ext() from a local server into the host flash:
+ * throughput, esp_ota_write and partition calls, flash time of the model,
+ * progress callbacks, esp_ota allocations and their peak.
+ */
+
+#define BENCH_CERT_PEM		"host"
+#define BENCH_BLANK_PERCENT	(39)
+
+typedef struct
+{
+	bool quick;
+	host_flash_timing_t timing;
+	unsigned int scale;		/* percent of the modeled flash time */
+	uint32_t handshake_ms;
+	const char *image;
+	bool upgrade;
+	bool progress;
+	bool blank;
+	bool desc;
+	bool hash;
+}bench_options_t;
+
+typedef struct
+{
+	esp_err_t err;
+	uint32_t ms;
+	host_flash_stats_t flash;
+	esp_ota_http_stats_t stats;
+	esp_ota_http_progress_t progress;	/* the final event */
+}bench_result_t;
+
+static bench_options_t bench;
+
+static void bench_callback(const esp_ota_http_progress_t *progress, void *arg)
+{
+	memcpy(arg, progress, sizeof(esp_ota_http_progress_t));
+}
+
+/* an app image (0xE9 header) of pseudo random pages, blank_percent of them 0xFF */
+static uint8_t *bench_image(uint32_t size, unsigned int blank_percent)
+{
+	uint32_t x = 0x2545f491, page, i;
+	uint8_t *image;
+
+	image = (uint8_t *)malloc(size);
+	if(!image)
+	{
+		return NULL;
+	}
+	for(page = 0; page < size; page += HOST_FLASH_PAGE_SIZE)
+	{
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		for(i = page; i < size && i < page + HOST_FLASH_PAGE_SIZE; i++)
+		{
+			if(page && (x % 100) < blank_percent)
+			{
+				image[i] = 0xff;
+				continue;
+			}
+			x ^= x << 13;
+			x ^= x >> 17;
+			x ^= x << 5;
+			image[i] = (uint8_t)x;
+		}
+	}
+	image[0] = 0xE9;
+	return image;
+}
+
+static void bench_desc(esp_ota_desc_t *desc, const uint8_t *image, uint32_t size)
+{
+	memset(desc, 0, sizeof(esp_ota_desc_t));
+	desc->version.major = 1;
+	desc->size = size;
+	esp_ota_hash_sha256(NULL, image, size, desc->sha256);
+}
+
+static host_flash_timing_t bench_timing(void)
+{
+	host_flash_timing_t timing = bench.timing;
+
+	timing.erase_sector_us = timing.erase_sector_us * bench.scale / 100;
+	timing.page_program_us = timing.page_program_us * bench.scale / 100;
+	timing.write_call_us = timing.write_call_us * bench.scale / 100;
+	return timing;
+}
+
+static esp_err_t bench_run
+	(
+		host_server_handle_t server,
+		const uint8_t *image,
+		uint32_t size,
+		const esp_ota_http_upgrade_config_t *upgrade_config,
+		bench_result_t *result
+	)
+{
+	esp_http_client_config_t config;
+	esp_ota_http_upgrade_config_t run_config = *upgrade_config;
+	host_flash_timing_t timing = bench_timing();
+	esp_ota_desc_t desc;
+	char url[64];
+	int64_t t;
+
+	host_server_url(server, "/image.bin", url, sizeof(url));
+	memset(&config, 0, sizeof(config));
+	config.url = url;
+	config.cert_pem = BENCH_CERT_PEM;
+	bench_desc(&desc, image, size);
+
+	memset(result, 0, sizeof(bench_result_t));
+	run_config.callback = bench_callback;
+	run_config.callback_arg = &result->progress;
+
+	host_flash_init(NULL);
+	host_flash_set_timing(&timing);
+	host_nvs_reset();
+	host_http_client_set_handshake_us(bench.handshake_ms * 1000);
+	t = esp_timer_get_time();
+	result->err = esp_ota_http_upgrade_ext(&config, &desc, &run_config);
+	result->ms = (uint32_t)((esp_timer_get_time() - t + 500) / 1000);
+	host_flash_get_stats(&result->flash);
+	esp_ota_http_get_stats(&result->stats);
+
+	if(result->err == ESP_OK &&
+		memcmp(host_flash_data(esp_ota_get_next_update_partition(NULL)), image, size))
+	{
+		result->err = ESP_ERR_INVALID_CRC;
+	}
+	return result->err;
+}
+
+static void bench_link(char *text, unsigned int size, uint32_t rate)
+{
+	if(!rate)
+	{
+		snprintf(text, size, "local");
+	}
+	else if(rate >= 1024 * 1024)
+	{
+		snprintf(text, size, "%uMB/s", rate / (1024 * 1024));
+	}
+	else
+	{
+		snprintf(text, size, "%uKB/s", rate / 1024);
+	}
+}
+
+static double bench_mbps(uint32_t bytes, uint32_t ms)
+{
+	return ms ? (double)bytes / (1024.0 * 1024.0) / (ms / 1000.0) : 0.0;
+}
+
+static int bench_upgrade(void)
+{
+	static const uint32_t full_sizes[] = { 64 * 1024, 512 * 1024 };
+	static const uint32_t quick_sizes[] = { 64 * 1024 };
+	static const unsigned int full_blocks[] = { 256, 4096, 16384 };
+	static const unsigned int quick_blocks[] = { 256, 4096 };
+	static const uint32_t full_rates[] = { 0, 1024 * 1024, 128 * 1024 };
+	static const uint32_t quick_rates[] = { 0 };
+	const uint32_t *sizes = bench.quick ? quick_sizes : full_sizes;
+	const unsigned int *blocks = bench.quick ? quick_blocks : full_blocks;
+	const uint32_t *rates = bench.quick ? quick_rates : full_rates;
+	unsigned int size_count = bench.quick ? 1 : 2;
+	unsigned int block_count = bench.quick ? 2 : 3;
+	unsigned int rate_count = bench.quick ? 1 : 3;
+	host_server_config_t server_config;
+	host_server_handle_t server;
+	esp_ota_http_upgrade_config_t upgrade_config;
+	bench_result_t result;
+	unsigned int s, b, r, pipeline;
+	uint8_t *image;
+	char link[16];
+	int failed = 0;
+
+	printf("\nupgrade: esp_ota_http_upgrade_ext(), every read notified\n");
+	printf("%8s %6s %7s %5s %8s %7s %10s %8s %11s %6s %8s %9s %6s %7s\n",
+		"image", "block", "link", "pipe", "MB/s", "ms", "ota_write", "B/write",
+		"part_write", "erase", "flash_ms", "callbacks", "alloc", "peak");
+	for(s = 0; s < size_count; s++)
+	{
+		image = bench_image(sizes[s], 0);
+		for(r = 0; r < rate_count; r++)
+		{
+			memset(&server_config, 0, sizeof(server_config));
+			server_config.rate = rates[r];
+			if(!image || host_server_start(&server_config, &server) != ESP_OK)
+			{
+				free(image);
+				return 1;
+			}
+			host_server_add(server, "/image.bin", image, sizes[s], NULL, NULL);
+			bench_link(link, sizeof(link), rates[r]);
+			for(b = 0; b < block_count; b++)
+			{
+				for(pipeline = 0; pipeline < 2; pipeline++)
+				{
+					memset(&upgrade_config, 0, sizeof(upgrade_config));
+					upgrade_config.block_size = blocks[b];
+					upgrade_config.pipeline_depth = pipeline ? 4 : 0;
+					bench_run(server, image, sizes[s], &upgrade_config, &result);
+					failed |= result.err != ESP_OK;
+					printf("%7uK %6u %7s %5s %8.3f %7u %10u %8u %11u %6u %8u %9u %6u %7u%s\n",
+						sizes[s] / 1024,
+						blocks[b],
+						link,
+						pipeline ? "4" : "-",
+						bench_mbps(sizes[s], result.ms),
+						result.ms,
+						result.flash.ota_write_count,
+						result.flash.ota_write_count ? result.flash.ota_write_bytes / result.flash.ota_write_count : 0,
+						result.flash.write_count,
+						result.flash.erase_count,
+						(uint32_t)(result.flash.busy_us / 1000),
+						result.progress.callback_count,
+						result.stats.alloc_count,
+						result.stats.alloc_peak,
+						result.err != ESP_OK ? "  FAILED" : "");
+				}
+			}
+			host_server_stop(server);
+		}
+		free(image);
+	}
+	return failed;
+}
+
+static int bench_progress(void)
+{
+	static const struct
+	{
+		const char *name;
+		uint32_t bytes;
+		uint32_t interval_ms;
+	}throttles[] =
+	{
+		{ "every read", 0, 0 },
+		{ "16K", 16 * 1024, 0 },
+		{ "100 ms", 0, 100 },
+		{ "64K|250 ms", 64 * 1024, 250 },
+	};
+	uint32_t size = bench.quick ? 64 * 1024 : 512 * 1024;
+	host_server_config_t server_config;
+	host_server_handle_t server;
+	esp_ota_http_upgrade_config_t upgrade_config;
+	bench_result_t result;
+	uint8_t *image;
+	unsigned int i;
+	int failed = 0;
+
+	image = bench_image(size, 0);
+	memset(&server_config, 0, sizeof(server_config));
+	server_config.rate = bench.quick ? 0 : 1024 * 1024;
+	if(!image || host_server_start(&server_config, &server) != ESP_OK)
+	{
+		free(image);
+		return 1;
+	}
+	host_server_add(server, "/image.bin", image, size, NULL, NULL);
+
+	printf("\nprogress: %uK image, 4096 byte blocks, %s link\n", size / 1024, server_config.rate ? "1MB/s" : "local");
+	printf("%12s %8s %9s %10s\n", "throttle", "ms", "callbacks", "callback/s");
+	for(i = 0; i < sizeof(throttles) / sizeof(throttles[0]); i++)
+	{
+		memset(&upgrade_config, 0, sizeof(upgrade_config));
+		upgrade_config.progress_bytes = throttles[i].bytes;
+		upgrade_config.progress_interval_ms = throttles[i].interval_ms;
+		bench_run(server, image, size, &upgrade_config, &result);
+		failed |= result.err != ESP_OK;
+		printf("%12s %8u %9u %10.1f%s\n",
+			throttles[i].name,
+			result.ms,
+			result.progress.callback_count,
+			result.ms ? result.progress.callback_count * 1000.0 / result.ms : 0.0,
+			result.err != ESP_OK ? "  FAILED" : "");
+	}
+	host_server_stop(server);
+	free(image);
+	return failed;
+}
+
+static uint8_t *bench_load(const char *path, uint32_t *size)
+{
+	uint8_t *image;
+	FILE *f;
+	long length;
+
+	f = fopen(path, "rb");
+	if(!f || fseek(f, 0, SEEK_END) || (length = ftell(f)) <= 0 || fseek(f, 0, SEEK_SET))
+	{
+		if(f)
+		{
+			fclose(f);
+		}
+		return NULL;
+	}
+	image = (uint8_t *)malloc(length);
+	if(image && fread(image, 1, length, f) != (size_t)length)
+	{
+		free(image);
+		image = NULL;
+	}
+	fclose(f);
+	*size = length;
+	return image;
+}
+
+/* 0xFF pages left erased (erase-ahead) against esp_ota_write() of every page */
+static int bench_blank(void)
+{
+	static const struct
+	{
+		const char *name;
+		unsigned int erase_ahead_sectors;
+	}modes[] =
+	{
+		{ "esp_ota_write", 0 },
+		{ "erase-ahead", 1 },
+	};
+	host_server_handle_t server;
+	esp_ota_http_upgrade_config_t upgrade_config;
+	host_flash_timing_t timing = bench.timing;
+	bench_result_t result;
+	uint32_t size, blank, page, i;
+	unsigned int scale = bench.scale;
+	uint8_t *image;
+	int failed = 0;
+
+	if(bench.image)
+	{
+		image = bench_load(bench.image, &size);
+	}
+	else
+	{
+		size = bench.quick ? 64 * 1024 : 512 * 1024;
+		image = bench_image(size, BENCH_BLANK_PERCENT);
+	}
+	if(!image || host_server_start(NULL, &server) != ESP_OK)
+	{
+		fprintf(stderr, "no image\n");
+		free(image);
+		return 1;
+	}
+	host_server_add(server, "/image.bin", image, size, NULL, NULL);
+	for(blank = 0, page = 0; page < size; page += HOST_FLASH_PAGE_SIZE)
+	{
+		for(i = page; i < size && i < page + HOST_FLASH_PAGE_SIZE && image[i] == 0xff; i++);
+		blank += (i == size || i == page + HOST_FLASH_PAGE_SIZE);
+	}
+
+	/* modeled time only, nothing waits */
+	bench.timing.sleep = false;
+	bench.scale = 100;
+	printf("\nblank pages: %s, %uK, %u of %u pages 0xFF, %u us per page program\n",
+		bench.image ? bench.image : "generated image", size / 1024, blank,
+		(size + HOST_FLASH_PAGE_SIZE - 1) / HOST_FLASH_PAGE_SIZE, timing.page_program_us);
+	printf("%14s %8s %8s %11s %11s\n", "mode", "pages", "blank", "program_ms", "flash_ms");
+	for(i = 0; i < sizeof(modes) / sizeof(modes[0]); i++)
+	{
+		memset(&upgrade_config, 0, sizeof(upgrade_config));
+		upgrade_config.erase_ahead_sectors = modes[i].erase_ahead_sectors;
+		bench_run(server, image, size, &upgrade_config, &result);
+		failed |= result.err != ESP_OK;
+		printf("%14s %8u %8u %11u %11u%s\n",
+			modes[i].name,
+			result.flash.program_pages,
+			result.stats.blank_count,
+			(uint32_t)((uint64_t)result.flash.program_pages * timing.page_program_us / 1000),
+			(uint32_t)(result.flash.busy_us / 1000),
+			result.err != ESP_OK ? "  FAILED" : "");
+	}
+	bench.timing = timing;
+	bench.scale = scale;
+	host_server_stop(server);
+	free(image);
+	return failed;
+}
+
+static void bench_usage(void)
+{
+	printf
+		(
+			"esp_ota_bench [options] [sections]\n"
+			"  sections: upgrade progress blank desc hash, default: upgrade progress blank\n"
+			"  --quick          small matrix (ctest)\n"
+			"  --flash nor|none flash timing model, default nor (%u us sector erase,\n"
+			"                   %u us page program, %u us per write call)\n"
+			"  --scale PERCENT  of the modeled flash time spent, default 100\n"
+			"  --handshake MS   modeled TLS handshake of every connection, default 0\n"
+			"  --image FILE     app image of the blank section, default generated\n"
+			"                   (%u%% 0xFF pages)\n",
+			((host_flash_timing_t)HOST_FLASH_TIMING_NOR).erase_sector_us,
+			((host_flash_timing_t)HOST_FLASH_TIMING_NOR).page_program_us,
+			((host_flash_timing_t)HOST_FLASH_TIMING_NOR).write_call_us,
+			BENCH_BLANK_PERCENT
+		);
+}
+
+int main(int argc, char **argv)
+{
+	static const host_flash_timing_t nor = HOST_FLASH_TIMING_NOR;
+	bool sections = false;
+	int i, failed = 0;
+
+	bench.timing = nor;
+	bench.scale = 100;
+	for(i = 1; i < argc; i++)
+	{
+		if(!strcmp(argv[i], "--quick"))
+		{
+			bench.quick = true;
+		}
+		else if(!strcmp(argv[i], "--flash") && i + 1 < argc)
+		{
+			i++;
+			if(!strcmp(argv[i], "none"))
+			{
+				memset(&bench.timing, 0, sizeof(bench.timing));
+			}
+		}
+		else if(!strcmp(argv[i], "--scale") && i + 1 < argc)
+		{
+			bench.scale = strtoul(argv[++i], NULL, 10);
+		}
+		else if(!strcmp(argv[i], "--handshake") && i + 1 < argc)
+		{
+			bench.handshake_ms = strtoul(argv[++i], NULL, 10);
+		}
+		else if(!strcmp(argv[i], "--image") && i + 1 < argc)
+		{
+			bench.image = argv[++i];
+		}
+		else if(!strcmp(argv[i], "upgrade"))
+		{
+			bench.upgrade = sections = true;
+		}
+		else if(!strcmp(argv[i], "progress"))
+		{
+			bench.progress = sections = true;
+		}
+		else if(!strcmp(argv[i], "blank"))
+		{
+			bench.blank = sections = true;
+		}
+		else if(!strcmp(argv[i], "desc"))
+		{
+			bench.desc = sections = true;
+		}
+		else if(!strcmp(argv[i], "hash"))
+		{
+			bench.hash = sections = true;
+		}
+		else
+		{
+			bench_usage();
+			return strcmp(argv[i], "--help") ? 2 : 0;
+		}
+	}
+	if(!sections)
+	{
+		bench.upgrade = bench.progress = bench.blank = true;
+	}
+
+	printf("flash model: %u us sector erase, %u us page program, %u us per write, %u%% spent\n",
+		bench.timing.erase_sector_us, bench.timing.page_program_us, bench.timing.write_call_us,
+		bench.timing.sleep ? bench.scale : 0);
+	if(bench.upgrade)
+	{
+		failed |= bench_upgrade();
+	}
+	if(bench.progress)
+	{
+		failed |= bench_progress();
+	}
+	if(bench.blank)
+	{
+		failed |= bench_blank();
+	}
+	if(bench.desc)
+	{
+		printf("\n");
+		esp_ota_desc_benchmark(bench.quick ? 100 : 20000);
+	}
+	if(bench.hash)
+	{
+		printf("\n");
+		esp_ota_hash_benchmark(bench.quick ? 256 * 1024 : 16 * 1024 * 1024);
+	}
+	host_flash_deinit();
+	return failed;
+}
+
+/*
+ * EOF
+ */
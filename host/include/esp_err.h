@@ -0,0 +1,102 @@
+/*****************************************************************************
+* File Name: esp_err.h
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*******************************************************************************
+* User defined Macros
+*******************************************************************************/
+
+#ifndef ESP_OTA_HOST_ESP_ERR_H
+#define ESP_OTA_HOST_ESP_ERR_H
+
+/*
+ * Host stand-in of the ESP8266 RTOS SDK headers: only what the esp_ota
+ * modules use, with the values of the SDK.
+ */
+typedef int32_t esp_err_t;
+
+#define ESP_OK						(0)
+#define ESP_FAIL					(-1)
+
+#define ESP_ERR_NO_MEM				(0x101)
+#define ESP_ERR_INVALID_ARG			(0x102)
+#define ESP_ERR_INVALID_STATE		(0x103)
+#define ESP_ERR_INVALID_SIZE		(0x104)
+#define ESP_ERR_NOT_FOUND			(0x105)
+#define ESP_ERR_NOT_SUPPORTED		(0x106)
+#define ESP_ERR_TIMEOUT				(0x107)
+#define ESP_ERR_INVALID_RESPONSE	(0x108)
+#define ESP_ERR_INVALID_CRC			(0x109)
+#define ESP_ERR_INVALID_VERSION		(0x10A)
+#define ESP_ERR_INVALID_MAC			(0x10B)
+
+#define ESP_ERR_NVS_BASE			(0x1100)
+#define ESP_ERR_NVS_NOT_FOUND		(ESP_ERR_NVS_BASE + 0x02)
+#define ESP_ERR_NVS_INVALID_LENGTH	(ESP_ERR_NVS_BASE + 0x0c)
+
+#define ESP_ERR_OTA_BASE			(0x1500)
+#define ESP_ERR_OTA_PARTITION_CONFLICT	(ESP_ERR_OTA_BASE + 0x01)
+#define ESP_ERR_OTA_SELECT_INFO_INVALID	(ESP_ERR_OTA_BASE + 0x02)
+#define ESP_ERR_OTA_VALIDATE_FAILED		(ESP_ERR_OTA_BASE + 0x03)
+
+#define ESP_ERR_HTTP_BASE			(0x7000)
+#define ESP_ERR_HTTP_MAX_REDIRECT	(ESP_ERR_HTTP_BASE + 1)
+#define ESP_ERR_HTTP_CONNECT		(ESP_ERR_HTTP_BASE + 2)
+#define ESP_ERR_HTTP_WRITE_DATA		(ESP_ERR_HTTP_BASE + 3)
+#define ESP_ERR_HTTP_FETCH_HEADER	(ESP_ERR_HTTP_BASE + 4)
+
+#endif
@@ -0,0 +1,166 @@
+/*****************************************************************************
+* File Name: esp_http_client.h
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+
+#include "esp_err.h"
+
+/*******************************************************************************
+* User defined Macros
+*******************************************************************************/
+
+#ifndef ESP_OTA_HOST_ESP_HTTP_CLIENT_H
+#define ESP_OTA_HOST_ESP_HTTP_CLIENT_H
+
+/*
+ * HTTP/1.1 over a plain TCP socket: keep-alive, Content-Length and chunked
+ * bodies, request headers and HTTP_EVENT_ON_HEADER. https:// urls are
+ * reported as HTTP_TRANSPORT_OVER_SSL (the esp_ota session requires it)
+ * but carried in plain text, a new connection costs the handshake time of
+ * host_http_client_set_handshake_us().
+ */
+typedef struct esp_http_client *esp_http_client_handle_t;
+
+typedef enum
+{
+	HTTP_EVENT_ERROR = 0,
+	HTTP_EVENT_ON_CONNECTED,
+	HTTP_EVENT_HEADER_SENT,
+	HTTP_EVENT_ON_HEADER,
+	HTTP_EVENT_ON_DATA,
+	HTTP_EVENT_ON_FINISH,
+	HTTP_EVENT_DISCONNECTED
+}esp_http_client_event_id_t;
+
+typedef struct esp_http_client_event
+{
+	esp_http_client_event_id_t event_id;
+	esp_http_client_handle_t client;
+	void *data;
+	int data_len;
+	void *user_data;
+	char *header_key;
+	char *header_value;
+}esp_http_client_event_t;
+
+typedef esp_err_t (*http_event_handle_cb)(esp_http_client_event_t *evt);
+
+typedef enum
+{
+	HTTP_METHOD_GET = 0,
+	HTTP_METHOD_POST,
+	HTTP_METHOD_PUT,
+	HTTP_METHOD_PATCH,
+	HTTP_METHOD_DELETE,
+	HTTP_METHOD_HEAD
+}esp_http_client_method_t;
+
+typedef enum
+{
+	HTTP_AUTH_TYPE_NONE = 0,
+	HTTP_AUTH_TYPE_BASIC,
+	HTTP_AUTH_TYPE_DIGEST
+}esp_http_client_auth_type_t;
+
+typedef enum
+{
+	HTTP_TRANSPORT_UNKNOWN = 0x0,
+	HTTP_TRANSPORT_OVER_TCP,
+	HTTP_TRANSPORT_OVER_SSL
+}esp_http_client_transport_t;
+
+typedef struct
+{
+	const char *url;
+	const char *host;
+	int port;
+	const char *username;
+	const char *password;
+	esp_http_client_auth_type_t auth_type;
+	const char *path;
+	const char *query;
+	const char *cert_pem;
+	esp_http_client_method_t method;
+	int timeout_ms;
+	bool disable_auto_redirect;
+	int max_redirection_count;
+	http_event_handle_cb event_handler;
+	esp_http_client_transport_t transport_type;
+	int buffer_size;
+	void *user_data;
+}esp_http_client_config_t;
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *config);
+esp_err_t esp_http_client_set_url(esp_http_client_handle_t client, const char *url);
+esp_err_t esp_http_client_set_method(esp_http_client_handle_t client, esp_http_client_method_t method);
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client, const char *key, const char *value);
+esp_err_t esp_http_client_delete_header(esp_http_client_handle_t client, const char *key);
+
+/* ESP_ERR_HTTP_CONNECT: no connection, or the server closed the kept-alive one */
+esp_err_t esp_http_client_open(esp_http_client_handle_t client, int write_len);
+
+/* Content-Length, 0: chunked or no body, < 0: error */
+int esp_http_client_fetch_headers(esp_http_client_handle_t client);
+
+bool esp_http_client_is_chunked_response(esp_http_client_handle_t client);
+int esp_http_client_get_status_code(esp_http_client_handle_t client);
+int esp_http_client_get_content_length(esp_http_client_handle_t client);
+
+/* 0: end of the body, < 0: connection error */
+int esp_http_client_read(esp_http_client_handle_t client, char *buffer, int len);
+
+bool esp_http_client_is_complete_data_received(esp_http_client_handle_t client);
+esp_http_client_transport_t esp_http_client_get_transport_type(esp_http_client_handle_t client);
+esp_err_t esp_http_client_close(esp_http_client_handle_t client);
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client);
+
+#endif
@@ -0,0 +1,216 @@
+/*****************************************************************************
+* File Name: esp_ota_host.h
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+
+#include "esp_err.h"
+#include "esp_partition.h"
+
+/*******************************************************************************
+* User defined Macros
+*******************************************************************************/
+
+#ifndef ESP_OTA_HOST_H
+#define ESP_OTA_HOST_H
+
+/*
+ * Controls of the host stand-ins (host/src): the flash and its timing
+ * model, the partition table, NVS, the HTTP client and a local HTTP
+ * server to fetch from.
+ *
+ * Partition table of the HOST_FLASH_SIZE flash:
+ *	ota_0	app		0x010000	1M	running
+ *	ota_1	app		0x110000	1M	next update partition
+ *	spiffs	data	0x210000	256K
+ */
+
+#define HOST_FLASH_SIZE			(0x400000)
+#define HOST_FLASH_PAGE_SIZE	(256)
+
+/* free heap reported before the esp_ota allocations are taken off */
+#ifndef HOST_HEAP_SIZE
+#define HOST_HEAP_SIZE			(80 * 1024)
+#endif
+
+/*
+ * Cost of the flash operations, charged to host_flash_stats_t.busy_us and,
+ * with sleep, spent in the calling thread while the flash is held. A write
+ * programs every page it touches, whatever the data.
+ */
+typedef struct
+{
+	uint32_t erase_sector_us;
+	uint32_t page_program_us;
+	uint32_t write_call_us;		/* SPI command overhead of every write */
+	bool sleep;
+}host_flash_timing_t;
+
+/* typical SPI NOR of ESP8266 modules (4K sector erase, 256 byte page program) */
+#define HOST_FLASH_TIMING_NOR	{ 45000, 700, 20, true }
+
+typedef struct
+{
+	uint32_t erase_count;		/* esp_partition_erase_range calls */
+	uint32_t erase_bytes;
+	uint32_t write_count;		/* esp_partition_write calls, esp_ota_write included */
+	uint32_t write_bytes;
+	uint32_t ota_write_count;	/* esp_ota_write calls */
+	uint32_t ota_write_bytes;
+	uint32_t program_pages;
+	uint64_t busy_us;
+}host_flash_stats_t;
+
+/** @brief host_flash_init
+ *
+ * Flash of HOST_FLASH_SIZE bytes, erased (0xFF) unless the file is kept
+ * from a previous run. Resets the stats, timing, boot partition and OTA
+ * handle.
+ *
+ * @param path  NULL: RAM, else a file mapped as the flash
+ */
+esp_err_t host_flash_init(const char *path);
+
+void host_flash_deinit(void);
+
+/* NULL: operations cost nothing */
+void host_flash_set_timing(const host_flash_timing_t *timing);
+
+void host_flash_get_stats(host_flash_stats_t *stats);
+void host_flash_reset_stats(void);
+
+/** @brief host_flash_fail_write
+ *
+ * Once host_flash_stats_t.write_count has reached write_count - 1, every
+ * esp_partition_write() (esp_ota_write included) fails with err and writes
+ * nothing.
+ *
+ * @param err  ESP_OK: writes don't fail
+ */
+void host_flash_fail_write(uint32_t write_count, esp_err_t err);
+
+/* contents of the partition, reads and writes bypass the model */
+uint8_t *host_flash_data(const esp_partition_t *partition);
+
+/* set by esp_ota_set_boot_partition(), NULL: not set since host_flash_init() */
+const esp_partition_t *host_ota_get_boot(void);
+
+void host_nvs_reset(void);
+
+typedef struct
+{
+	uint32_t connections;
+	uint32_t requests;
+	uint64_t bytes;		/* body bytes read */
+}host_http_client_stats_t;
+
+/* modeled TLS handshake of every new connection to an https:// url */
+void host_http_client_set_handshake_us(uint32_t handshake_us);
+void host_http_client_get_stats(host_http_client_stats_t *stats);
+void host_http_client_reset_stats(void);
+
+/*
+ * HTTP/1.1 server on 127.0.0.1, one thread per connection: GET with Range,
+ * ETag and If-None-Match, keep-alive, and a shaped link.
+ */
+typedef struct
+{
+	uint32_t rate;			/* bytes/s of every response, 0: unlimited */
+	uint32_t latency_us;	/* before every response */
+	uint32_t fail_every;	/* every n-th response is cut after half its body, 0: never */
+	uint32_t keep_alive;	/* requests per connection, 0: unlimited */
+	bool chunked;			/* 200 responses use Transfer-Encoding: chunked */
+	bool no_range;			/* Range is ignored */
+}host_server_config_t;
+
+typedef struct
+{
+	uint32_t connections;
+	uint32_t requests;
+	uint32_t range_requests;
+	uint32_t failed;		/* responses cut by fail_every */
+	uint64_t bytes;			/* body bytes sent */
+}host_server_stats_t;
+
+typedef struct host_server *host_server_handle_t;
+
+esp_err_t host_server_start(const host_server_config_t *config, host_server_handle_t *out);
+void host_server_stop(host_server_handle_t server);
+
+/* "https://127.0.0.1:port/path" */
+void host_server_url(host_server_handle_t server, const char *path, char *url, unsigned int size);
+
+/** @brief host_server_add
+ *
+ * Serve data (not copied, it must outlive the server) at path.
+ *
+ * @param content_type  NULL: application/octet-stream
+ * @param etag  NULL: none
+ */
+esp_err_t host_server_add
+	(
+		host_server_handle_t server,
+		const char *path,
+		const void *data,
+		uint32_t length,
+		const char *content_type,
+		const char *etag
+	);
+
+/*
+ * The byte at offset is flipped in the next count responses that carry it,
+ * up to 8 offsets of a path at a time. count 0 clears the offset.
+ */
+void host_server_corrupt(host_server_handle_t server, const char *path, uint32_t offset, uint32_t count);
+
+void host_server_get_stats(host_server_handle_t server, host_server_stats_t *stats);
+
+#endif
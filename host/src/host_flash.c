@@ -0,0 +1,435 @@
+/*****************************************************************************
+* File Name: host_flash.c
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "esp_partition.h"
+#include "esp_ota_ops.h"
+
+#include "esp_ota_host.h"
+
+#define HOST_FLASH_IMAGE_MAGIC	(0xE9)
+
+static esp_partition_t host_partitions[] =
+{
+	{ ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_0, 0x010000, 0x100000, "ota_0", false },
+	{ ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_1, 0x110000, 0x100000, "ota_1", false },
+	{ ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, 0x210000, 0x40000, "spiffs", false },
+};
+
+#define HOST_PARTITION_COUNT	(sizeof(host_partitions) / sizeof(host_partitions[0]))
+#define HOST_PARTITION_RUNNING	(&host_partitions[0])
+#define HOST_PARTITION_NEXT		(&host_partitions[1])
+
+static struct
+{
+	uint8_t *data;
+	int fd;
+
+	/* held for every operation and its modeled time: one SPI flash */
+	pthread_mutex_t lock;
+	host_flash_timing_t timing;
+	host_flash_stats_t stats;
+	uint32_t fail_write_count;
+	esp_err_t fail_write_err;
+
+	const esp_partition_t *boot;
+
+	/* the last esp_ota_begin(), an abandoned one is dropped */
+	const esp_partition_t *ota_partition;
+	uint32_t ota_offset;
+	uint32_t ota_erased;
+	esp_ota_handle_t ota_handle;
+}host_flash = { NULL, -1, PTHREAD_MUTEX_INITIALIZER };
+
+static void host_flash_busy(uint32_t us)
+{
+	host_flash.stats.busy_us += us;
+	if(host_flash.timing.sleep && us)
+	{
+		usleep(us);
+	}
+}
+
+static bool host_flash_range(const esp_partition_t *partition, size_t offset, size_t size)
+{
+	return host_flash.data && partition && offset <= partition->size && size <= partition->size - offset;
+}
+
+esp_err_t host_flash_init(const char *path)
+{
+	struct stat st;
+	bool erase = true;
+
+	host_flash_deinit();
+	if(!path)
+	{
+		host_flash.data = (uint8_t *)malloc(HOST_FLASH_SIZE);
+		if(!host_flash.data)
+		{
+			return ESP_ERR_NO_MEM;
+		}
+	}
+	else
+	{
+		host_flash.fd = open(path, O_RDWR | O_CREAT, 0644);
+		if(host_flash.fd < 0 || fstat(host_flash.fd, &st))
+		{
+			host_flash_deinit();
+			return ESP_FAIL;
+		}
+		if(st.st_size == HOST_FLASH_SIZE)
+		{
+			erase = false;
+		}
+		else if(ftruncate(host_flash.fd, HOST_FLASH_SIZE))
+		{
+			host_flash_deinit();
+			return ESP_FAIL;
+		}
+		host_flash.data = (uint8_t *)mmap(NULL, HOST_FLASH_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, host_flash.fd, 0);
+		if(host_flash.data == MAP_FAILED)
+		{
+			host_flash.data = NULL;
+			host_flash_deinit();
+			return ESP_FAIL;
+		}
+	}
+	if(erase)
+	{
+		memset(host_flash.data, 0xff, HOST_FLASH_SIZE);
+	}
+	memset(&host_flash.timing, 0, sizeof(host_flash.timing));
+	memset(&host_flash.stats, 0, sizeof(host_flash.stats));
+	host_flash.fail_write_err = ESP_OK;
+	host_flash.boot = NULL;
+	host_flash.ota_partition = NULL;
+	return ESP_OK;
+}
+
+void host_flash_deinit(void)
+{
+	if(host_flash.data && host_flash.fd >= 0)
+	{
+		munmap(host_flash.data, HOST_FLASH_SIZE);
+	}
+	else if(host_flash.data)
+	{
+		free(host_flash.data);
+	}
+	if(host_flash.fd >= 0)
+	{
+		close(host_flash.fd);
+	}
+	host_flash.data = NULL;
+	host_flash.fd = -1;
+}
+
+void host_flash_set_timing(const host_flash_timing_t *timing)
+{
+	pthread_mutex_lock(&host_flash.lock);
+	if(timing)
+	{
+		host_flash.timing = *timing;
+	}
+	else
+	{
+		memset(&host_flash.timing, 0, sizeof(host_flash.timing));
+	}
+	pthread_mutex_unlock(&host_flash.lock);
+}
+
+void host_flash_get_stats(host_flash_stats_t *stats)
+{
+	pthread_mutex_lock(&host_flash.lock);
+	*stats = host_flash.stats;
+	pthread_mutex_unlock(&host_flash.lock);
+}
+
+void host_flash_reset_stats(void)
+{
+	pthread_mutex_lock(&host_flash.lock);
+	memset(&host_flash.stats, 0, sizeof(host_flash.stats));
+	pthread_mutex_unlock(&host_flash.lock);
+}
+
+void host_flash_fail_write(uint32_t write_count, esp_err_t err)
+{
+	pthread_mutex_lock(&host_flash.lock);
+	host_flash.fail_write_count = write_count;
+	host_flash.fail_write_err = err;
+	pthread_mutex_unlock(&host_flash.lock);
+}
+
+uint8_t *host_flash_data(const esp_partition_t *partition)
+{
+	return host_flash.data ? host_flash.data + partition->address : NULL;
+}
+
+const esp_partition_t *host_ota_get_boot(void)
+{
+	return host_flash.boot;
+}
+
+/*
+ * esp_partition
+ */
+
+const esp_partition_t *esp_partition_find_first
+	(
+		esp_partition_type_t type,
+		esp_partition_subtype_t subtype,
+		const char *label
+	)
+{
+	unsigned int i;
+
+	for(i = 0; i < HOST_PARTITION_COUNT; i++)
+	{
+		if(host_partitions[i].type != type ||
+			(subtype != ESP_PARTITION_SUBTYPE_ANY && host_partitions[i].subtype != subtype) ||
+			(label && strcmp(label, host_partitions[i].label)))
+		{
+			continue;
+		}
+		return &host_partitions[i];
+	}
+	return NULL;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size)
+{
+	if(!host_flash_range(partition, src_offset, size))
+	{
+		return ESP_ERR_INVALID_SIZE;
+	}
+	pthread_mutex_lock(&host_flash.lock);
+	memcpy(dst, host_flash.data + partition->address + src_offset, size);
+	pthread_mutex_unlock(&host_flash.lock);
+	return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size)
+{
+	const uint8_t *s = (const uint8_t *)src;
+	uint8_t *d;
+	uint32_t pages;
+	size_t i;
+
+	if(!host_flash_range(partition, dst_offset, size))
+	{
+		return ESP_ERR_INVALID_SIZE;
+	}
+	pthread_mutex_lock(&host_flash.lock);
+	if(	host_flash.fail_write_err != ESP_OK &&
+		host_flash.stats.write_count + 1 >= host_flash.fail_write_count)
+	{
+		pthread_mutex_unlock(&host_flash.lock);
+		return host_flash.fail_write_err;
+	}
+	/* NOR: programming only clears bits */
+	d = host_flash.data + partition->address + dst_offset;
+	for(i = 0; i < size; i++)
+	{
+		d[i] &= s[i];
+	}
+	pages = 0;
+	if(size)
+	{
+		pages = (partition->address + dst_offset + size - 1) / HOST_FLASH_PAGE_SIZE -
+			(partition->address + dst_offset) / HOST_FLASH_PAGE_SIZE + 1;
+	}
+	host_flash.stats.write_count++;
+	host_flash.stats.write_bytes += size;
+	host_flash.stats.program_pages += pages;
+	host_flash_busy(host_flash.timing.write_call_us + pages * host_flash.timing.page_program_us);
+	pthread_mutex_unlock(&host_flash.lock);
+	return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t start_addr, size_t size)
+{
+	if(start_addr % SPI_FLASH_SEC_SIZE || size % SPI_FLASH_SEC_SIZE)
+	{
+		return ESP_ERR_INVALID_ARG;
+	}
+	if(!host_flash_range(partition, start_addr, size))
+	{
+		return ESP_ERR_INVALID_SIZE;
+	}
+	pthread_mutex_lock(&host_flash.lock);
+	memset(host_flash.data + partition->address + start_addr, 0xff, size);
+	host_flash.stats.erase_count++;
+	host_flash.stats.erase_bytes += size;
+	host_flash_busy((size / SPI_FLASH_SEC_SIZE) * host_flash.timing.erase_sector_us);
+	pthread_mutex_unlock(&host_flash.lock);
+	return ESP_OK;
+}
+
+/*
+ * esp_ota
+ */
+
+esp_err_t esp_ota_begin(const esp_partition_t *partition, size_t image_size, esp_ota_handle_t *out_handle)
+{
+	uint32_t erase_size;
+	esp_err_t err;
+
+	if(!partition || !out_handle)
+	{
+		return ESP_ERR_INVALID_ARG;
+	}
+	if(partition == HOST_PARTITION_RUNNING)
+	{
+		return ESP_ERR_OTA_PARTITION_CONFLICT;
+	}
+	erase_size = partition->size;
+	if(image_size != OTA_SIZE_UNKNOWN)
+	{
+		erase_size = (image_size + SPI_FLASH_SEC_SIZE - 1) / SPI_FLASH_SEC_SIZE * SPI_FLASH_SEC_SIZE;
+	}
+	if(erase_size > partition->size)
+	{
+		return ESP_ERR_INVALID_SIZE;
+	}
+	err = esp_partition_erase_range(partition, 0, erase_size);
+	if(err != ESP_OK)
+	{
+		return err;
+	}
+	host_flash.ota_partition = partition;
+	host_flash.ota_offset = 0;
+	host_flash.ota_erased = erase_size;
+	*out_handle = ++host_flash.ota_handle;
+	return ESP_OK;
+}
+
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void *data, size_t size)
+{
+	esp_err_t err;
+
+	if(!host_flash.ota_partition || handle != host_flash.ota_handle)
+	{
+		return ESP_ERR_INVALID_ARG;
+	}
+	if(host_flash.ota_offset + size > host_flash.ota_erased)
+	{
+		return ESP_ERR_INVALID_SIZE;
+	}
+	err = esp_partition_write(host_flash.ota_partition, host_flash.ota_offset, data, size);
+	if(err != ESP_OK)
+	{
+		return err;
+	}
+	pthread_mutex_lock(&host_flash.lock);
+	host_flash.stats.ota_write_count++;
+	host_flash.stats.ota_write_bytes += size;
+	pthread_mutex_unlock(&host_flash.lock);
+	host_flash.ota_offset += size;
+	return ESP_OK;
+}
+
+esp_err_t esp_ota_end(esp_ota_handle_t handle)
+{
+	const esp_partition_t *partition = host_flash.ota_partition;
+
+	if(!partition || handle != host_flash.ota_handle)
+	{
+		return ESP_ERR_INVALID_ARG;
+	}
+	host_flash.ota_partition = NULL;
+	if(!host_flash.ota_offset || host_flash_data(partition)[0] != HOST_FLASH_IMAGE_MAGIC)
+	{
+		return ESP_ERR_OTA_VALIDATE_FAILED;
+	}
+	return ESP_OK;
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *partition)
+{
+	if(!partition || partition->type != ESP_PARTITION_TYPE_APP)
+	{
+		return ESP_ERR_INVALID_ARG;
+	}
+	if(host_flash_data(partition)[0] != HOST_FLASH_IMAGE_MAGIC)
+	{
+		return ESP_ERR_OTA_VALIDATE_FAILED;
+	}
+	host_flash.boot = partition;
+	return ESP_OK;
+}
+
+const esp_partition_t *esp_ota_get_boot_partition(void)
+{
+	return host_flash.boot ? host_flash.boot : HOST_PARTITION_RUNNING;
+}
+
+const esp_partition_t *esp_ota_get_running_partition(void)
+{
+	return HOST_PARTITION_RUNNING;
+}
+
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *start_from)
+{
+	return HOST_PARTITION_NEXT;
+}
+
+/*
+ * EOF
+ */
@@ -0,0 +1,254 @@
+/*****************************************************************************
+* File Name: host_freertos.c
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+struct host_semaphore
+{
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	UBaseType_t count;
+	UBaseType_t max_count;
+};
+
+typedef struct
+{
+	TaskFunction_t task;
+	void *parameters;
+}host_task_start_t;
+
+static pthread_mutex_t host_suspend_lock = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
+static void *host_task_entry(void *arg)
+{
+	host_task_start_t start = *(host_task_start_t *)arg;
+
+	free(arg);
+	start.task(start.parameters);
+	return NULL;
+}
+
+BaseType_t xTaskCreate
+	(
+		TaskFunction_t task,
+		const char *name,
+		uint32_t stack_depth,
+		void *parameters,
+		UBaseType_t priority,
+		TaskHandle_t *created_task
+	)
+{
+	host_task_start_t *start;
+	pthread_t thread;
+
+	start = (host_task_start_t *)malloc(sizeof(host_task_start_t));
+	if(!start)
+	{
+		return pdFAIL;
+	}
+	start->task = task;
+	start->parameters = parameters;
+	if(pthread_create(&thread, NULL, host_task_entry, start))
+	{
+		free(start);
+		return pdFAIL;
+	}
+	pthread_detach(thread);
+	if(created_task)
+	{
+		*created_task = (TaskHandle_t)thread;
+	}
+	return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+	if(!task || pthread_equal((pthread_t)task, pthread_self()))
+	{
+		pthread_exit(NULL);
+	}
+	/* another task: not used by the esp_ota modules */
+	abort();
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+	usleep(ticks * portTICK_PERIOD_MS * 1000);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (TickType_t)((ts.tv_sec * 1000 + ts.tv_nsec / 1000000) / portTICK_PERIOD_MS);
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task)
+{
+	return 5;
+}
+
+void vTaskSuspendAll(void)
+{
+	pthread_mutex_lock(&host_suspend_lock);
+}
+
+BaseType_t xTaskResumeAll(void)
+{
+	pthread_mutex_unlock(&host_suspend_lock);
+	return pdFALSE;
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count)
+{
+	SemaphoreHandle_t semaphore;
+	pthread_condattr_t attr;
+
+	semaphore = (SemaphoreHandle_t)calloc(1, sizeof(struct host_semaphore));
+	if(!semaphore)
+	{
+		return NULL;
+	}
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_mutex_init(&semaphore->lock, NULL);
+	pthread_cond_init(&semaphore->cond, &attr);
+	pthread_condattr_destroy(&attr);
+	semaphore->count = initial_count;
+	semaphore->max_count = max_count;
+	return semaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+	return xSemaphoreCreateCounting(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+	return xSemaphoreCreateCounting(1, 1);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks)
+{
+	struct timespec ts;
+	uint64_t ms;
+	int rc = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	ms = (uint64_t)ticks * portTICK_PERIOD_MS;
+	ts.tv_sec += ms / 1000;
+	ts.tv_nsec += (ms % 1000) * 1000000;
+	if(ts.tv_nsec >= 1000000000)
+	{
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000;
+	}
+
+	pthread_mutex_lock(&semaphore->lock);
+	while(!semaphore->count && ticks && rc != ETIMEDOUT)
+	{
+		if(ticks == portMAX_DELAY)
+		{
+			pthread_cond_wait(&semaphore->cond, &semaphore->lock);
+		}
+		else
+		{
+			rc = pthread_cond_timedwait(&semaphore->cond, &semaphore->lock, &ts);
+		}
+	}
+	if(!semaphore->count)
+	{
+		pthread_mutex_unlock(&semaphore->lock);
+		return pdFALSE;
+	}
+	semaphore->count--;
+	pthread_mutex_unlock(&semaphore->lock);
+	return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+	BaseType_t rc = pdFALSE;
+
+	pthread_mutex_lock(&semaphore->lock);
+	if(semaphore->count < semaphore->max_count)
+	{
+		semaphore->count++;
+		pthread_cond_signal(&semaphore->cond);
+		rc = pdTRUE;
+	}
+	pthread_mutex_unlock(&semaphore->lock);
+	return rc;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore)
+{
+	pthread_cond_destroy(&semaphore->cond);
+	pthread_mutex_destroy(&semaphore->lock);
+	free(semaphore);
+}
+
+/*
+ * EOF
+ */
@@ -0,0 +1,679 @@
+/*****************************************************************************
+* File Name: host_http_client.c
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include "esp_http_client.h"
+
+#include "esp_ota_host.h"
+
+#define HOST_HTTP_URL_SIZE		(512)
+#define HOST_HTTP_HOST_SIZE		(128)
+#define HOST_HTTP_HEADERS		(16)
+#define HOST_HTTP_LINE_SIZE		(512)
+#define HOST_HTTP_BUFFER_SIZE	(4096)
+#define HOST_HTTP_TIMEOUT_MS	(5000)
+#define HOST_HTTP_RCVBUF		(5744)	/* TCP_WND of the SDK lwIP, 4 * TCP_MSS */
+
+typedef struct
+{
+	char key[32];
+	char value[128];
+}host_http_header_t;
+
+struct esp_http_client
+{
+	http_event_handle_cb event_handler;
+	void *user_data;
+	int timeout_ms;
+	esp_http_client_method_t method;
+
+	char url[HOST_HTTP_URL_SIZE];
+	bool ssl;
+	char host[HOST_HTTP_HOST_SIZE];
+	char port[8];
+	const char *path;	/* in url */
+
+	host_http_header_t headers[HOST_HTTP_HEADERS];
+	unsigned int header_count;
+
+	int sock;
+	char sock_host[HOST_HTTP_HOST_SIZE + 8];	/* host:port of sock */
+
+	/* bytes received past the last one consumed */
+	char buffer[HOST_HTTP_BUFFER_SIZE];
+	unsigned int buffer_pos;
+	unsigned int buffer_length;
+
+	/* response */
+	int status;
+	int content_length;		/* -1: chunked or up to the end of the connection */
+	bool chunked;
+	bool close;				/* Connection: close */
+	bool no_body;
+	uint32_t remaining;		/* of the body or of the current chunk */
+	bool complete;
+};
+
+static struct
+{
+	pthread_mutex_t lock;
+	uint32_t handshake_us;
+	host_http_client_stats_t stats;
+}host_http = { PTHREAD_MUTEX_INITIALIZER };
+
+void host_http_client_set_handshake_us(uint32_t handshake_us)
+{
+	host_http.handshake_us = handshake_us;
+}
+
+void host_http_client_get_stats(host_http_client_stats_t *stats)
+{
+	pthread_mutex_lock(&host_http.lock);
+	*stats = host_http.stats;
+	pthread_mutex_unlock(&host_http.lock);
+}
+
+void host_http_client_reset_stats(void)
+{
+	pthread_mutex_lock(&host_http.lock);
+	memset(&host_http.stats, 0, sizeof(host_http.stats));
+	pthread_mutex_unlock(&host_http.lock);
+}
+
+static void host_http_disconnect(esp_http_client_handle_t client)
+{
+	if(client->sock >= 0)
+	{
+		close(client->sock);
+	}
+	client->sock = -1;
+	client->buffer_pos = 0;
+	client->buffer_length = 0;
+}
+
+/* scheme://host[:port]/path */
+static esp_err_t host_http_parse_url(esp_http_client_handle_t client, const char *url)
+{
+	const char *host, *end, *colon;
+	unsigned int length;
+
+	if(!url || strlen(url) >= sizeof(client->url))
+	{
+		return ESP_ERR_INVALID_ARG;
+	}
+	if(!strncasecmp(url, "https://", 8))
+	{
+		client->ssl = true;
+		host = url + 8;
+	}
+	else if(!strncasecmp(url, "http://", 7))
+	{
+		client->ssl = false;
+		host = url + 7;
+	}
+	else
+	{
+		return ESP_ERR_INVALID_ARG;
+	}
+	strcpy(client->url, url);
+	host = client->url + (host - url);
+	end = host + strcspn(host, "/?");
+	colon = memchr(host, ':', end - host);
+	length = (colon ? colon : end) - host;
+	if(!length || length >= sizeof(client->host))
+	{
+		return ESP_ERR_INVALID_ARG;
+	}
+	memcpy(client->host, host, length);
+	client->host[length] = '\0';
+	snprintf(client->port, sizeof(client->port), "%s", client->ssl ? "443" : "80");
+	if(colon && end - colon - 1 > 0 && end - colon - 1 < (int)sizeof(client->port))
+	{
+		memcpy(client->port, colon + 1, end - colon - 1);
+		client->port[end - colon - 1] = '\0';
+	}
+	client->path = *end ? end : "/";
+	return ESP_OK;
+}
+
+static int host_http_fill(esp_http_client_handle_t client)
+{
+	int length;
+
+	if(client->buffer_pos == client->buffer_length)
+	{
+		client->buffer_pos = 0;
+		client->buffer_length = 0;
+	}
+	if(client->buffer_length == sizeof(client->buffer))
+	{
+		return -1;
+	}
+	length = recv(client->sock, client->buffer + client->buffer_length, sizeof(client->buffer) - client->buffer_length, 0);
+	if(length <= 0)
+	{
+		return -1;
+	}
+	client->buffer_length += length;
+	return length;
+}
+
+/* one CRLF terminated line without the CRLF */
+static int host_http_line(esp_http_client_handle_t client, char *line, unsigned int size)
+{
+	char *start, *lf;
+	unsigned int length;
+
+	for(;;)
+	{
+		start = client->buffer + client->buffer_pos;
+		lf = memchr(start, '\n', client->buffer_length - client->buffer_pos);
+		if(lf)
+		{
+			break;
+		}
+		if(client->buffer_pos)
+		{
+			memmove(client->buffer, start, client->buffer_length - client->buffer_pos);
+			client->buffer_length -= client->buffer_pos;
+			client->buffer_pos = 0;
+		}
+		if(host_http_fill(client) < 0)
+		{
+			return -1;
+		}
+	}
+	length = lf - start;
+	client->buffer_pos += length + 1;
+	if(length && start[length - 1] == '\r')
+	{
+		length--;
+	}
+	if(length >= size)
+	{
+		return -1;
+	}
+	memcpy(line, start, length);
+	line[length] = '\0';
+	return length;
+}
+
+/* up to length body bytes of the buffer or the socket */
+static int host_http_recv(esp_http_client_handle_t client, char *data, uint32_t length)
+{
+	uint32_t n = client->buffer_length - client->buffer_pos;
+	int rc;
+
+	if(n)
+	{
+		n = n < length ? n : length;
+		memcpy(data, client->buffer + client->buffer_pos, n);
+		client->buffer_pos += n;
+		return n;
+	}
+	rc = recv(client->sock, data, length, 0);
+	return rc > 0 ? rc : -1;
+}
+
+static void host_http_event(esp_http_client_handle_t client, char *key, char *value)
+{
+	esp_http_client_event_t evt;
+
+	if(!client->event_handler)
+	{
+		return;
+	}
+	memset(&evt, 0, sizeof(evt));
+	evt.event_id = HTTP_EVENT_ON_HEADER;
+	evt.client = client;
+	evt.user_data = client->user_data;
+	evt.header_key = key;
+	evt.header_value = value;
+	client->event_handler(&evt);
+}
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *config)
+{
+	esp_http_client_handle_t client;
+
+	client = (esp_http_client_handle_t)calloc(1, sizeof(struct esp_http_client));
+	if(!client)
+	{
+		return NULL;
+	}
+	client->sock = -1;
+	client->event_handler = config->event_handler;
+	client->user_data = config->user_data;
+	client->method = config->method;
+	client->timeout_ms = config->timeout_ms ? config->timeout_ms : HOST_HTTP_TIMEOUT_MS;
+	client->complete = true;
+	if(host_http_parse_url(client, config->url) != ESP_OK)
+	{
+		free(client);
+		return NULL;
+	}
+	return client;
+}
+
+esp_err_t esp_http_client_set_url(esp_http_client_handle_t client, const char *url)
+{
+	return host_http_parse_url(client, url);
+}
+
+esp_err_t esp_http_client_set_method(esp_http_client_handle_t client, esp_http_client_method_t method)
+{
+	client->method = method;
+	return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client, const char *key, const char *value)
+{
+	unsigned int i;
+
+	if(strlen(key) >= sizeof(client->headers[0].key) || strlen(value) >= sizeof(client->headers[0].value))
+	{
+		return ESP_ERR_INVALID_ARG;
+	}
+	for(i = 0; i < client->header_count && strcasecmp(client->headers[i].key, key); i++);
+	if(i == HOST_HTTP_HEADERS)
+	{
+		return ESP_ERR_NO_MEM;
+	}
+	strcpy(client->headers[i].key, key);
+	strcpy(client->headers[i].value, value);
+	if(i == client->header_count)
+	{
+		client->header_count++;
+	}
+	return ESP_OK;
+}
+
+esp_err_t esp_http_client_delete_header(esp_http_client_handle_t client, const char *key)
+{
+	unsigned int i;
+
+	for(i = 0; i < client->header_count; i++)
+	{
+		if(!strcasecmp(client->headers[i].key, key))
+		{
+			client->headers[i] = client->headers[--client->header_count];
+			break;
+		}
+	}
+	return ESP_OK;
+}
+
+static esp_err_t host_http_connect(esp_http_client_handle_t client)
+{
+	struct addrinfo hints, *res;
+	struct timeval tv;
+	int one = 1, rcvbuf = HOST_HTTP_RCVBUF;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+	if(getaddrinfo(client->host, client->port, &hints, &res))
+	{
+		return ESP_ERR_HTTP_CONNECT;
+	}
+	client->sock = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+	if(client->sock >= 0)
+	{
+		/* the device window, a stalled upgrade stalls the server */
+		setsockopt(client->sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+	}
+	if(client->sock < 0 || connect(client->sock, res->ai_addr, res->ai_addrlen))
+	{
+		freeaddrinfo(res);
+		host_http_disconnect(client);
+		return ESP_ERR_HTTP_CONNECT;
+	}
+	freeaddrinfo(res);
+	tv.tv_sec = client->timeout_ms / 1000;
+	tv.tv_usec = (client->timeout_ms % 1000) * 1000;
+	setsockopt(client->sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	setsockopt(client->sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+	setsockopt(client->sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	snprintf(client->sock_host, sizeof(client->sock_host), "%s:%s", client->host, client->port);
+
+	if(client->ssl && host_http.handshake_us)
+	{
+		usleep(host_http.handshake_us);
+	}
+	pthread_mutex_lock(&host_http.lock);
+	host_http.stats.connections++;
+	pthread_mutex_unlock(&host_http.lock);
+	return ESP_OK;
+}
+
+/* the server closed the kept-alive connection, or sent what wasn't asked for */
+static bool host_http_stale(esp_http_client_handle_t client)
+{
+	struct pollfd pfd = { client->sock, POLLIN, 0 };
+
+	return client->buffer_pos != client->buffer_length || poll(&pfd, 1, 0) != 0;
+}
+
+esp_err_t esp_http_client_open(esp_http_client_handle_t client, int write_len)
+{
+	char request[HOST_HTTP_URL_SIZE + HOST_HTTP_HEADERS * 168 + 256];
+	char sock_host[sizeof(client->sock_host)];
+	int length, sent, rc;
+	unsigned int i;
+	esp_err_t err;
+
+	snprintf(sock_host, sizeof(sock_host), "%s:%s", client->host, client->port);
+	if(client->sock >= 0)
+	{
+		if(!client->complete || strcmp(client->sock_host, sock_host))
+		{
+			host_http_disconnect(client);
+		}
+		else if(host_http_stale(client))
+		{
+			host_http_disconnect(client);
+			return ESP_ERR_HTTP_CONNECT;
+		}
+	}
+	if(client->sock < 0)
+	{
+		err = host_http_connect(client);
+		if(err != ESP_OK)
+		{
+			return err;
+		}
+	}
+
+	length = snprintf
+				(
+					request, sizeof(request),
+					"%s %s HTTP/1.1\r\nHost: %s\r\nUser-Agent: ESP32 HTTP Client/1.0\r\n",
+					client->method == HTTP_METHOD_HEAD ? "HEAD" : "GET",
+					client->path,
+					client->host
+				);
+	for(i = 0; i < client->header_count; i++)
+	{
+		length += snprintf(request + length, sizeof(request) - length, "%s: %s\r\n", client->headers[i].key, client->headers[i].value);
+	}
+	length += snprintf(request + length, sizeof(request) - length, "\r\n");
+
+	for(sent = 0; sent < length; sent += rc)
+	{
+		rc = send(client->sock, request + sent, length - sent, MSG_NOSIGNAL);
+		if(rc <= 0)
+		{
+			host_http_disconnect(client);
+			return ESP_ERR_HTTP_WRITE_DATA;
+		}
+	}
+	client->status = 0;
+	client->content_length = 0;
+	client->chunked = false;
+	client->close = false;
+	client->no_body = client->method == HTTP_METHOD_HEAD;
+	client->remaining = 0;
+	client->complete = false;
+
+	pthread_mutex_lock(&host_http.lock);
+	host_http.stats.requests++;
+	pthread_mutex_unlock(&host_http.lock);
+	return ESP_OK;
+}
+
+int esp_http_client_fetch_headers(esp_http_client_handle_t client)
+{
+	char line[HOST_HTTP_LINE_SIZE];
+	char *value;
+	int length;
+
+	if(client->sock < 0 || host_http_line(client, line, sizeof(line)) < 0 ||
+		sscanf(line, "HTTP/1.%*d %d", &client->status) != 1)
+	{
+		host_http_disconnect(client);
+		return ESP_FAIL;
+	}
+	client->content_length = -1;
+	while((length = host_http_line(client, line, sizeof(line))) > 0)
+	{
+		value = strchr(line, ':');
+		if(!value)
+		{
+			continue;
+		}
+		*value++ = '\0';
+		value += strspn(value, " \t");
+		if(!strcasecmp(line, "Content-Length"))
+		{
+			client->content_length = atoi(value);
+		}
+		else if(!strcasecmp(line, "Transfer-Encoding") && !strcasecmp(value, "chunked"))
+		{
+			client->chunked = true;
+		}
+		else if(!strcasecmp(line, "Connection") && !strcasecmp(value, "close"))
+		{
+			client->close = true;
+		}
+		host_http_event(client, line, value);
+	}
+	if(length < 0)
+	{
+		host_http_disconnect(client);
+		return ESP_FAIL;
+	}
+
+	if(client->status == 204 || client->status == 304 || client->status / 100 == 1)
+	{
+		client->no_body = true;
+	}
+	if(client->chunked)
+	{
+		client->content_length = -1;
+	}
+	else if(client->content_length >= 0)
+	{
+		client->remaining = client->content_length;
+	}
+	else
+	{
+		/* up to the end of the connection */
+		client->close = true;
+	}
+	if(client->no_body || (!client->chunked && client->content_length == 0))
+	{
+		client->content_length = 0;
+		client->complete = true;
+		if(client->close)
+		{
+			host_http_disconnect(client);
+		}
+	}
+	return client->content_length > 0 ? client->content_length : 0;
+}
+
+bool esp_http_client_is_chunked_response(esp_http_client_handle_t client)
+{
+	return client->chunked;
+}
+
+int esp_http_client_get_status_code(esp_http_client_handle_t client)
+{
+	return client->status;
+}
+
+int esp_http_client_get_content_length(esp_http_client_handle_t client)
+{
+	return client->content_length;
+}
+
+/* next chunk size, 0 and complete after the last chunk */
+static int host_http_chunk(esp_http_client_handle_t client)
+{
+	char line[64];
+
+	if(host_http_line(client, line, sizeof(line)) < 0)
+	{
+		return -1;
+	}
+	client->remaining = strtoul(line, NULL, 16);
+	if(!client->remaining)
+	{
+		/* trailer */
+		while(host_http_line(client, line, sizeof(line)) > 0);
+		client->complete = true;
+	}
+	return 0;
+}
+
+/* as the SDK client: fills the buffer unless the body ends */
+int esp_http_client_read(esp_http_client_handle_t client, char *buffer, int len)
+{
+	char crlf[2];
+	int total = 0, rc;
+	uint32_t n;
+
+	while(total < len && !client->complete)
+	{
+		if(client->chunked && !client->remaining)
+		{
+			if(host_http_chunk(client) < 0)
+			{
+				host_http_disconnect(client);
+				return total ? total : ESP_FAIL;
+			}
+			continue;
+		}
+		n = len - total;
+		if(client->content_length >= 0 || client->chunked)
+		{
+			n = n < client->remaining ? n : client->remaining;
+		}
+		rc = host_http_recv(client, buffer + total, n);
+		if(rc < 0)
+		{
+			if(client->content_length < 0 && !client->chunked)
+			{
+				client->complete = true;
+				break;
+			}
+			host_http_disconnect(client);
+			return total ? total : ESP_FAIL;
+		}
+		total += rc;
+		if(client->content_length >= 0 || client->chunked)
+		{
+			client->remaining -= rc;
+		}
+		if(client->chunked && !client->remaining)
+		{
+			/* CRLF after the chunk data */
+			if(host_http_recv(client, crlf, 1) < 0 || host_http_recv(client, crlf + 1, 1) < 0)
+			{
+				host_http_disconnect(client);
+				return total ? total : ESP_FAIL;
+			}
+		}
+		else if(!client->chunked && client->content_length >= 0 && !client->remaining)
+		{
+			client->complete = true;
+		}
+	}
+	if(client->complete && client->close)
+	{
+		host_http_disconnect(client);
+	}
+	pthread_mutex_lock(&host_http.lock);
+	host_http.stats.bytes += total;
+	pthread_mutex_unlock(&host_http.lock);
+	return total;
+}
+
+bool esp_http_client_is_complete_data_received(esp_http_client_handle_t client)
+{
+	return client->complete;
+}
+
+esp_http_client_transport_t esp_http_client_get_transport_type(esp_http_client_handle_t client)
+{
+	return client->ssl ? HTTP_TRANSPORT_OVER_SSL : HTTP_TRANSPORT_OVER_TCP;
+}
+
+esp_err_t esp_http_client_close(esp_http_client_handle_t client)
+{
+	host_http_disconnect(client);
+	client->complete = true;
+	return ESP_OK;
+}
+
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client)
+{
+	host_http_disconnect(client);
+	free(client);
+	return ESP_OK;
+}
+
+/*
+ * EOF
+ */
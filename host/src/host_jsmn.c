@@ -0,0 +1,329 @@
+/*****************************************************************************
+* File Name: host_jsmn.c
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+#include <stddef.h>
+
+#include "jsmn/jsmn.h"
+
+/* jsmn 1.x (MIT, Serge Zaitsev), non-strict mode without parent links */
+
+static jsmntok_t *jsmn_alloc_token(jsmn_parser *parser, jsmntok_t *tokens, size_t num_tokens)
+{
+	jsmntok_t *tok;
+
+	if(parser->toknext >= num_tokens)
+	{
+		return NULL;
+	}
+	tok = &tokens[parser->toknext++];
+	tok->start = tok->end = -1;
+	tok->size = 0;
+	return tok;
+}
+
+static void jsmn_fill_token(jsmntok_t *token, jsmntype_t type, int start, int end)
+{
+	token->type = type;
+	token->start = start;
+	token->end = end;
+	token->size = 0;
+}
+
+static int jsmn_parse_primitive(jsmn_parser *parser, const char *js, size_t len, jsmntok_t *tokens, size_t num_tokens)
+{
+	jsmntok_t *token;
+	int start = parser->pos;
+
+	for(; parser->pos < len && js[parser->pos] != '\0'; parser->pos++)
+	{
+		switch(js[parser->pos])
+		{
+			case ':':
+			case '\t':
+			case '\r':
+			case '\n':
+			case ' ':
+			case ',':
+			case ']':
+			case '}':
+				goto found;
+		}
+		if(js[parser->pos] < 32 || js[parser->pos] >= 127)
+		{
+			parser->pos = start;
+			return JSMN_ERROR_INVAL;
+		}
+	}
+
+found:
+	if(!tokens)
+	{
+		parser->pos--;
+		return 0;
+	}
+	token = jsmn_alloc_token(parser, tokens, num_tokens);
+	if(!token)
+	{
+		parser->pos = start;
+		return JSMN_ERROR_NOMEM;
+	}
+	jsmn_fill_token(token, JSMN_PRIMITIVE, start, parser->pos);
+	parser->pos--;
+	return 0;
+}
+
+static int jsmn_parse_string(jsmn_parser *parser, const char *js, size_t len, jsmntok_t *tokens, size_t num_tokens)
+{
+	jsmntok_t *token;
+	int start = parser->pos;
+	int i;
+	char c;
+
+	parser->pos++;
+	for(; parser->pos < len && js[parser->pos] != '\0'; parser->pos++)
+	{
+		c = js[parser->pos];
+		if(c == '\"')
+		{
+			if(!tokens)
+			{
+				return 0;
+			}
+			token = jsmn_alloc_token(parser, tokens, num_tokens);
+			if(!token)
+			{
+				parser->pos = start;
+				return JSMN_ERROR_NOMEM;
+			}
+			jsmn_fill_token(token, JSMN_STRING, start + 1, parser->pos);
+			return 0;
+		}
+		if(c == '\\' && parser->pos + 1 < len)
+		{
+			parser->pos++;
+			switch(js[parser->pos])
+			{
+				case '\"':
+				case '/':
+				case '\\':
+				case 'b':
+				case 'f':
+				case 'r':
+				case 'n':
+				case 't':
+					break;
+				case 'u':
+					parser->pos++;
+					for(i = 0; i < 4 && parser->pos < len && js[parser->pos] != '\0'; i++)
+					{
+						c = js[parser->pos];
+						if(!((c >= '0' && c <= '9') || (c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f')))
+						{
+							parser->pos = start;
+							return JSMN_ERROR_INVAL;
+						}
+						parser->pos++;
+					}
+					parser->pos--;
+					break;
+				default:
+					parser->pos = start;
+					return JSMN_ERROR_INVAL;
+			}
+		}
+	}
+	parser->pos = start;
+	return JSMN_ERROR_PART;
+}
+
+int jsmn_parse(jsmn_parser *parser, const char *js, size_t len, jsmntok_t *tokens, unsigned int num_tokens)
+{
+	jsmntype_t type;
+	jsmntok_t *token;
+	int count = parser->toknext;
+	int r, i;
+	char c;
+
+	for(; parser->pos < len && js[parser->pos] != '\0'; parser->pos++)
+	{
+		c = js[parser->pos];
+		switch(c)
+		{
+			case '{':
+			case '[':
+				count++;
+				if(!tokens)
+				{
+					break;
+				}
+				token = jsmn_alloc_token(parser, tokens, num_tokens);
+				if(!token)
+				{
+					return JSMN_ERROR_NOMEM;
+				}
+				if(parser->toksuper != -1)
+				{
+					tokens[parser->toksuper].size++;
+				}
+				token->type = (c == '{' ? JSMN_OBJECT : JSMN_ARRAY);
+				token->start = parser->pos;
+				parser->toksuper = parser->toknext - 1;
+				break;
+			case '}':
+			case ']':
+				if(!tokens)
+				{
+					break;
+				}
+				type = (c == '}' ? JSMN_OBJECT : JSMN_ARRAY);
+				for(i = parser->toknext - 1; i >= 0; i--)
+				{
+					token = &tokens[i];
+					if(token->start != -1 && token->end == -1)
+					{
+						if(token->type != type)
+						{
+							return JSMN_ERROR_INVAL;
+						}
+						parser->toksuper = -1;
+						token->end = parser->pos + 1;
+						break;
+					}
+				}
+				if(i == -1)
+				{
+					return JSMN_ERROR_INVAL;
+				}
+				for(; i >= 0; i--)
+				{
+					token = &tokens[i];
+					if(token->start != -1 && token->end == -1)
+					{
+						parser->toksuper = i;
+						break;
+					}
+				}
+				break;
+			case '\"':
+				r = jsmn_parse_string(parser, js, len, tokens, num_tokens);
+				if(r < 0)
+				{
+					return r;
+				}
+				count++;
+				if(parser->toksuper != -1 && tokens)
+				{
+					tokens[parser->toksuper].size++;
+				}
+				break;
+			case '\t':
+			case '\r':
+			case '\n':
+			case ' ':
+				break;
+			case ':':
+				parser->toksuper = parser->toknext - 1;
+				break;
+			case ',':
+				if(tokens && parser->toksuper != -1 &&
+					tokens[parser->toksuper].type != JSMN_ARRAY &&
+					tokens[parser->toksuper].type != JSMN_OBJECT)
+				{
+					for(i = parser->toknext - 1; i >= 0; i--)
+					{
+						if(tokens[i].type == JSMN_ARRAY || tokens[i].type == JSMN_OBJECT)
+						{
+							if(tokens[i].start != -1 && tokens[i].end == -1)
+							{
+								parser->toksuper = i;
+								break;
+							}
+						}
+					}
+				}
+				break;
+			default:
+				r = jsmn_parse_primitive(parser, js, len, tokens, num_tokens);
+				if(r < 0)
+				{
+					return r;
+				}
+				count++;
+				if(parser->toksuper != -1 && tokens)
+				{
+					tokens[parser->toksuper].size++;
+				}
+				break;
+		}
+	}
+
+	if(tokens)
+	{
+		for(i = parser->toknext - 1; i >= 0; i--)
+		{
+			if(tokens[i].start != -1 && tokens[i].end == -1)
+			{
+				return JSMN_ERROR_PART;
+			}
+		}
+	}
+	return count;
+}
+
+void jsmn_init(jsmn_parser *parser)
+{
+	parser->pos = 0;
+	parser->toknext = 0;
+	parser->toksuper = -1;
+}
+
+/*
+ * EOF
+ */
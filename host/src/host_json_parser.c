@@ -0,0 +1,112 @@
+/*****************************************************************************
+* File Name: host_json_parser.c
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+#include <string.h>
+
+#include "jsmn/jsmn.h"
+#include "json_parser.h"
+#include "json_jsmn.h"
+
+/* tokens of the value at t, its nested values included */
+static int json_span(const jsmntok_t *t, int count)
+{
+	int n;
+
+	for(n = 1; n < count && t[n].start < t->end; n++);
+	return n;
+}
+
+int json_parse
+	(
+		const char *js,
+		unsigned int jslen,
+		jsmntok_t *tokens,
+		int tokcount,
+		const char **keys_filter_list,
+		json_jsmntok_t *json_jsmntok,
+		int json_jsmntok_count
+	)
+{
+	jsmn_parser parser;
+	const char **key;
+	int i, found, count;
+
+	jsmn_init(&parser);
+	count = jsmn_parse(&parser, js, jslen, tokens, tokcount);
+	if(count < 0)
+	{
+		return count;
+	}
+	if(count < 1 || tokens[0].type != JSMN_OBJECT)
+	{
+		return JSMN_ERROR_INVAL;
+	}
+
+	found = 0;
+	for(i = 1; i + 1 < count && found < json_jsmntok_count; i += 1 + json_span(&tokens[i + 1], count - i - 1))
+	{
+		for(key = keys_filter_list; *key; key++)
+		{
+			if(tokens[i].type == JSMN_STRING && 0 == jsmntok_strcmp(js, &tokens[i], *key))
+			{
+				json_jsmntok[found].t_key = &tokens[i];
+				json_jsmntok[found].t_value = &tokens[i + 1];
+				json_jsmntok[found].t_value_type = tokens[i + 1].type;
+				found++;
+				break;
+			}
+		}
+	}
+	return found;
+}
+
+/*
+ * EOF
+ */
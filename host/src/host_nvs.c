@@ -0,0 +1,243 @@
+/*****************************************************************************
+* File Name: host_nvs.c
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "nvs.h"
+#include "nvs_flash.h"
+
+#include "esp_ota_host.h"
+
+#define HOST_NVS_NAMESPACES		(8)
+#define HOST_NVS_ENTRIES		(32)
+#define HOST_NVS_KEY_SIZE		(16)	/* NVS_KEY_NAME_MAX_SIZE */
+#define HOST_NVS_BLOB_SIZE		(4096)
+
+typedef struct
+{
+	bool used;
+	nvs_handle handle;
+	char key[HOST_NVS_KEY_SIZE];
+	uint8_t value[HOST_NVS_BLOB_SIZE];
+	size_t length;
+}host_nvs_entry_t;
+
+/* RAM only, commit is a no-op */
+static struct
+{
+	pthread_mutex_t lock;
+	char names[HOST_NVS_NAMESPACES][HOST_NVS_KEY_SIZE];
+	unsigned int name_count;
+	host_nvs_entry_t entries[HOST_NVS_ENTRIES];
+}host_nvs = { PTHREAD_MUTEX_INITIALIZER };
+
+static host_nvs_entry_t *host_nvs_find(nvs_handle handle, const char *key, bool create)
+{
+	host_nvs_entry_t *free_entry = NULL;
+	unsigned int i;
+
+	for(i = 0; i < HOST_NVS_ENTRIES; i++)
+	{
+		if(!host_nvs.entries[i].used)
+		{
+			free_entry = free_entry ? free_entry : &host_nvs.entries[i];
+		}
+		else if(host_nvs.entries[i].handle == handle && !strcmp(host_nvs.entries[i].key, key))
+		{
+			return &host_nvs.entries[i];
+		}
+	}
+	if(!create || !free_entry)
+	{
+		return NULL;
+	}
+	free_entry->used = true;
+	free_entry->handle = handle;
+	strcpy(free_entry->key, key);
+	return free_entry;
+}
+
+static esp_err_t host_nvs_set(nvs_handle handle, const char *key, const void *value, size_t length)
+{
+	host_nvs_entry_t *entry;
+
+	if(!key || strlen(key) >= HOST_NVS_KEY_SIZE || length > HOST_NVS_BLOB_SIZE)
+	{
+		return ESP_ERR_INVALID_ARG;
+	}
+	pthread_mutex_lock(&host_nvs.lock);
+	entry = host_nvs_find(handle, key, true);
+	if(entry)
+	{
+		memcpy(entry->value, value, length);
+		entry->length = length;
+	}
+	pthread_mutex_unlock(&host_nvs.lock);
+	return entry ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+static esp_err_t host_nvs_get(nvs_handle handle, const char *key, void *value, size_t *length)
+{
+	host_nvs_entry_t *entry;
+	esp_err_t err = ESP_OK;
+
+	pthread_mutex_lock(&host_nvs.lock);
+	entry = host_nvs_find(handle, key, false);
+	if(!entry)
+	{
+		err = ESP_ERR_NVS_NOT_FOUND;
+	}
+	else if(value && *length < entry->length)
+	{
+		err = ESP_ERR_NVS_INVALID_LENGTH;
+	}
+	else
+	{
+		if(value)
+		{
+			memcpy(value, entry->value, entry->length);
+		}
+		*length = entry->length;
+	}
+	pthread_mutex_unlock(&host_nvs.lock);
+	return err;
+}
+
+void host_nvs_reset(void)
+{
+	pthread_mutex_lock(&host_nvs.lock);
+	memset(host_nvs.entries, 0, sizeof(host_nvs.entries));
+	pthread_mutex_unlock(&host_nvs.lock);
+}
+
+esp_err_t nvs_flash_init(void)
+{
+	return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode open_mode, nvs_handle *out_handle)
+{
+	unsigned int i;
+	esp_err_t err = ESP_OK;
+
+	if(!name || strlen(name) >= HOST_NVS_KEY_SIZE)
+	{
+		return ESP_ERR_INVALID_ARG;
+	}
+	pthread_mutex_lock(&host_nvs.lock);
+	for(i = 0; i < host_nvs.name_count && strcmp(host_nvs.names[i], name); i++);
+	if(i == host_nvs.name_count)
+	{
+		if(i == HOST_NVS_NAMESPACES)
+		{
+			err = ESP_ERR_NO_MEM;
+		}
+		else
+		{
+			strcpy(host_nvs.names[i], name);
+			host_nvs.name_count++;
+		}
+	}
+	*out_handle = i;
+	pthread_mutex_unlock(&host_nvs.lock);
+	return err;
+}
+
+esp_err_t nvs_get_u32(nvs_handle handle, const char *key, uint32_t *out_value)
+{
+	size_t length = sizeof(uint32_t);
+
+	return host_nvs_get(handle, key, out_value, &length);
+}
+
+esp_err_t nvs_set_u32(nvs_handle handle, const char *key, uint32_t value)
+{
+	return host_nvs_set(handle, key, &value, sizeof(value));
+}
+
+esp_err_t nvs_get_blob(nvs_handle handle, const char *key, void *out_value, size_t *length)
+{
+	return host_nvs_get(handle, key, out_value, length);
+}
+
+esp_err_t nvs_set_blob(nvs_handle handle, const char *key, const void *value, size_t length)
+{
+	return host_nvs_set(handle, key, value, length);
+}
+
+esp_err_t nvs_erase_key(nvs_handle handle, const char *key)
+{
+	host_nvs_entry_t *entry;
+
+	pthread_mutex_lock(&host_nvs.lock);
+	entry = host_nvs_find(handle, key, false);
+	if(entry)
+	{
+		entry->used = false;
+	}
+	pthread_mutex_unlock(&host_nvs.lock);
+	return entry ? ESP_OK : ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_commit(nvs_handle handle)
+{
+	return ESP_OK;
+}
+
+void nvs_close(nvs_handle handle)
+{
+}
+
+/*
+ * EOF
+ */
@@ -0,0 +1,651 @@
+/*****************************************************************************
+* File Name: host_server.c
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "esp_err.h"
+
+#include "esp_ota_host.h"
+
+#define HOST_SERVER_RESOURCES		(16)
+#define HOST_SERVER_CONNECTIONS		(32)
+#define HOST_SERVER_PATH_SIZE		(128)
+#define HOST_SERVER_REQUEST_SIZE	(2048)
+#define HOST_SERVER_SEGMENT			(1024)	/* body bytes per send of a shaped link */
+#define HOST_SERVER_SNDBUF			(8192)
+#define HOST_SERVER_CORRUPTS		(8)		/* corrupted offsets per resource */
+
+typedef struct
+{
+	char path[HOST_SERVER_PATH_SIZE];
+	const uint8_t *data;
+	uint32_t length;
+	const char *content_type;
+	const char *etag;
+	uint32_t corrupt_offset[HOST_SERVER_CORRUPTS];
+	uint32_t corrupt_count[HOST_SERVER_CORRUPTS];	/* 0: free */
+}host_server_resource_t;
+
+struct host_server
+{
+	host_server_config_t config;
+	int sock;
+	uint16_t port;
+	pthread_t thread;
+
+	pthread_mutex_t lock;
+	pthread_cond_t idle;
+	bool stopping;
+	int connections[HOST_SERVER_CONNECTIONS];	/* -1: free */
+	unsigned int connection_count;
+
+	host_server_resource_t resources[HOST_SERVER_RESOURCES];
+	unsigned int resource_count;
+	host_server_stats_t stats;
+};
+
+typedef struct
+{
+	host_server_handle_t server;
+	int sock;
+	unsigned int slot;
+}host_server_connection_t;
+
+typedef struct
+{
+	char method[8];
+	char path[HOST_SERVER_PATH_SIZE];
+	char if_none_match[128];
+	bool range;
+	uint32_t range_start;
+	uint32_t range_end;		/* inclusive, UINT32_MAX: up to the end */
+	bool close;
+}host_server_request_t;
+
+static uint64_t host_server_time_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static bool host_server_send(int sock, const void *data, uint32_t length)
+{
+	const uint8_t *p = (const uint8_t *)data;
+	ssize_t rc;
+
+	while(length)
+	{
+		rc = send(sock, p, length, MSG_NOSIGNAL);
+		if(rc <= 0)
+		{
+			return false;
+		}
+		p += rc;
+		length -= rc;
+	}
+	return true;
+}
+
+/* request line and headers, false: the connection is closed or broken */
+static bool host_server_request(int sock, char *buffer, unsigned int size, unsigned int *length, host_server_request_t *request)
+{
+	char *end, *line, *next, *value;
+	unsigned int used;
+	ssize_t rc;
+
+	while(!(end = memmem(buffer, *length, "\r\n\r\n", 4)))
+	{
+		if(*length >= size - 1)
+		{
+			return false;
+		}
+		rc = recv(sock, buffer + *length, size - 1 - *length, 0);
+		if(rc <= 0)
+		{
+			return false;
+		}
+		*length += rc;
+	}
+	*end = '\0';
+	used = end + 4 - buffer;
+
+	memset(request, 0, sizeof(host_server_request_t));
+	if(sscanf(buffer, "%7s %127s HTTP/1.%*d", request->method, request->path) != 2)
+	{
+		return false;
+	}
+	for(line = strstr(buffer, "\r\n"); line; line = next)
+	{
+		line += 2;
+		next = strstr(line, "\r\n");
+		if(next)
+		{
+			*next = '\0';
+		}
+		value = strchr(line, ':');
+		if(!value)
+		{
+			continue;
+		}
+		*value++ = '\0';
+		value += strspn(value, " \t");
+		if(!strcasecmp(line, "Range"))
+		{
+			request->range_end = UINT32_MAX;
+			request->range = sscanf(value, "bytes=%u-%u", &request->range_start, &request->range_end) >= 1;
+		}
+		else if(!strcasecmp(line, "If-None-Match"))
+		{
+			snprintf(request->if_none_match, sizeof(request->if_none_match), "%s", value);
+		}
+		else if(!strcasecmp(line, "Connection") && !strcasecmp(value, "close"))
+		{
+			request->close = true;
+		}
+	}
+
+	/* pipelined bytes of the next request */
+	memmove(buffer, buffer + used, *length - used);
+	*length -= used;
+	return true;
+}
+
+static host_server_resource_t *host_server_find(host_server_handle_t server, const char *path)
+{
+	unsigned int i;
+
+	for(i = 0; i < server->resource_count; i++)
+	{
+		if(!strcmp(server->resources[i].path, path))
+		{
+			return &server->resources[i];
+		}
+	}
+	return NULL;
+}
+
+/* body bytes [start, start + length) at the configured rate, cut after cut bytes */
+static bool host_server_body
+	(
+		host_server_handle_t server,
+		int sock,
+		host_server_resource_t *resource,
+		uint32_t start,
+		uint32_t length,
+		uint32_t cut,
+		bool chunked
+	)
+{
+	uint8_t segment[HOST_SERVER_SEGMENT + 16];
+	uint32_t sent, n, corrupt_offset[HOST_SERVER_CORRUPTS];
+	uint64_t now, due;
+	char size[16];
+	bool corrupt[HOST_SERVER_CORRUPTS];
+	unsigned int i;
+
+	pthread_mutex_lock(&server->lock);
+	for(i = 0; i < HOST_SERVER_CORRUPTS; i++)
+	{
+		corrupt_offset[i] = resource->corrupt_offset[i];
+		corrupt[i] = resource->corrupt_count[i] && corrupt_offset[i] >= start && corrupt_offset[i] - start < length;
+		if(corrupt[i])
+		{
+			resource->corrupt_count[i]--;
+		}
+	}
+	pthread_mutex_unlock(&server->lock);
+
+	due = host_server_time_us();
+	for(sent = 0; sent < length && sent < cut; sent += n)
+	{
+		n = length - sent;
+		n = n < HOST_SERVER_SEGMENT ? n : HOST_SERVER_SEGMENT;
+		n = n < cut - sent ? n : cut - sent;
+		memcpy(segment, resource->data + start + sent, n);
+		for(i = 0; i < HOST_SERVER_CORRUPTS; i++)
+		{
+			if(corrupt[i] && corrupt_offset[i] >= start + sent && corrupt_offset[i] < start + sent + n)
+			{
+				segment[corrupt_offset[i] - start - sent] ^= 0x40;
+			}
+		}
+		if(chunked)
+		{
+			snprintf(size, sizeof(size), "%x\r\n", n);
+			memcpy(segment + n, "\r\n", 2);
+			if(!host_server_send(sock, size, strlen(size)) || !host_server_send(sock, segment, n + 2))
+			{
+				return false;
+			}
+		}
+		else if(!host_server_send(sock, segment, n))
+		{
+			return false;
+		}
+
+		pthread_mutex_lock(&server->lock);
+		server->stats.bytes += n;
+		pthread_mutex_unlock(&server->lock);
+		/* a stalled reader doesn't earn a burst afterwards */
+		if(server->config.rate)
+		{
+			due += (uint64_t)n * 1000000 / server->config.rate;
+			now = host_server_time_us();
+			if(due > now)
+			{
+				usleep(due - now);
+			}
+			else
+			{
+				due = now;
+			}
+		}
+	}
+	if(sent < length)
+	{
+		return false;
+	}
+	return !chunked || host_server_send(sock, "0\r\n\r\n", 5);
+}
+
+/* false: the connection is closed after it */
+static bool host_server_respond(host_server_handle_t server, int sock, const host_server_request_t *request, bool last)
+{
+	host_server_resource_t *resource;
+	char header[512];
+	uint32_t start, length, cut, number;
+	bool head, chunked;
+	int n;
+
+	pthread_mutex_lock(&server->lock);
+	number = ++server->stats.requests;
+	resource = host_server_find(server, request->path);
+	if(request->range && !server->config.no_range)
+	{
+		server->stats.range_requests++;
+	}
+	pthread_mutex_unlock(&server->lock);
+
+	if(server->config.latency_us)
+	{
+		usleep(server->config.latency_us);
+	}
+	head = !strcmp(request->method, "HEAD");
+	last |= request->close;
+
+	if(!resource)
+	{
+		n = snprintf(header, sizeof(header), "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n%s\r\n", last ? "Connection: close\r\n" : "");
+		return host_server_send(sock, header, n) && !last;
+	}
+	if(resource->etag && !strcmp(request->if_none_match, resource->etag))
+	{
+		n = snprintf(header, sizeof(header), "HTTP/1.1 304 Not Modified\r\nETag: %s\r\n%s\r\n", resource->etag, last ? "Connection: close\r\n" : "");
+		return host_server_send(sock, header, n) && !last;
+	}
+
+	start = 0;
+	length = resource->length;
+	if(request->range && !server->config.no_range)
+	{
+		if(request->range_start >= resource->length || request->range_end < request->range_start)
+		{
+			n = snprintf(header, sizeof(header), "HTTP/1.1 416 Range Not Satisfiable\r\nContent-Range: bytes */%u\r\nContent-Length: 0\r\n%s\r\n", resource->length, last ? "Connection: close\r\n" : "");
+			return host_server_send(sock, header, n) && !last;
+		}
+		start = request->range_start;
+		length = (request->range_end < resource->length ? request->range_end + 1 : resource->length) - start;
+		n = snprintf(header, sizeof(header), "HTTP/1.1 206 Partial Content\r\nContent-Range: bytes %u-%u/%u\r\nContent-Length: %u\r\n", start, start + length - 1, resource->length, length);
+		chunked = false;
+	}
+	else if(server->config.chunked)
+	{
+		n = snprintf(header, sizeof(header), "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n");
+		chunked = true;
+	}
+	else
+	{
+		n = snprintf(header, sizeof(header), "HTTP/1.1 200 OK\r\nContent-Length: %u\r\n", length);
+		chunked = false;
+	}
+	n += snprintf
+			(
+				header + n, sizeof(header) - n,
+				"Content-Type: %s\r\nAccept-Ranges: %s\r\n",
+				resource->content_type ? resource->content_type : "application/octet-stream",
+				server->config.no_range ? "none" : "bytes"
+			);
+	if(resource->etag)
+	{
+		n += snprintf(header + n, sizeof(header) - n, "ETag: %s\r\n", resource->etag);
+	}
+	n += snprintf(header + n, sizeof(header) - n, "%s\r\n", last ? "Connection: close\r\n" : "");
+	if(!host_server_send(sock, header, n))
+	{
+		return false;
+	}
+	if(head)
+	{
+		return !last;
+	}
+
+	cut = length;
+	if(server->config.fail_every && !(number % server->config.fail_every) && length > 1)
+	{
+		cut = length / 2;
+		pthread_mutex_lock(&server->lock);
+		server->stats.failed++;
+		pthread_mutex_unlock(&server->lock);
+	}
+	return host_server_body(server, sock, resource, start, length, cut, chunked) && !last;
+}
+
+static void *host_server_connection(void *arg)
+{
+	host_server_connection_t connection = *(host_server_connection_t *)arg;
+	host_server_handle_t server = connection.server;
+	host_server_request_t request;
+	char buffer[HOST_SERVER_REQUEST_SIZE];
+	unsigned int length = 0;
+	uint32_t count;
+
+	free(arg);
+	for(count = 1;; count++)
+	{
+		if(!host_server_request(connection.sock, buffer, sizeof(buffer), &length, &request) ||
+			!host_server_respond(server, connection.sock, &request, count == server->config.keep_alive))
+		{
+			break;
+		}
+	}
+
+	pthread_mutex_lock(&server->lock);
+	shutdown(connection.sock, SHUT_RDWR);
+	close(connection.sock);
+	server->connections[connection.slot] = -1;
+	server->connection_count--;
+	pthread_cond_broadcast(&server->idle);
+	pthread_mutex_unlock(&server->lock);
+	return NULL;
+}
+
+static void *host_server_accept(void *arg)
+{
+	host_server_handle_t server = (host_server_handle_t)arg;
+	host_server_connection_t *connection;
+	pthread_t thread;
+	unsigned int slot;
+	int sock, one = 1, sndbuf = HOST_SERVER_SNDBUF;
+
+	for(;;)
+	{
+		sock = accept(server->sock, NULL, NULL);
+		if(sock < 0)
+		{
+			break;
+		}
+		setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+		setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+
+		pthread_mutex_lock(&server->lock);
+		for(slot = 0; slot < HOST_SERVER_CONNECTIONS && server->connections[slot] >= 0; slot++);
+		connection = NULL;
+		if(!server->stopping && slot < HOST_SERVER_CONNECTIONS)
+		{
+			connection = (host_server_connection_t *)malloc(sizeof(host_server_connection_t));
+		}
+		if(!connection)
+		{
+			pthread_mutex_unlock(&server->lock);
+			close(sock);
+			continue;
+		}
+		connection->server = server;
+		connection->sock = sock;
+		connection->slot = slot;
+		server->connections[slot] = sock;
+		server->connection_count++;
+		server->stats.connections++;
+		if(pthread_create(&thread, NULL, host_server_connection, connection))
+		{
+			server->connections[slot] = -1;
+			server->connection_count--;
+			close(sock);
+			free(connection);
+		}
+		else
+		{
+			pthread_detach(thread);
+		}
+		pthread_mutex_unlock(&server->lock);
+	}
+	return NULL;
+}
+
+esp_err_t host_server_start(const host_server_config_t *config, host_server_handle_t *out)
+{
+	host_server_handle_t server;
+	struct sockaddr_in addr;
+	socklen_t addr_length = sizeof(addr);
+	unsigned int i;
+	int one = 1;
+
+	server = (host_server_handle_t)calloc(1, sizeof(struct host_server));
+	if(!server)
+	{
+		return ESP_ERR_NO_MEM;
+	}
+	if(config)
+	{
+		server->config = *config;
+	}
+	for(i = 0; i < HOST_SERVER_CONNECTIONS; i++)
+	{
+		server->connections[i] = -1;
+	}
+	pthread_mutex_init(&server->lock, NULL);
+	pthread_cond_init(&server->idle, NULL);
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	server->sock = socket(AF_INET, SOCK_STREAM, 0);
+	if(server->sock < 0 ||
+		setsockopt(server->sock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) ||
+		bind(server->sock, (struct sockaddr *)&addr, sizeof(addr)) ||
+		listen(server->sock, 16) ||
+		getsockname(server->sock, (struct sockaddr *)&addr, &addr_length) ||
+		pthread_create(&server->thread, NULL, host_server_accept, server))
+	{
+		if(server->sock >= 0)
+		{
+			close(server->sock);
+		}
+		free(server);
+		return ESP_FAIL;
+	}
+	server->port = ntohs(addr.sin_port);
+	*out = server;
+	return ESP_OK;
+}
+
+void host_server_stop(host_server_handle_t server)
+{
+	unsigned int i;
+
+	pthread_mutex_lock(&server->lock);
+	server->stopping = true;
+	pthread_mutex_unlock(&server->lock);
+	shutdown(server->sock, SHUT_RDWR);
+	pthread_join(server->thread, NULL);
+	close(server->sock);
+
+	pthread_mutex_lock(&server->lock);
+	for(i = 0; i < HOST_SERVER_CONNECTIONS; i++)
+	{
+		if(server->connections[i] >= 0)
+		{
+			shutdown(server->connections[i], SHUT_RDWR);
+		}
+	}
+	while(server->connection_count)
+	{
+		pthread_cond_wait(&server->idle, &server->lock);
+	}
+	pthread_mutex_unlock(&server->lock);
+
+	pthread_cond_destroy(&server->idle);
+	pthread_mutex_destroy(&server->lock);
+	free(server);
+}
+
+void host_server_url(host_server_handle_t server, const char *path, char *url, unsigned int size)
+{
+	snprintf(url, size, "https://127.0.0.1:%u%s", server->port, path);
+}
+
+esp_err_t host_server_add
+	(
+		host_server_handle_t server,
+		const char *path,
+		const void *data,
+		uint32_t length,
+		const char *content_type,
+		const char *etag
+	)
+{
+	host_server_resource_t *resource;
+	esp_err_t err = ESP_OK;
+
+	if(strlen(path) >= HOST_SERVER_PATH_SIZE)
+	{
+		return ESP_ERR_INVALID_ARG;
+	}
+	pthread_mutex_lock(&server->lock);
+	resource = host_server_find(server, path);
+	if(!resource && server->resource_count < HOST_SERVER_RESOURCES)
+	{
+		resource = &server->resources[server->resource_count++];
+	}
+	if(resource)
+	{
+		memset(resource, 0, sizeof(host_server_resource_t));
+		strcpy(resource->path, path);
+		resource->data = (const uint8_t *)data;
+		resource->length = length;
+		resource->content_type = content_type;
+		resource->etag = etag;
+	}
+	else
+	{
+		err = ESP_ERR_NO_MEM;
+	}
+	pthread_mutex_unlock(&server->lock);
+	return err;
+}
+
+void host_server_corrupt(host_server_handle_t server, const char *path, uint32_t offset, uint32_t count)
+{
+	host_server_resource_t *resource;
+	unsigned int i, slot;
+
+	pthread_mutex_lock(&server->lock);
+	resource = host_server_find(server, path);
+	if(resource)
+	{
+		/* the same offset again, else a free slot, else the first one */
+		for(i = 0, slot = HOST_SERVER_CORRUPTS; i < HOST_SERVER_CORRUPTS; i++)
+		{
+			if(resource->corrupt_count[i] && resource->corrupt_offset[i] == offset)
+			{
+				slot = i;
+				break;
+			}
+			if(!resource->corrupt_count[i] && slot == HOST_SERVER_CORRUPTS)
+			{
+				slot = i;
+			}
+		}
+		if(slot == HOST_SERVER_CORRUPTS)
+		{
+			slot = 0;
+		}
+		resource->corrupt_offset[slot] = offset;
+		resource->corrupt_count[slot] = count;
+	}
+	pthread_mutex_unlock(&server->lock);
+}
+
+void host_server_get_stats(host_server_handle_t server, host_server_stats_t *stats)
+{
+	pthread_mutex_lock(&server->lock);
+	*stats = server->stats;
+	pthread_mutex_unlock(&server->lock);
+}
+
+/*
+ * EOF
+ */
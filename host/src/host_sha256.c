@@ -0,0 +1,211 @@
+/*****************************************************************************
+* File Name: host_sha256.c
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "mbedtls/sha256.h"
+
+#define HOST_SHA256_ROTR(x, n)	(((x) >> (n)) | ((x) << (32 - (n))))
+
+static const uint32_t host_sha256_k[64] =
+{
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static void host_sha256_block(uint32_t state[8], const unsigned char *data)
+{
+	uint32_t w[64], s[8], t1, t2;
+	int i;
+
+	for(i = 0; i < 16; i++)
+	{
+		w[i] = ((uint32_t)data[4 * i] << 24) | ((uint32_t)data[4 * i + 1] << 16) |
+			((uint32_t)data[4 * i + 2] << 8) | data[4 * i + 3];
+	}
+	for(; i < 64; i++)
+	{
+		w[i] = (HOST_SHA256_ROTR(w[i - 2], 17) ^ HOST_SHA256_ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10)) + w[i - 7] +
+			(HOST_SHA256_ROTR(w[i - 15], 7) ^ HOST_SHA256_ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3)) + w[i - 16];
+	}
+	memcpy(s, state, sizeof(s));
+	for(i = 0; i < 64; i++)
+	{
+		t1 = s[7] + (HOST_SHA256_ROTR(s[4], 6) ^ HOST_SHA256_ROTR(s[4], 11) ^ HOST_SHA256_ROTR(s[4], 25)) +
+			((s[4] & s[5]) ^ (~s[4] & s[6])) + host_sha256_k[i] + w[i];
+		t2 = (HOST_SHA256_ROTR(s[0], 2) ^ HOST_SHA256_ROTR(s[0], 13) ^ HOST_SHA256_ROTR(s[0], 22)) +
+			((s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]));
+		s[7] = s[6];
+		s[6] = s[5];
+		s[5] = s[4];
+		s[4] = s[3] + t1;
+		s[3] = s[2];
+		s[2] = s[1];
+		s[1] = s[0];
+		s[0] = t1 + t2;
+	}
+	for(i = 0; i < 8; i++)
+	{
+		state[i] += s[i];
+	}
+}
+
+void mbedtls_sha256_init(mbedtls_sha256_context *ctx)
+{
+	memset(ctx, 0, sizeof(mbedtls_sha256_context));
+}
+
+void mbedtls_sha256_free(mbedtls_sha256_context *ctx)
+{
+	if(ctx)
+	{
+		memset(ctx, 0, sizeof(mbedtls_sha256_context));
+	}
+}
+
+void mbedtls_sha256_clone(mbedtls_sha256_context *dst, const mbedtls_sha256_context *src)
+{
+	*dst = *src;
+}
+
+/* SHA-256 only, is224 is kept for the signature */
+int mbedtls_sha256_starts_ret(mbedtls_sha256_context *ctx, int is224)
+{
+	static const uint32_t iv[8] =
+	{
+		0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+	};
+
+	ctx->total[0] = 0;
+	ctx->total[1] = 0;
+	memcpy(ctx->state, iv, sizeof(iv));
+	ctx->is224 = is224;
+	return 0;
+}
+
+int mbedtls_sha256_update_ret(mbedtls_sha256_context *ctx, const unsigned char *input, size_t ilen)
+{
+	size_t left = ctx->total[0] & 63;
+	size_t fill = 64 - left;
+
+	ctx->total[0] += (uint32_t)ilen;
+	if(ctx->total[0] < (uint32_t)ilen)
+	{
+		ctx->total[1]++;
+	}
+	if(left && ilen >= fill)
+	{
+		memcpy(ctx->buffer + left, input, fill);
+		host_sha256_block(ctx->state, ctx->buffer);
+		input += fill;
+		ilen -= fill;
+		left = 0;
+	}
+	while(ilen >= 64)
+	{
+		host_sha256_block(ctx->state, input);
+		input += 64;
+		ilen -= 64;
+	}
+	if(ilen)
+	{
+		memcpy(ctx->buffer + left, input, ilen);
+	}
+	return 0;
+}
+
+int mbedtls_sha256_finish_ret(mbedtls_sha256_context *ctx, unsigned char output[32])
+{
+	static const unsigned char padding[64] = { 0x80 };
+	uint32_t high = (ctx->total[0] >> 29) | (ctx->total[1] << 3);
+	uint32_t low = ctx->total[0] << 3;
+	size_t last = ctx->total[0] & 63;
+	unsigned char length[8];
+	int i;
+
+	for(i = 0; i < 4; i++)
+	{
+		length[i] = (unsigned char)(high >> (24 - 8 * i));
+		length[4 + i] = (unsigned char)(low >> (24 - 8 * i));
+	}
+	mbedtls_sha256_update_ret(ctx, padding, last < 56 ? 56 - last : 120 - last);
+	mbedtls_sha256_update_ret(ctx, length, sizeof(length));
+	for(i = 0; i < 8; i++)
+	{
+		output[4 * i] = (unsigned char)(ctx->state[i] >> 24);
+		output[4 * i + 1] = (unsigned char)(ctx->state[i] >> 16);
+		output[4 * i + 2] = (unsigned char)(ctx->state[i] >> 8);
+		output[4 * i + 3] = (unsigned char)(ctx->state[i]);
+	}
+	return 0;
+}
+
+int mbedtls_sha256_ret(const unsigned char *input, size_t ilen, unsigned char output[32], int is224)
+{
+	mbedtls_sha256_context ctx;
+
+	mbedtls_sha256_init(&ctx);
+	mbedtls_sha256_starts_ret(&ctx, is224);
+	mbedtls_sha256_update_ret(&ctx, input, ilen);
+	mbedtls_sha256_finish_ret(&ctx, output);
+	mbedtls_sha256_free(&ctx);
+	return 0;
+}
+
+/*
+ * EOF
+ */
@@ -0,0 +1,142 @@
+/*****************************************************************************
+* File Name: host_test.h
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_partition.h"
+#include "esp_http_client.h"
+
+#include "esp_ota_hash.h"
+#include "esp_ota_desc.h"
+
+#include "esp_ota_host.h"
+
+/*******************************************************************************
+* User defined Macros
+*******************************************************************************/
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+/* the test fails and exits at the first check that doesn't hold */
+#define HOST_TEST_CHECK(cond)	\
+	do	\
+	{	\
+		if(!(cond))	\
+		{	\
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);	\
+			exit(1);	\
+		}	\
+	}while(0)
+
+#define HOST_TEST_CHECK_ERR(err, expected)	\
+	do	\
+	{	\
+		esp_err_t host_test_err = (err);	\
+		if(host_test_err != (expected))	\
+		{	\
+			fprintf(stderr, "%s:%d: %s: 0x%x, expected 0x%x\n",	\
+				__FILE__, __LINE__, #err, host_test_err, (expected));	\
+			exit(1);	\
+		}	\
+	}while(0)
+
+#define HOST_TEST_CERT_PEM	"host"
+
+/* an app image (0xE9 header) of pseudo random bytes */
+static inline uint8_t *host_test_image(uint32_t size, uint32_t seed)
+{
+	uint8_t *image = (uint8_t *)malloc(size);
+	uint32_t x = seed | 1, i;
+
+	HOST_TEST_CHECK(image);
+	for(i = 0; i < size; i++)
+	{
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		image[i] = (uint8_t)x;
+	}
+	image[0] = 0xE9;
+	return image;
+}
+
+/* descriptor of a plain image */
+static inline void host_test_desc(esp_ota_desc_t *desc, const uint8_t *image, uint32_t size)
+{
+	memset(desc, 0, sizeof(esp_ota_desc_t));
+	desc->version.major = 1;
+	desc->size = size;
+	esp_ota_hash_sha256(NULL, image, size, desc->sha256);
+}
+
+static inline void host_test_config(esp_http_client_config_t *config, const char *url)
+{
+	memset(config, 0, sizeof(esp_http_client_config_t));
+	config->url = url;
+	config->cert_pem = HOST_TEST_CERT_PEM;
+}
+
+/* a fresh RAM flash and NVS */
+static inline void host_test_reset(void)
+{
+	HOST_TEST_CHECK(host_flash_init(NULL) == ESP_OK);
+	host_nvs_reset();
+	host_http_client_reset_stats();
+}
+
+#endif
@@ -0,0 +1,200 @@
+/*****************************************************************************
+* File Name: test_manifest.c
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_partition.h"
+#include "esp_ota_ops.h"
+#include "esp_http_client.h"
+
+#include "esp_ota_hash.h"
+#include "esp_ota_desc.h"
+#include "esp_ota_http.h"
+
+#include "esp_ota_host.h"
+#include "host_test.h"
+
+/*
+ * A manifest of tools/esp_ota_manifest.py --blocks with an app and a data
+ * component: a corrupted block of either is fetched again, the app from
+ * the running partition or the server, the data partition from the server.
+ * When the data partition fails, a new call finds the app in the passive
+ * slot, fetches only the data partition and then switches the boot
+ * partition.
+ *
+ *	test_manifest PYTHON tools/esp_ota_manifest.py
+ */
+
+#define TEST_APP_SIZE		(48 * 1024)
+#define TEST_DATA_SIZE		(40000)
+
+#define TEST_APP_FILE		"test_manifest_app.bin"
+#define TEST_DATA_FILE		"test_manifest_data.bin"
+#define TEST_MANIFEST_FILE	"test_manifest.json"
+
+static void test_save(const char *path, const void *data, uint32_t size)
+{
+	FILE *f = fopen(path, "wb");
+
+	HOST_TEST_CHECK(f);
+	HOST_TEST_CHECK(fwrite(data, 1, size, f) == size);
+	fclose(f);
+}
+
+static char *test_load(const char *path, uint32_t *size)
+{
+	char *data;
+	FILE *f;
+	long length;
+
+	f = fopen(path, "rb");
+	HOST_TEST_CHECK(f);
+	HOST_TEST_CHECK(!fseek(f, 0, SEEK_END) && (length = ftell(f)) > 0 && !fseek(f, 0, SEEK_SET));
+	data = (char *)malloc(length + 1);
+	HOST_TEST_CHECK(data && fread(data, 1, length, f) == (size_t)length);
+	fclose(f);
+	data[length] = 0;
+	*size = length;
+	return data;
+}
+
+static esp_err_t test_upgrade(host_server_handle_t server, esp_ota_http_component_result_t *results)
+{
+	esp_http_client_config_t config;
+	char url[64];
+
+	host_server_url(server, "/release/" TEST_MANIFEST_FILE, url, sizeof(url));
+	host_test_config(&config, url);
+	memset(results, 0, ESP_OTA_DESC_MANIFEST_COMPONENTS * sizeof(esp_ota_http_component_result_t));
+	return esp_ota_http_upgrade_manifest(&config, NULL, results);
+}
+
+int main(int argc, char **argv)
+{
+	esp_ota_http_component_result_t results[ESP_OTA_DESC_MANIFEST_COMPONENTS];
+	const esp_partition_t *data_partition;
+	host_server_handle_t server;
+	uint8_t *app, *data;
+	char *manifest;
+	uint32_t manifest_size;
+	char command[512];
+
+	if(argc != 3)
+	{
+		fprintf(stderr, "usage: %s PYTHON esp_ota_manifest.py\n", argv[0]);
+		return 2;
+	}
+
+	app = host_test_image(TEST_APP_SIZE, 7);
+	data = host_test_image(TEST_DATA_SIZE, 8);
+	test_save(TEST_APP_FILE, app, TEST_APP_SIZE);
+	test_save(TEST_DATA_FILE, data, TEST_DATA_SIZE);
+	snprintf(command, sizeof(command), "\"%s\" \"%s\" --version 2 --blocks app=:%s:1.2 www=spiffs:%s:0.3 > %s",
+		argv[1], argv[2], TEST_APP_FILE, TEST_DATA_FILE, TEST_MANIFEST_FILE);
+	HOST_TEST_CHECK(system(command) == 0);
+	manifest = test_load(TEST_MANIFEST_FILE, &manifest_size);
+
+	host_test_reset();
+	data_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "spiffs");
+	HOST_TEST_CHECK(data_partition);
+	HOST_TEST_CHECK(host_server_start(NULL, &server) == ESP_OK);
+	host_server_add(server, "/release/" TEST_MANIFEST_FILE, manifest, manifest_size, "application/json", NULL);
+	host_server_add(server, "/release/" TEST_APP_FILE, app, TEST_APP_SIZE, NULL, NULL);
+	host_server_add(server, "/release/" TEST_DATA_FILE, data, TEST_DATA_SIZE, NULL, NULL);
+
+	/* one block of each image arrives corrupted once */
+	host_server_corrupt(server, "/release/" TEST_APP_FILE, 20000, 1);
+	host_server_corrupt(server, "/release/" TEST_DATA_FILE, 5000, 1);
+	HOST_TEST_CHECK_ERR(test_upgrade(server, results), ESP_OK);
+	printf("app: %u bytes read, data: %u bytes read\n", results[0].read_bytes, results[1].read_bytes);
+
+	HOST_TEST_CHECK_ERR(results[0].err, ESP_OK);
+	HOST_TEST_CHECK_ERR(results[1].err, ESP_OK);
+	HOST_TEST_CHECK(results[0].read_bytes > TEST_APP_SIZE && results[1].read_bytes > TEST_DATA_SIZE);
+	HOST_TEST_CHECK(!memcmp(host_flash_data(esp_ota_get_next_update_partition(NULL)), app, TEST_APP_SIZE));
+	HOST_TEST_CHECK(!memcmp(host_flash_data(data_partition), data, TEST_DATA_SIZE));
+	HOST_TEST_CHECK(host_ota_get_boot() == esp_ota_get_next_update_partition(NULL));
+
+	/* the data partition holds its image now */
+	HOST_TEST_CHECK_ERR(test_upgrade(server, results), ESP_OK);
+	HOST_TEST_CHECK(results[1].current && !results[1].read_bytes);
+
+	/* a data block never arrives intact, the app is written but not activated */
+	host_test_reset();
+	host_server_corrupt(server, "/release/" TEST_DATA_FILE, 5000, 100);
+	HOST_TEST_CHECK_ERR(test_upgrade(server, results), ESP_ERR_INVALID_CRC);
+	HOST_TEST_CHECK(!results[0].current && results[0].err == ESP_OK);
+	HOST_TEST_CHECK(host_ota_get_boot() == NULL);
+
+	host_server_corrupt(server, "/release/" TEST_DATA_FILE, 5000, 0);
+	HOST_TEST_CHECK_ERR(test_upgrade(server, results), ESP_OK);
+	printf("retry: app %s, data: %u bytes read\n", results[0].current ? "current" : "written", results[1].read_bytes);
+	HOST_TEST_CHECK(results[0].current && !results[0].read_bytes);
+	HOST_TEST_CHECK(!results[1].current && results[1].read_bytes >= TEST_DATA_SIZE);
+	HOST_TEST_CHECK(!memcmp(host_flash_data(data_partition), data, TEST_DATA_SIZE));
+	HOST_TEST_CHECK(host_ota_get_boot() == esp_ota_get_next_update_partition(NULL));
+
+	host_server_stop(server);
+	free(manifest);
+	free(data);
+	free(app);
+	return 0;
+}
+
+/*
+ * EOF
+ */
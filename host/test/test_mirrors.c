@@ -0,0 +1,194 @@
+/*****************************************************************************
+* File Name: test_mirrors.c
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_partition.h"
+#include "esp_ota_ops.h"
+#include "esp_timer.h"
+#include "esp_http_client.h"
+
+#include "esp_ota_hash.h"
+#include "esp_ota_desc.h"
+#include "esp_ota_http.h"
+
+#include "esp_ota_host.h"
+#include "host_test.h"
+
+/*
+ * esp_ota_http_upgrade_mirrors() against local servers of different link
+ * speeds and failure rates.
+ */
+
+#define TEST_IMAGE_SIZE		(256 * 1024)	/* 8 ranges of 32K */
+#define TEST_MIRRORS_MAX	(3)
+
+typedef struct
+{
+	const char *name;
+	host_server_config_t config;
+}test_mirror_t;
+
+static void test_callback(const esp_ota_http_progress_t *progress, void *arg)
+{
+	memcpy(arg, progress, sizeof(esp_ota_http_progress_t));
+}
+
+static esp_err_t test_mirrors
+	(
+		const test_mirror_t *mirrors,
+		unsigned int count,
+		const uint8_t *image,
+		uint32_t *ms,
+		host_server_stats_t *stats
+	)
+{
+	host_server_handle_t servers[TEST_MIRRORS_MAX];
+	esp_http_client_config_t configs[TEST_MIRRORS_MAX];
+	char urls[TEST_MIRRORS_MAX][64];
+	esp_ota_http_upgrade_config_t upgrade_config;
+	esp_ota_http_progress_t progress;
+	esp_ota_desc_t desc;
+	int64_t t;
+	unsigned int i;
+	esp_err_t err;
+
+	host_test_reset();
+	for(i = 0; i < count; i++)
+	{
+		HOST_TEST_CHECK(host_server_start(&mirrors[i].config, &servers[i]) == ESP_OK);
+		host_server_add(servers[i], "/image.bin", image, TEST_IMAGE_SIZE, NULL, NULL);
+		host_server_url(servers[i], "/image.bin", urls[i], sizeof(urls[i]));
+		host_test_config(&configs[i], urls[i]);
+	}
+	host_test_desc(&desc, image, TEST_IMAGE_SIZE);
+	memset(&upgrade_config, 0, sizeof(upgrade_config));
+	upgrade_config.callback = test_callback;
+	upgrade_config.callback_arg = &progress;
+	memset(&progress, 0, sizeof(progress));
+
+	t = esp_timer_get_time();
+	err = esp_ota_http_upgrade_mirrors(configs, count, &desc, &upgrade_config);
+	*ms = (uint32_t)((esp_timer_get_time() - t) / 1000);
+
+	printf("%u ms, error 0x%x\n", *ms, err);
+	for(i = 0; i < count; i++)
+	{
+		host_server_get_stats(servers[i], &stats[i]);
+		printf("  %-8s %u requests, %u cut, %u bytes\n",
+			mirrors[i].name, stats[i].range_requests, stats[i].failed, (uint32_t)stats[i].bytes);
+		host_server_stop(servers[i]);
+	}
+	HOST_TEST_CHECK(progress.done && progress.err == err);
+	if(err == ESP_OK)
+	{
+		HOST_TEST_CHECK(progress.length == TEST_IMAGE_SIZE);
+		HOST_TEST_CHECK(!memcmp(host_flash_data(esp_ota_get_next_update_partition(NULL)), image, TEST_IMAGE_SIZE));
+		HOST_TEST_CHECK(host_ota_get_boot() == esp_ota_get_next_update_partition(NULL));
+	}
+	else
+	{
+		HOST_TEST_CHECK(host_ota_get_boot() == NULL);
+	}
+	return err;
+}
+
+int main(void)
+{
+	/* a 32K range takes 2 s on the slow mirror */
+	static const test_mirror_t shaped[] =
+	{
+		{ "fast", { 0 } },
+		{ "1MB/s", { 1024 * 1024 } },
+		{ "16KB/s", { 16 * 1024 } },
+	};
+	static const test_mirror_t failing[] =
+	{
+		{ "cut", { 0, 0, 1 } },
+		{ "256KB/s", { 256 * 1024 } },
+	};
+	static const test_mirror_t broken[] =
+	{
+		{ "cut", { 0, 0, 1 } },
+		{ "cut", { 0, 0, 1 } },
+	};
+	host_server_stats_t stats[TEST_MIRRORS_MAX];
+	uint8_t *image;
+	uint32_t ms;
+
+	image = host_test_image(TEST_IMAGE_SIZE, 5);
+
+	/* end-game: the slow mirror's range is finished by a fast one */
+	printf("shaped: ");
+	HOST_TEST_CHECK_ERR(test_mirrors(shaped, 3, image, &ms, stats), ESP_OK);
+	HOST_TEST_CHECK(ms < 1500);
+	HOST_TEST_CHECK(stats[2].bytes < 32 * 1024);
+
+	/* every range of the cut mirror is fetched again from the other one */
+	printf("failing: ");
+	HOST_TEST_CHECK_ERR(test_mirrors(failing, 2, image, &ms, stats), ESP_OK);
+	HOST_TEST_CHECK(stats[0].failed > 0);
+
+	printf("broken: ");
+	HOST_TEST_CHECK(test_mirrors(broken, 2, image, &ms, stats) != ESP_OK);
+
+	free(image);
+	return 0;
+}
+
+/*
+ * EOF
+ */
@@ -0,0 +1,250 @@
+/*****************************************************************************
+* File Name: test_patch.c
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_partition.h"
+#include "esp_ota_ops.h"
+#include "esp_spi_flash.h"
+#include "esp_http_client.h"
+
+#include "esp_ota_hash.h"
+#include "esp_ota_desc.h"
+#include "esp_ota_patch.h"
+#include "esp_ota_http.h"
+
+#include "esp_ota_host.h"
+#include "host_test.h"
+
+/*
+ * Round trip of a delta: tools/esp_ota_patch.py diffs two images, the
+ * patch is applied by esp_ota_patch_write() and by a delta upgrade over a
+ * file backed flash, the result must be the new image.
+ *
+ *	test_patch PYTHON tools/esp_ota_patch.py
+ */
+
+#define TEST_BASE_SIZE		(200000)
+#define TEST_INSERT_SIZE	(3000)
+#define TEST_EDIT_SIZE		(1000)
+#define TEST_NEW_SIZE		(TEST_BASE_SIZE + TEST_INSERT_SIZE)
+
+#define TEST_FLASH_FILE		"test_patch.flash"
+#define TEST_BASE_FILE		"test_patch_base.bin"
+#define TEST_NEW_FILE		"test_patch_new.bin"
+#define TEST_PATCH_FILE		"test_patch.bin"
+#define TEST_DESC_FILE		"test_patch.json"
+
+static void test_save(const char *path, const void *data, uint32_t size)
+{
+	FILE *f = fopen(path, "wb");
+
+	HOST_TEST_CHECK(f);
+	HOST_TEST_CHECK(fwrite(data, 1, size, f) == size);
+	fclose(f);
+}
+
+static uint8_t *test_load(const char *path, uint32_t *size)
+{
+	uint8_t *data;
+	FILE *f;
+	long length;
+
+	f = fopen(path, "rb");
+	HOST_TEST_CHECK(f);
+	HOST_TEST_CHECK(!fseek(f, 0, SEEK_END) && (length = ftell(f)) > 0 && !fseek(f, 0, SEEK_SET));
+	data = (uint8_t *)malloc(length + 1);
+	HOST_TEST_CHECK(data && fread(data, 1, length, f) == (size_t)length);
+	fclose(f);
+	data[length] = 0;
+	*size = length;
+	return data;
+}
+
+/* an edit, an insertion and a moved range of the base */
+static uint8_t *test_new_image(const uint8_t *base)
+{
+	uint8_t *image = (uint8_t *)malloc(TEST_NEW_SIZE);
+	uint8_t *insert = host_test_image(TEST_INSERT_SIZE, 4);
+	uint32_t i;
+
+	HOST_TEST_CHECK(image);
+	memcpy(image, base, 100000);
+	for(i = 60000; i < 60000 + TEST_EDIT_SIZE; i++)
+	{
+		image[i] ^= 0x5a;
+	}
+	memcpy(&image[100000], insert, TEST_INSERT_SIZE);
+	memcpy(&image[100000 + TEST_INSERT_SIZE], &base[130000], TEST_BASE_SIZE - 130000);
+	memcpy(&image[TEST_NEW_SIZE - 30000], &base[100000], 30000);
+	free(insert);
+	return image;
+}
+
+static esp_err_t test_output(void *arg, const uint8_t *data, unsigned int length)
+{
+	uint32_t *offset = (uint32_t *)arg;
+	esp_err_t err;
+
+	err = esp_partition_write(esp_ota_get_next_update_partition(NULL), *offset, data, length);
+	*offset += length;
+	return err;
+}
+
+/* esp_ota_patch_write() of the patch in pieces of chunk bytes */
+static void test_apply(const esp_ota_desc_t *desc, const uint8_t *patch, uint32_t patch_size, const uint8_t *image, unsigned int chunk)
+{
+	const esp_partition_t *partition = esp_ota_get_next_update_partition(NULL);
+	esp_ota_patch_t state;
+	uint32_t offset = 0, i, n;
+
+	HOST_TEST_CHECK_ERR(esp_partition_erase_range(partition, 0, partition->size), ESP_OK);
+	HOST_TEST_CHECK_ERR(esp_ota_patch_init(&state, esp_ota_get_running_partition(), desc->base_size, test_output, &offset), ESP_OK);
+	HOST_TEST_CHECK_ERR(esp_ota_patch_check_base(&state, desc->base_sha256), ESP_OK);
+	for(i = 0; i < patch_size; i += n)
+	{
+		n = patch_size - i < chunk ? patch_size - i : chunk;
+		HOST_TEST_CHECK_ERR(esp_ota_patch_write(&state, &patch[i], n), ESP_OK);
+	}
+	HOST_TEST_CHECK_ERR(esp_ota_patch_finish(&state), ESP_OK);
+	printf("esp_ota_patch_write: %u byte pieces, %u bytes out\n", chunk, offset);
+	HOST_TEST_CHECK(offset == TEST_NEW_SIZE);
+	HOST_TEST_CHECK(!memcmp(host_flash_data(partition), image, TEST_NEW_SIZE));
+}
+
+/* the delta through esp_ota_http_upgrade_ext() */
+static esp_err_t test_upgrade(const esp_ota_desc_t *desc, const uint8_t *patch, uint32_t patch_size)
+{
+	esp_http_client_config_t config;
+	host_server_handle_t server;
+	char url[64];
+	esp_err_t err;
+
+	HOST_TEST_CHECK(host_server_start(NULL, &server) == ESP_OK);
+	host_server_add(server, "/image.patch", patch, patch_size, NULL, NULL);
+	host_server_url(server, "/image.patch", url, sizeof(url));
+	host_test_config(&config, url);
+	err = esp_ota_http_upgrade_ext(&config, desc, NULL);
+	host_server_stop(server);
+	return err;
+}
+
+int main(int argc, char **argv)
+{
+	static const unsigned int chunks[] = { 1, 7, 256, 4096, TEST_NEW_SIZE };
+	const esp_partition_t *running;
+	esp_ota_desc_t desc;
+	uint8_t *base, *image, *patch, *json;
+	uint32_t patch_size, json_size;
+	char command[512];
+	unsigned int i;
+
+	if(argc != 3)
+	{
+		fprintf(stderr, "usage: %s PYTHON esp_ota_patch.py\n", argv[0]);
+		return 2;
+	}
+
+	base = host_test_image(TEST_BASE_SIZE, 3);
+	image = test_new_image(base);
+	test_save(TEST_BASE_FILE, base, TEST_BASE_SIZE);
+	test_save(TEST_NEW_FILE, image, TEST_NEW_SIZE);
+	snprintf(command, sizeof(command), "\"%s\" \"%s\" diff %s %s %s --version 1.1 --base-version 1.0 > %s",
+		argv[1], argv[2], TEST_BASE_FILE, TEST_NEW_FILE, TEST_PATCH_FILE, TEST_DESC_FILE);
+	HOST_TEST_CHECK(system(command) == 0);
+	patch = test_load(TEST_PATCH_FILE, &patch_size);
+	json = test_load(TEST_DESC_FILE, &json_size);
+	printf("patch: %u bytes for a %u byte image\n", patch_size, TEST_NEW_SIZE);
+	/* literal data is the insertion and the edit */
+	HOST_TEST_CHECK(patch_size < TEST_INSERT_SIZE + TEST_EDIT_SIZE + 256);
+
+	memset(&desc, 0, sizeof(desc));
+	HOST_TEST_CHECK(esp_ota_desc_parse_json((const char *)json, json_size, &desc) == 0);
+	HOST_TEST_CHECK(desc.size == TEST_NEW_SIZE && desc.base_size == TEST_BASE_SIZE && desc.zsize == patch_size);
+
+	remove(TEST_FLASH_FILE);
+	HOST_TEST_CHECK_ERR(host_flash_init(TEST_FLASH_FILE), ESP_OK);
+	host_nvs_reset();
+	running = esp_ota_get_running_partition();
+	memcpy(host_flash_data(running), base, TEST_BASE_SIZE);
+
+	for(i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++)
+	{
+		test_apply(&desc, patch, patch_size, image, chunks[i]);
+	}
+
+	HOST_TEST_CHECK_ERR(test_upgrade(&desc, patch, patch_size), ESP_OK);
+	HOST_TEST_CHECK(!memcmp(host_flash_data(esp_ota_get_next_update_partition(NULL)), image, TEST_NEW_SIZE));
+	HOST_TEST_CHECK(host_ota_get_boot() == esp_ota_get_next_update_partition(NULL));
+
+	/* another base: the patch doesn't apply */
+	host_flash_data(running)[1000] ^= 1;
+	HOST_TEST_CHECK_ERR(test_upgrade(&desc, patch, patch_size), ESP_ERR_INVALID_VERSION);
+
+	host_flash_deinit();
+	remove(TEST_FLASH_FILE);
+	esp_ota_desc_free(&desc);
+	free(json);
+	free(patch);
+	free(image);
+	free(base);
+	return 0;
+}
+
+/*
+ * EOF
+ */
@@ -0,0 +1,260 @@
+/*****************************************************************************
+* File Name: test_pipeline.c
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_partition.h"
+#include "esp_ota_ops.h"
+#include "esp_spi_flash.h"
+#include "esp_http_client.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "esp_ota_port.h"
+#include "esp_ota_ring.h"
+#include "esp_ota_hash.h"
+#include "esp_ota_desc.h"
+#include "esp_ota_http.h"
+
+#include "esp_ota_host.h"
+#include "host_test.h"
+
+/*
+ * Pipelined download: the writer stops a reader blocked on a full ring,
+ * and the back-pressure counters name the slow side.
+ */
+
+#define TEST_IMAGE_SIZE		(128 * 1024)
+#define TEST_DEPTH			(4)
+#define TEST_BUFFER_SIZE	(1024)
+
+typedef struct
+{
+	esp_ota_ring_t ring;
+	SemaphoreHandle_t done;
+	unsigned int published;
+}test_producer_t;
+
+static void test_producer_task(void *arg)
+{
+	test_producer_t *producer = (test_producer_t *)arg;
+	uint8_t *buffer;
+
+	while(NULL != (buffer = esp_ota_ring_acquire(&producer->ring)))
+	{
+		memset(buffer, (int)producer->published, producer->ring.size);
+		esp_ota_ring_publish(&producer->ring, producer->ring.size);
+		producer->published++;
+	}
+	xSemaphoreGive(producer->done);
+	vTaskDelete(NULL);
+}
+
+/* the producer fills the ring and blocks, esp_ota_ring_abort() releases it */
+static void test_ring_abort(void)
+{
+	test_producer_t producer;
+	unsigned int length, i;
+
+	memset(&producer, 0, sizeof(producer));
+	HOST_TEST_CHECK_ERR(esp_ota_ring_init(&producer.ring, TEST_DEPTH, 16), ESP_OK);
+	producer.done = xSemaphoreCreateBinary();
+	HOST_TEST_CHECK(producer.done);
+	HOST_TEST_CHECK(pdPASS == xTaskCreate(test_producer_task, "producer", 2048, &producer, 5, NULL));
+
+	for(i = 0; i < 100 && !producer.ring.producer_stalls; i++)
+	{
+		vTaskDelay(1);
+	}
+	HOST_TEST_CHECK(producer.ring.producer_stalls == 1);
+	HOST_TEST_CHECK(producer.published == TEST_DEPTH);
+	HOST_TEST_CHECK(pdFALSE == xSemaphoreTake(producer.done, 0));
+
+	/* the writer fails on the first buffer */
+	esp_ota_ring_peek(&producer.ring, &length);
+	HOST_TEST_CHECK(length == 16);
+	esp_ota_ring_release(&producer.ring);
+	esp_ota_ring_abort(&producer.ring);
+
+	HOST_TEST_CHECK(pdTRUE == xSemaphoreTake(producer.done, pdMS_TO_TICKS(1000)));
+	HOST_TEST_CHECK(producer.published <= TEST_DEPTH + 1);
+	printf("ring: producer stopped after %u buffers, %u stall\n",
+		producer.published, producer.ring.producer_stalls);
+
+	vSemaphoreDelete(producer.done);
+	esp_ota_ring_deinit(&producer.ring);
+}
+
+static void test_callback(const esp_ota_http_progress_t *progress, void *arg)
+{
+	memcpy(arg, progress, sizeof(esp_ota_http_progress_t));
+}
+
+static esp_err_t test_upgrade
+	(
+		host_server_handle_t server,
+		const uint8_t *image,
+		esp_ota_http_progress_t *progress
+	)
+{
+	esp_http_client_config_t config;
+	esp_ota_http_upgrade_config_t upgrade_config;
+	esp_ota_desc_t desc;
+	char url[64];
+
+	host_server_url(server, "/image.bin", url, sizeof(url));
+	host_test_config(&config, url);
+	host_test_desc(&desc, image, TEST_IMAGE_SIZE);
+	memset(&upgrade_config, 0, sizeof(upgrade_config));
+	upgrade_config.pipeline_depth = TEST_DEPTH;
+	upgrade_config.pipeline_buffer_size = TEST_BUFFER_SIZE;
+	upgrade_config.callback = test_callback;
+	upgrade_config.callback_arg = progress;
+	memset(progress, 0, sizeof(esp_ota_http_progress_t));
+	return esp_ota_http_upgrade_ext(&config, &desc, &upgrade_config);
+}
+
+/* slow flash, fast link: the reader waits on a full ring when the write fails */
+static void test_writer_abort(host_server_handle_t server, const uint8_t *image)
+{
+	static const host_flash_timing_t timing = { 0, 700, 20, true };
+	esp_ota_http_progress_t progress;
+	esp_ota_port_alloc_stats_t alloc;
+	host_flash_stats_t stats;
+
+	host_test_reset();
+	host_flash_set_timing(&timing);
+	host_flash_fail_write(8, ESP_ERR_FLASH_OP_FAIL);
+
+	HOST_TEST_CHECK_ERR(test_upgrade(server, image, &progress), ESP_ERR_FLASH_OP_FAIL);
+	host_flash_get_stats(&stats);
+	printf("writer abort: %u writes, reader stalls %u (%u us), writer stalls %u (%u us)\n",
+		stats.write_count, progress.reader_stalls, progress.reader_wait_us,
+		progress.writer_stalls, progress.writer_wait_us);
+
+	HOST_TEST_CHECK(stats.write_count == 7);
+	HOST_TEST_CHECK(progress.done && progress.err == ESP_ERR_FLASH_OP_FAIL);
+	HOST_TEST_CHECK(progress.reader_stalls > 0);
+	HOST_TEST_CHECK(host_ota_get_boot() == NULL);
+
+	/* the reader task is gone with the ring */
+	esp_ota_port_get_alloc_stats(&alloc);
+	HOST_TEST_CHECK(alloc.current == 0);
+
+	host_flash_fail_write(0, ESP_OK);
+	HOST_TEST_CHECK_ERR(test_upgrade(server, image, &progress), ESP_OK);
+	HOST_TEST_CHECK(!memcmp(host_flash_data(esp_ota_get_next_update_partition(NULL)), image, TEST_IMAGE_SIZE));
+}
+
+/* the side that waits longer on the ring is the faster one */
+static void test_back_pressure(const uint8_t *image)
+{
+	static const host_flash_timing_t timing = { 0, 700, 20, true };
+	host_server_config_t server_config;
+	host_server_handle_t server;
+	esp_ota_http_progress_t progress;
+
+	/* flash bound */
+	host_test_reset();
+	host_flash_set_timing(&timing);
+	HOST_TEST_CHECK(host_server_start(NULL, &server) == ESP_OK);
+	host_server_add(server, "/image.bin", image, TEST_IMAGE_SIZE, NULL, NULL);
+	HOST_TEST_CHECK_ERR(test_upgrade(server, image, &progress), ESP_OK);
+	host_server_stop(server);
+	printf("flash bound: reader stalls %u (%u us), writer stalls %u (%u us)\n",
+		progress.reader_stalls, progress.reader_wait_us,
+		progress.writer_stalls, progress.writer_wait_us);
+	HOST_TEST_CHECK(progress.reader_stalls > 0);
+	HOST_TEST_CHECK(progress.reader_wait_us > progress.writer_wait_us);
+
+	/* network bound */
+	host_test_reset();
+	memset(&server_config, 0, sizeof(server_config));
+	server_config.rate = 512 * 1024;
+	HOST_TEST_CHECK(host_server_start(&server_config, &server) == ESP_OK);
+	host_server_add(server, "/image.bin", image, TEST_IMAGE_SIZE, NULL, NULL);
+	HOST_TEST_CHECK_ERR(test_upgrade(server, image, &progress), ESP_OK);
+	host_server_stop(server);
+	printf("network bound: reader stalls %u (%u us), writer stalls %u (%u us)\n",
+		progress.reader_stalls, progress.reader_wait_us,
+		progress.writer_stalls, progress.writer_wait_us);
+	HOST_TEST_CHECK(progress.writer_stalls > 0);
+	HOST_TEST_CHECK(progress.writer_wait_us > progress.reader_wait_us);
+}
+
+int main(void)
+{
+	host_server_handle_t server;
+	uint8_t *image;
+
+	test_ring_abort();
+
+	image = host_test_image(TEST_IMAGE_SIZE, 2);
+	HOST_TEST_CHECK(host_server_start(NULL, &server) == ESP_OK);
+	host_server_add(server, "/image.bin", image, TEST_IMAGE_SIZE, NULL, NULL);
+	test_writer_abort(server, image);
+	host_server_stop(server);
+
+	test_back_pressure(image);
+	free(image);
+	return 0;
+}
+
+/*
+ * EOF
+ */
@@ -0,0 +1,267 @@
+/*****************************************************************************
+* File Name: test_resume.c
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_partition.h"
+#include "esp_ota_ops.h"
+#include "esp_http_client.h"
+#include "esp_spi_flash.h"
+
+#include "esp_ota_hash.h"
+#include "esp_ota_desc.h"
+#include "esp_ota_nvs.h"
+#include "esp_ota_http.h"
+
+#include "esp_ota_host.h"
+#include "host_test.h"
+
+/*
+ * Resume mode: an upgrade cut by a flash failure continues from its NVS
+ * checkpoint with a Range request, or from the start when the server
+ * ignores the range. A checkpoint at the end of the image (power lost
+ * before the boot partition is switched) starts the image over instead of
+ * asking for an empty range.
+ */
+
+#define TEST_IMAGE_SIZE			(256 * 1024)
+#define TEST_END_IMAGE_SIZE		(64 * 1024)	/* sector aligned */
+#define TEST_FAIL_WRITE			(20)
+
+typedef struct
+{
+	uint32_t size;
+	bool saved;
+	esp_ota_nvs_checkpoint_t checkpoint;
+}test_end_t;
+
+/* the checkpoint as it is right after the last block is written */
+static void test_end_callback(const esp_ota_http_progress_t *progress, void *arg)
+{
+	test_end_t *end = (test_end_t *)arg;
+
+	if(!progress->done && progress->length == end->size && !end->saved)
+	{
+		end->saved = (ESP_OK == esp_ota_nvs_checkpoint_get(&end->checkpoint));
+	}
+}
+
+static void test_setup
+	(
+		host_server_handle_t server,
+		const char *path,
+		esp_http_client_config_t *config,
+		char *url,
+		esp_ota_http_upgrade_config_t *upgrade_config
+	)
+{
+	host_server_url(server, path, url, 64);
+	host_test_config(config, url);
+	memset(upgrade_config, 0, sizeof(esp_ota_http_upgrade_config_t));
+	upgrade_config->checkpoint_sectors = 1;
+}
+
+/* cut the upgrade at a flash write, a checkpoint inside the image is left */
+static uint32_t test_interrupt(host_server_handle_t server, const uint8_t *image)
+{
+	esp_http_client_config_t config;
+	esp_ota_http_upgrade_config_t upgrade_config;
+	esp_ota_nvs_checkpoint_t checkpoint;
+	esp_ota_desc_t desc;
+	char url[64];
+
+	host_test_reset();
+	test_setup(server, "/image.bin", &config, url, &upgrade_config);
+	host_test_desc(&desc, image, TEST_IMAGE_SIZE);
+
+	host_flash_fail_write(TEST_FAIL_WRITE, ESP_ERR_FLASH_OP_FAIL);
+	HOST_TEST_CHECK(esp_ota_http_upgrade_ext(&config, &desc, &upgrade_config) != ESP_OK);
+	host_flash_fail_write(0, ESP_OK);
+
+	HOST_TEST_CHECK_ERR(esp_ota_nvs_checkpoint_get(&checkpoint), ESP_OK);
+	HOST_TEST_CHECK(checkpoint.offset > 0 && checkpoint.offset < TEST_IMAGE_SIZE);
+	HOST_TEST_CHECK(host_ota_get_boot() == NULL);
+	return checkpoint.offset;
+}
+
+static void test_resume(host_server_handle_t server, const uint8_t *image, bool ranges)
+{
+	esp_http_client_config_t config;
+	esp_ota_http_upgrade_config_t upgrade_config;
+	esp_ota_nvs_checkpoint_t checkpoint;
+	host_server_stats_t before, after;
+	esp_ota_desc_t desc;
+	uint32_t offset;
+	char url[64];
+
+	offset = test_interrupt(server, image);
+	test_setup(server, "/image.bin", &config, url, &upgrade_config);
+	host_test_desc(&desc, image, TEST_IMAGE_SIZE);
+
+	host_server_get_stats(server, &before);
+	HOST_TEST_CHECK_ERR(esp_ota_http_upgrade_ext(&config, &desc, &upgrade_config), ESP_OK);
+	host_server_get_stats(server, &after);
+	printf("resume at %u(bytes), %s: %u requests, %u bytes\n", offset, ranges ? "ranges" : "no ranges",
+		after.requests - before.requests, (uint32_t)(after.bytes - before.bytes));
+
+	HOST_TEST_CHECK(after.range_requests - before.range_requests == (ranges ? 1 : 0));
+	if(ranges)
+	{
+		/* only the rest of the image is fetched */
+		HOST_TEST_CHECK(after.requests - before.requests == 1);
+		HOST_TEST_CHECK(after.bytes - before.bytes == TEST_IMAGE_SIZE - offset);
+	}
+	else
+	{
+		/* the ignored range is not reused, the image is requested again */
+		HOST_TEST_CHECK(after.requests - before.requests == 2);
+	}
+	HOST_TEST_CHECK(!memcmp(host_flash_data(esp_ota_get_next_update_partition(NULL)), image, TEST_IMAGE_SIZE));
+	HOST_TEST_CHECK(host_ota_get_boot() == esp_ota_get_next_update_partition(NULL));
+	HOST_TEST_CHECK(esp_ota_nvs_checkpoint_get(&checkpoint) != ESP_OK);
+}
+
+static esp_err_t test_step
+	(
+		const esp_http_client_config_t *config,
+		const esp_ota_desc_t *desc,
+		const esp_ota_http_upgrade_config_t *upgrade_config
+	)
+{
+	esp_ota_http_upgrade_handle_t handle;
+	esp_err_t err;
+
+	err = esp_ota_http_upgrade_begin(config, desc, upgrade_config, &handle);
+	if(err != ESP_OK)
+	{
+		return err;
+	}
+	while(esp_ota_http_upgrade_step(handle) == ESP_ERR_OTA_HTTP_IN_PROGRESS)
+	{
+	}
+	return esp_ota_http_upgrade_finish(handle);
+}
+
+/* a checkpoint of the whole image, the boot partition was never switched */
+static void test_end(host_server_handle_t server, const uint8_t *image, bool step)
+{
+	esp_http_client_config_t config;
+	esp_ota_http_upgrade_config_t upgrade_config;
+	esp_ota_nvs_checkpoint_t checkpoint;
+	host_server_stats_t before, after;
+	esp_ota_desc_t desc;
+	test_end_t end;
+	char url[64];
+	int i;
+
+	host_test_reset();
+	test_setup(server, "/end.bin", &config, url, &upgrade_config);
+	host_test_desc(&desc, image, TEST_END_IMAGE_SIZE);
+	memset(&end, 0, sizeof(end));
+	end.size = TEST_END_IMAGE_SIZE;
+	upgrade_config.callback = test_end_callback;
+	upgrade_config.callback_arg = &end;
+
+	HOST_TEST_CHECK_ERR(esp_ota_http_upgrade_ext(&config, &desc, &upgrade_config), ESP_OK);
+	HOST_TEST_CHECK(end.saved && end.checkpoint.offset == TEST_END_IMAGE_SIZE);
+	upgrade_config.callback = NULL;
+
+	/* power is lost before the image is activated, retries must not get stuck */
+	HOST_TEST_CHECK_ERR(esp_ota_nvs_checkpoint_set(&end.checkpoint), ESP_OK);
+	for(i = 0; i < 2; i++)
+	{
+		host_server_get_stats(server, &before);
+		HOST_TEST_CHECK_ERR(step ? test_step(&config, &desc, &upgrade_config) :
+			esp_ota_http_upgrade_ext(&config, &desc, &upgrade_config), ESP_OK);
+		host_server_get_stats(server, &after);
+
+		HOST_TEST_CHECK(after.range_requests == before.range_requests);
+		HOST_TEST_CHECK(after.bytes - before.bytes == TEST_END_IMAGE_SIZE);
+		HOST_TEST_CHECK(esp_ota_nvs_checkpoint_get(&checkpoint) != ESP_OK);
+	}
+	HOST_TEST_CHECK(!memcmp(host_flash_data(esp_ota_get_next_update_partition(NULL)), image, TEST_END_IMAGE_SIZE));
+	HOST_TEST_CHECK(host_ota_get_boot() == esp_ota_get_next_update_partition(NULL));
+}
+
+int main(void)
+{
+	host_server_config_t no_range;
+	host_server_handle_t server, no_range_server;
+	uint8_t *image;
+
+	image = host_test_image(TEST_IMAGE_SIZE, 3);
+	HOST_TEST_CHECK(host_server_start(NULL, &server) == ESP_OK);
+	host_server_add(server, "/image.bin", image, TEST_IMAGE_SIZE, NULL, NULL);
+	host_server_add(server, "/end.bin", image, TEST_END_IMAGE_SIZE, NULL, NULL);
+	memset(&no_range, 0, sizeof(no_range));
+	no_range.no_range = true;
+	HOST_TEST_CHECK(host_server_start(&no_range, &no_range_server) == ESP_OK);
+	host_server_add(no_range_server, "/image.bin", image, TEST_IMAGE_SIZE, NULL, NULL);
+
+	test_resume(server, image, true);
+	test_resume(no_range_server, image, false);
+	test_end(server, image, false);
+	test_end(server, image, true);
+
+	host_server_stop(no_range_server);
+	host_server_stop(server);
+	free(image);
+	return 0;
+}
+
+/*
+ * EOF
+ */
@@ -0,0 +1,159 @@
+/*****************************************************************************
+* File Name: test_step.c
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_partition.h"
+#include "esp_ota_ops.h"
+#include "esp_http_client.h"
+
+#include "esp_ota_port.h"
+#include "esp_ota_hash.h"
+#include "esp_ota_desc.h"
+#include "esp_ota_http.h"
+
+#include "esp_ota_host.h"
+#include "host_test.h"
+
+/*
+ * Step-driven upgrade: a plain image in bounded steps, compressed and delta
+ * descriptors are refused before anything is set up.
+ */
+
+#define TEST_IMAGE_SIZE		(100000)
+
+static void test_plain(host_server_handle_t server, const uint8_t *image)
+{
+	esp_http_client_config_t config;
+	esp_ota_http_upgrade_handle_t handle;
+	host_flash_stats_t stats;
+	esp_ota_desc_t desc;
+	unsigned int steps = 0;
+	char url[64];
+	esp_err_t err;
+
+	host_test_reset();
+	host_server_url(server, "/image.bin", url, sizeof(url));
+	host_test_config(&config, url);
+	host_test_desc(&desc, image, TEST_IMAGE_SIZE);
+
+	HOST_TEST_CHECK_ERR(esp_ota_http_upgrade_begin(&config, &desc, NULL, &handle), ESP_OK);
+	while((err = esp_ota_http_upgrade_step(handle)) == ESP_ERR_OTA_HTTP_IN_PROGRESS)
+	{
+		steps++;
+	}
+	HOST_TEST_CHECK_ERR(err, ESP_OK);
+	HOST_TEST_CHECK_ERR(esp_ota_http_upgrade_finish(handle), ESP_OK);
+	host_flash_get_stats(&stats);
+	printf("plain: %u steps, %u erases\n", steps, stats.erase_count);
+
+	/* one block per step, the partition is erased along the way */
+	HOST_TEST_CHECK(steps >= TEST_IMAGE_SIZE / 4096);
+	HOST_TEST_CHECK(stats.erase_count > 1);
+	HOST_TEST_CHECK(!memcmp(host_flash_data(esp_ota_get_next_update_partition(NULL)), image, TEST_IMAGE_SIZE));
+	HOST_TEST_CHECK(host_ota_get_boot() == esp_ota_get_next_update_partition(NULL));
+}
+
+/* a read could inflate or patch-copy without bound, the base would be hashed in begin */
+static void test_refused(host_server_handle_t server, const uint8_t *image)
+{
+	esp_http_client_config_t config;
+	esp_ota_http_upgrade_handle_t handle = NULL;
+	esp_ota_port_alloc_stats_t alloc;
+	host_flash_stats_t stats;
+	esp_ota_desc_t desc;
+	char url[64];
+
+	host_test_reset();
+	host_server_url(server, "/image.bin", url, sizeof(url));
+	host_test_config(&config, url);
+
+	host_test_desc(&desc, image, TEST_IMAGE_SIZE);
+	desc.base_size = TEST_IMAGE_SIZE;
+	HOST_TEST_CHECK_ERR(esp_ota_http_upgrade_begin(&config, &desc, NULL, &handle), ESP_ERR_NOT_SUPPORTED);
+
+	host_test_desc(&desc, image, TEST_IMAGE_SIZE);
+	desc.codec = ESP_OTA_DESC_CODEC_HEATSHRINK;
+	desc.zsize = TEST_IMAGE_SIZE / 2;
+	HOST_TEST_CHECK_ERR(esp_ota_http_upgrade_begin(&config, &desc, NULL, &handle), ESP_ERR_NOT_SUPPORTED);
+
+	host_flash_get_stats(&stats);
+	esp_ota_port_get_alloc_stats(&alloc);
+	HOST_TEST_CHECK(handle == NULL);
+	HOST_TEST_CHECK(stats.erase_count == 0);
+	HOST_TEST_CHECK(alloc.current == 0);
+}
+
+int main(void)
+{
+	host_server_handle_t server;
+	uint8_t *image;
+
+	image = host_test_image(TEST_IMAGE_SIZE, 6);
+	HOST_TEST_CHECK(host_server_start(NULL, &server) == ESP_OK);
+	host_server_add(server, "/image.bin", image, TEST_IMAGE_SIZE, NULL, NULL);
+
+	test_plain(server, image);
+	test_refused(server, image);
+
+	host_server_stop(server);
+	free(image);
+	return 0;
+}
+
+/*
+ * EOF
+ */
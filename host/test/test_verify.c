@@ -0,0 +1,160 @@
+/*****************************************************************************
+* File Name: test_verify.c
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+/*******************************************************************************
+* Included headers
+*******************************************************************************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_partition.h"
+#include "esp_ota_ops.h"
+#include "esp_http_client.h"
+
+#include "esp_ota_hash.h"
+#include "esp_ota_desc.h"
+#include "esp_ota_http.h"
+
+#include "esp_ota_host.h"
+#include "host_test.h"
+
+/*
+ * Per-block verification: a block that fails its hash is fetched again
+ * from its own offset. The retries are counted per block, so a run with
+ * more corrupted blocks than ESP_OTA_HTTP_BLOCK_RETRIES still completes,
+ * while a block that never arrives intact stops the upgrade.
+ */
+
+#define TEST_IMAGE_SIZE		(100 * 4096)
+#define TEST_BLOCK_SIZE		(4096)
+#define TEST_BAD_BLOCKS		(5)
+
+/* descriptor with the truncated SHA-256 of every block */
+static void test_desc(esp_ota_desc_t *desc, const uint8_t *image)
+{
+	uint8_t hash[32];
+	unsigned int i;
+
+	host_test_desc(desc, image, TEST_IMAGE_SIZE);
+	desc->block_size = TEST_BLOCK_SIZE;
+	desc->block_count = TEST_IMAGE_SIZE / TEST_BLOCK_SIZE;
+	desc->blocks = (uint8_t *)malloc(desc->block_count * ESP_OTA_DESC_BLOCK_HASH_SIZE);
+	HOST_TEST_CHECK(desc->blocks);
+	for(i = 0; i < desc->block_count; i++)
+	{
+		esp_ota_hash_sha256(NULL, &image[i * TEST_BLOCK_SIZE], TEST_BLOCK_SIZE, hash);
+		memcpy(&desc->blocks[i * ESP_OTA_DESC_BLOCK_HASH_SIZE], hash, ESP_OTA_DESC_BLOCK_HASH_SIZE);
+	}
+}
+
+static esp_err_t test_upgrade(host_server_handle_t server, const esp_ota_desc_t *desc, host_server_stats_t *stats)
+{
+	esp_http_client_config_t config;
+	host_server_stats_t before;
+	esp_err_t err;
+	char url[64];
+
+	host_test_reset();
+	host_server_url(server, "/image.bin", url, sizeof(url));
+	host_test_config(&config, url);
+	host_server_get_stats(server, &before);
+	err = esp_ota_http_upgrade_ext(&config, desc, NULL);
+	host_server_get_stats(server, stats);
+	stats->requests -= before.requests;
+	stats->range_requests -= before.range_requests;
+	return err;
+}
+
+int main(void)
+{
+	host_server_handle_t server;
+	host_server_stats_t stats;
+	esp_ota_desc_t desc;
+	uint8_t *image;
+	unsigned int i;
+
+	image = host_test_image(TEST_IMAGE_SIZE, 5);
+	test_desc(&desc, image);
+	HOST_TEST_CHECK(host_server_start(NULL, &server) == ESP_OK);
+	host_server_add(server, "/image.bin", image, TEST_IMAGE_SIZE, NULL, NULL);
+
+	/*
+	 * every response carries all the bad blocks ahead of it, the n-th bad
+	 * block is corrupted in n responses: each response fails at the next one
+	 */
+	for(i = 0; i < TEST_BAD_BLOCKS; i++)
+	{
+		host_server_corrupt(server, "/image.bin", (10 + i * 20) * TEST_BLOCK_SIZE + 100, i + 1);
+	}
+	HOST_TEST_CHECK_ERR(test_upgrade(server, &desc, &stats), ESP_OK);
+	printf("%u corrupted blocks: %u range requests\n", TEST_BAD_BLOCKS, stats.range_requests);
+	HOST_TEST_CHECK(stats.range_requests == TEST_BAD_BLOCKS + 1);
+	HOST_TEST_CHECK(!memcmp(host_flash_data(esp_ota_get_next_update_partition(NULL)), image, TEST_IMAGE_SIZE));
+	HOST_TEST_CHECK(host_ota_get_boot() == esp_ota_get_next_update_partition(NULL));
+
+	/* one block stays corrupted: the run and ESP_OTA_HTTP_BLOCK_RETRIES (3) retries of it */
+	host_server_corrupt(server, "/image.bin", 50 * TEST_BLOCK_SIZE, 100);
+	HOST_TEST_CHECK_ERR(test_upgrade(server, &desc, &stats), ESP_ERR_INVALID_CRC);
+	printf("a bad block: %u range requests\n", stats.range_requests);
+	HOST_TEST_CHECK(stats.range_requests == 1 + 3);
+	HOST_TEST_CHECK(host_ota_get_boot() == NULL);
+
+	host_server_stop(server);
+	free(desc.blocks);
+	free(image);
+	return 0;
+}
+
+/*
+ * EOF
+ */
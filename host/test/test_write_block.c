@@ -0,0 +1,136 @@
+/*****************************************************************************
+* File Name: test_write_block.c
+*
+* Version 1.00
+*
+* Description:
+*   This file contains the declarations of all the high-level APIs.
+*
+* Note:
+*   N/A
+*
+* Owner:
+*   vinhlq
+*
+* Related Document:
+*
+* Hardware Dependency:
+*   N/A
+*
+* Code Tested With:
+*
+******************************************************************************
+* Copyright (2019), vinhlq.
+******************************************************************************
+* This software is owned by vinhlq and is
+* protected by and subject to worldwide patent protection (United States and
+* foreign), United States copyright laws and international treaty provisions.
+* (vinhlq) hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the
+* (vinhlq) Source Code and derivative works for the sole purpose of creating
+* custom software in support of licensee product to be used only in conjunction
+* with a (vinhlq) integrated circuit as specified in the applicable agreement.
+* Any reproduction, modification, translation, compilation, or representation of
+* this software except as specified above is prohibited without the express
+* written permission of (vinhlq).
+*
+* Disclaimer: CYPRESS MAKES NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, WITH
+* REGARD TO THIS MATERIAL, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* (vinhlq) reserves the right to make changes without further notice to the
+* materials described herein. (vinhlq) does not assume any liability arising out
+* of the application or use of any product or circuit described herein. (vinhlq)
+* does not authorize its products for use as critical components in life-support
+* systems where a malfunction or failure may reasonably be expected to result in
+* significant injury to the user. The inclusion of (vinhlq)' product in a life-
+* support systems application implies that the manufacturer assumes all risk of
+* such use and in doing so indemnifies (vinhlq) against all charges. Use may be
+* limited by and subject to the applicable (vinhlq) software license agreement.
+*****************************************************************************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_partition.h"
+#include "esp_ota_ops.h"
+#include "esp_http_client.h"
+
+#include "esp_ota_hash.h"
+#include "esp_ota_desc.h"
+#include "esp_ota_http.h"
+
+#include "esp_ota_host.h"
+#include "host_test.h"
+
+/*
+ * Writes are coalesced into flash blocks: one esp_ota_write() per full
+ * block_size block and one for the tail, whatever the read sizes.
+ */
+
+#define TEST_IMAGE_SIZE		(100000)	/* not a multiple of any block size */
+
+static void test_callback(const esp_ota_http_progress_t *progress, void *arg)
+{
+	memcpy(arg, progress, sizeof(esp_ota_http_progress_t));
+}
+
+static void test_block(host_server_handle_t server, const uint8_t *image, unsigned int block_size, unsigned int pipeline_depth)
+{
+	esp_http_client_config_t config;
+	esp_ota_http_upgrade_config_t upgrade_config;
+	esp_ota_http_progress_t progress;
+	host_flash_stats_t stats;
+	esp_ota_desc_t desc;
+	unsigned int block = block_size ? block_size : 4096;
+	uint32_t writes = (TEST_IMAGE_SIZE + block - 1) / block;
+	char url[64];
+
+	host_test_reset();
+	host_server_url(server, "/image.bin", url, sizeof(url));
+	host_test_config(&config, url);
+	host_test_desc(&desc, image, TEST_IMAGE_SIZE);
+	memset(&upgrade_config, 0, sizeof(upgrade_config));
+	upgrade_config.block_size = block_size;
+	upgrade_config.pipeline_depth = pipeline_depth;
+	upgrade_config.callback = test_callback;
+	upgrade_config.callback_arg = &progress;
+
+	HOST_TEST_CHECK_ERR(esp_ota_http_upgrade_ext(&config, &desc, &upgrade_config), ESP_OK);
+	host_flash_get_stats(&stats);
+	printf("block %5u, pipeline %u: %u esp_ota_write calls, %u bytes per call\n",
+		block, pipeline_depth, stats.ota_write_count, stats.ota_write_bytes / stats.ota_write_count);
+
+	HOST_TEST_CHECK(stats.ota_write_count == writes);
+	HOST_TEST_CHECK(stats.ota_write_bytes == TEST_IMAGE_SIZE);
+	HOST_TEST_CHECK(stats.write_count == writes);
+	HOST_TEST_CHECK(progress.done && progress.write_count == writes && progress.block_size == block);
+	HOST_TEST_CHECK(!memcmp(host_flash_data(esp_ota_get_next_update_partition(NULL)), image, TEST_IMAGE_SIZE));
+	HOST_TEST_CHECK(host_ota_get_boot() == esp_ota_get_next_update_partition(NULL));
+}
+
+int main(void)
+{
+	static const unsigned int blocks[] = { 0, 256, 1024, 4096, 16384 };
+	host_server_handle_t server;
+	uint8_t *image;
+	unsigned int i;
+
+	image = host_test_image(TEST_IMAGE_SIZE, 1);
+	HOST_TEST_CHECK(host_server_start(NULL, &server) == ESP_OK);
+	host_server_add(server, "/image.bin", image, TEST_IMAGE_SIZE, NULL, NULL);
+
+	for(i = 0; i < sizeof(blocks) / sizeof(blocks[0]); i++)
+	{
+		test_block(server, image, blocks[i], 0);
+		test_block(server, image, blocks[i], 4);
+	}
+
+	host_server_stop(server);
+	free(image);
+	return 0;
+}
+
+/*
+ * EOF
+ */
@@ -0,0 +1,47 @@
+#!/usr/bin/env python3
+"""Flash write estimate of an image, with and without blank page skipping.
+
+    esp_ota_blank.py image.bin [--page-us 700]
+
+Direct writes (resume, erase-ahead, skip mode, mirrors) leave 256-byte
+pages of 0xFF erased instead of programming them. This prints the pages of
+the image, how many of them are blank and the page program time of both,
+using the typical page program time of the flash chip (--page-us, 0.7 ms
+for the common 25Q SPI NOR parts).
+"""
+
+import argparse
+import sys
+
+PAGE_SIZE = 256
+
+
+def blank_pages(image):
+    pages = (len(image) + PAGE_SIZE - 1) // PAGE_SIZE
+    blank = 0
+    for off in range(0, len(image), PAGE_SIZE):
+        page = image[off:off + PAGE_SIZE]
+        if page.count(0xff) == len(page):
+            blank += 1
+    return pages, blank
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("image", nargs="+")
+    parser.add_argument("--page-us", type=int, default=700)
+    args = parser.parse_args()
+
+    for name in args.image:
+        with open(name, "rb") as f:
+            image = f.read()
+        pages, blank = blank_pages(image)
+        before = pages * args.page_us / 1000
+        after = (pages - blank) * args.page_us / 1000
+        print("%s: %d pages, %d blank (%.1f%%), program %.0f ms -> %.0f ms" % (
+            name, pages, blank, 100.0 * blank / max(pages, 1), before, after))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""Descriptor generator for esp_ota_http_get_desc().
+
+    esp_ota_desc.py image.bin --version 1.2 [--blocks [--block-size 4096]] [--retry-after 21600]
+                    [--output NAME]
+
+Prints the JSON descriptor of an image, with --output it writes NAME.json
+and the binary descriptor NAME.otad (served as application/vnd.esp-ota.desc
+or by its extension, see esp_ota_desc.h for the layout). With --blocks the descriptor also
+lists the leading 8 bytes of the SHA-256 of every block, devices then copy
+the blocks they already have on the running partition and fetch only the
+others with HTTP Range requests (chunk sync). Every block is checked against
+its hash before it is written, "merkle_root" (SHA-256 of the concatenated
+block hashes) protects the list itself. --retry-after tells esp_ota_sched how
+many seconds devices wait before the next check.
+"""
+
+import argparse
+import hashlib
+import json
+import struct
+import sys
+import zlib
+
+BLOCK_HASH_SIZE = 8
+
+BIN_MAGIC = b"OTAD"
+BIN_VERSION = 1
+CODECS = {"none": 0, "heatshrink": 1, "lz4": 2, "deflate": 3}
+
+# key: (field type, struct format or None for raw bytes)
+BIN_FIELDS = {
+    "codec": (1, "<B"),
+    "zsize": (2, "<I"),
+    "zsha256": (3, None),
+    "window": (4, "<B"),
+    "lookahead": (5, "<B"),
+    "base_version": (6, "<H"),
+    "base_size": (7, "<I"),
+    "base_sha256": (8, None),
+    "block_size": (9, "<I"),
+    "blocks": (10, None),
+    "merkle_root": (11, None),
+    "retry_after": (12, "<I"),
+}
+
+
+def version(text):
+    major, minor = text.split(".")
+    return (int(major) << 8) | int(minor)
+
+
+def describe(image, image_version, blocks=False, block_size=4096, retry_after=0):
+    desc = {
+        "version": image_version,
+        "sha256": hashlib.sha256(image).hexdigest(),
+        "size": len(image),
+    }
+    if blocks:
+        desc["block_size"] = block_size
+        desc["blocks"] = [
+            hashlib.sha256(image[off:off + block_size]).digest()[:BLOCK_HASH_SIZE].hex()
+            for off in range(0, len(image), block_size)
+        ]
+        desc["merkle_root"] = hashlib.sha256(
+            b"".join(bytes.fromhex(h) for h in desc["blocks"])).hexdigest()
+    if retry_after:
+        desc["retry_after"] = retry_after
+    return desc
+
+
+def to_bin(desc):
+    fields = b""
+    for key, value in desc.items():
+        if key not in BIN_FIELDS:
+            continue
+        field_type, fmt = BIN_FIELDS[key]
+        if key == "codec":
+            value = CODECS[value]
+        if key == "blocks":
+            data = b"".join(bytes.fromhex(h) for h in value)
+        elif fmt:
+            data = struct.pack(fmt, value)
+        else:
+            data = bytes.fromhex(value)
+        fields += struct.pack("<BH", field_type, len(data)) + data
+    length = 48 + len(fields) + 4
+    if length > 0xffff:
+        raise ValueError("binary descriptor too long: %d bytes" % length)
+    data = BIN_MAGIC + struct.pack("<BBHHHI", BIN_VERSION, 0, length, desc["version"], 0, desc["size"])
+    data += bytes.fromhex(desc["sha256"]) + fields
+    return data + struct.pack("<I", zlib.crc32(data) & 0xffffffff)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("image")
+    parser.add_argument("--version", type=version, required=True)
+    parser.add_argument("--blocks", action="store_true")
+    parser.add_argument("--block-size", type=int, default=4096)
+    parser.add_argument("--retry-after", type=int, default=0)
+    parser.add_argument("--output", help="write NAME.json and NAME.otad")
+    args = parser.parse_args()
+
+    with open(args.image, "rb") as f:
+        image = f.read()
+    desc = describe(image, args.version, args.blocks, args.block_size, args.retry_after)
+    if not args.output:
+        print(json.dumps(desc))
+        return 0
+    with open(args.output + ".json", "w") as f:
+        f.write(json.dumps(desc))
+    with open(args.output + ".otad", "wb") as f:
+        f.write(to_bin(desc))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
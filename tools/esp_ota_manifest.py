@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+"""Manifest generator for esp_ota_http_upgrade_manifest().
+
+    esp_ota_manifest.py --version 5 app=:build/app.bin:1.2 www=spiffs:www.bin:0.3
+                        [--blocks [--block-size 4096]] [--url-base https://host/dir/]
+
+Every component is NAME=PARTITION:IMAGE:VERSION, PARTITION is the partition
+label, empty for the next OTA app partition (at most one). Devices fetch the
+image from the component "url": the image file name relative to the
+manifest, or --url-base followed by the file name. Each component carries a
+descriptor of its image (see esp_ota_desc.py); with --blocks a block that
+fails its hash is fetched again, for the data partitions as well (the
+manifest must stay below ESP_OTA_HTTP_MANIFEST_SIZE on the device). Prints the manifest JSON.
+"""
+
+import argparse
+import json
+import os
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+
+from esp_ota_desc import describe, version  # noqa: E402
+
+LABEL_LENGTH = 16
+COMPONENTS_MAX = 4
+
+
+def component(text):
+    name, _, rest = text.partition("=")
+    label, image, image_version = rest.split(":")
+    if not name or len(name) > LABEL_LENGTH or len(label) > LABEL_LENGTH:
+        raise argparse.ArgumentTypeError("name and partition label are up to %d characters" % LABEL_LENGTH)
+    return name, label, image, version(image_version)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("components", nargs="+", type=component, metavar="NAME=PARTITION:IMAGE:VERSION")
+    parser.add_argument("--version", type=int, required=True, help="of the whole set")
+    parser.add_argument("--blocks", action="store_true")
+    parser.add_argument("--block-size", type=int, default=4096)
+    parser.add_argument("--url-base", default="")
+    args = parser.parse_args()
+
+    if len(args.components) > COMPONENTS_MAX:
+        parser.error("at most %d components" % COMPONENTS_MAX)
+    if sum(1 for c in args.components if not c[1]) > 1:
+        parser.error("one app component")
+
+    components = []
+    for name, label, image_name, image_version in args.components:
+        with open(image_name, "rb") as f:
+            image = f.read()
+        entry = {
+            "name": name,
+            "partition": label,
+            "url": args.url_base + os.path.basename(image_name),
+        }
+        entry.update(describe(image, image_version, args.blocks, args.block_size))
+        components.append(entry)
+    print(json.dumps({"version": args.version, "components": components}))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
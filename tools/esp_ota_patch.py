@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+"""Patch generator for delta upgrades (esp_ota_patch.c).
+
+    esp_ota_patch.py diff base.bin new.bin patch.bin [--version 1.2] [--base-version 1.1]
+    esp_ota_patch.py apply base.bin patch.bin new.bin
+
+"diff" writes the patch, checks it with "apply" and prints the descriptor
+members for it. The patch format is:
+
+    "EOP1"
+    0x01, offset[4], length[4]   copy from the base image
+    0x02, length[4], data[]      literal data
+    0x00                         end
+
+All integers are little endian.
+"""
+
+import argparse
+import hashlib
+import json
+import struct
+import sys
+
+MAGIC = b"EOP1"
+OP_END = 0x00
+OP_COPY = 0x01
+OP_DATA = 0x02
+
+# base is indexed every STEP bytes, matches shorter than MIN_COPY go to data
+KEY = 16
+STEP = 4
+MIN_COPY = 24
+
+
+def diff(base, new):
+    index = {}
+    for off in range(0, len(base) - KEY + 1, STEP):
+        index.setdefault(base[off:off + KEY], off)
+
+    ops = []
+    literal = bytearray()
+    i = 0
+    # the copy that continues the previous one is tried first
+    hint = None
+
+    def flush():
+        if literal:
+            ops.append((OP_DATA, bytes(literal)))
+            literal.clear()
+
+    while i < len(new):
+        src = None
+        if hint is not None and hint < len(base) and new[i:i + KEY] == base[hint:hint + KEY]:
+            src = hint
+        else:
+            src = index.get(new[i:i + KEY])
+        if src is None:
+            literal.append(new[i])
+            i += 1
+            continue
+
+        # extend backwards into the pending literal data, then forwards
+        back = 0
+        while back < len(literal) and src - back > 0 and base[src - back - 1] == literal[-back - 1]:
+            back += 1
+        length = KEY
+        while i + length < len(new) and src + length < len(base) and new[i + length] == base[src + length]:
+            length += 1
+        if back + length < MIN_COPY:
+            literal.append(new[i])
+            i += 1
+            continue
+        if back:
+            del literal[-back:]
+        flush()
+        ops.append((OP_COPY, src - back, back + length))
+        i += length
+        hint = src + length
+    flush()
+    return ops
+
+
+def encode(ops):
+    out = bytearray(MAGIC)
+    for op in ops:
+        if op[0] == OP_COPY:
+            out += struct.pack("<BII", OP_COPY, op[1], op[2])
+        else:
+            out += struct.pack("<BI", OP_DATA, len(op[1])) + op[1]
+    out.append(OP_END)
+    return bytes(out)
+
+
+def apply(base, patch):
+    if patch[:4] != MAGIC:
+        raise ValueError("bad magic")
+    out = bytearray()
+    pos = 4
+    while True:
+        op = patch[pos]
+        pos += 1
+        if op == OP_END:
+            break
+        if op == OP_COPY:
+            offset, length = struct.unpack_from("<II", patch, pos)
+            pos += 8
+            if offset + length > len(base):
+                raise ValueError("copy out of base")
+            out += base[offset:offset + length]
+        elif op == OP_DATA:
+            (length,) = struct.unpack_from("<I", patch, pos)
+            pos += 4
+            out += patch[pos:pos + length]
+            pos += length
+        else:
+            raise ValueError("unknown op 0x%02x" % op)
+    if pos != len(patch):
+        raise ValueError("data after the end op")
+    return bytes(out)
+
+
+def version(text):
+    major, minor = text.split(".")
+    return (int(major) << 8) | int(minor)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+    d = sub.add_parser("diff")
+    d.add_argument("base")
+    d.add_argument("new")
+    d.add_argument("patch")
+    d.add_argument("--version", type=version, default=0)
+    d.add_argument("--base-version", type=version, default=0)
+    a = sub.add_parser("apply")
+    a.add_argument("base")
+    a.add_argument("patch")
+    a.add_argument("new")
+    args = parser.parse_args()
+
+    if args.command == "apply":
+        with open(args.base, "rb") as f:
+            base = f.read()
+        with open(args.patch, "rb") as f:
+            patch = f.read()
+        with open(args.new, "wb") as f:
+            f.write(apply(base, patch))
+        return 0
+
+    with open(args.base, "rb") as f:
+        base = f.read()
+    with open(args.new, "rb") as f:
+        new = f.read()
+    patch = encode(diff(base, new))
+    if apply(base, patch) != new:
+        print("round trip failed", file=sys.stderr)
+        return 1
+    with open(args.patch, "wb") as f:
+        f.write(patch)
+
+    desc = {
+        "version": args.version,
+        "sha256": hashlib.sha256(new).hexdigest(),
+        "size": len(new),
+        "base_version": args.base_version,
+        "base_size": len(base),
+        "base_sha256": hashlib.sha256(base).hexdigest(),
+        "zsize": len(patch),
+        "zsha256": hashlib.sha256(patch).hexdigest(),
+    }
+    print(json.dumps(desc, indent=4))
+    print("patch: %u bytes, image: %u bytes" % (len(patch), len(new)), file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
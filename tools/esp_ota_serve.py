@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+"""Local HTTPS image server for testing mirrors and Range downloads.
+
+    esp_ota_serve.py DIR --port 8443 --cert cert.pem --key key.pem [--rate 20000] [--fail 0.1]
+
+Serves the files of DIR with "Range: bytes=a-b" support (206 responses).
+--rate limits every response to that many bytes/s, --fail drops the
+connection in the middle of that fraction of responses. Start one instance
+per port with different settings to test esp_ota_http_upgrade_mirrors().
+"""
+
+import argparse
+import http.server
+import os
+import random
+import re
+import ssl
+import sys
+import time
+
+CHUNK_SIZE = 1024
+
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    root = "."
+    rate = 0
+    fail = 0.0
+
+    def do_GET(self):
+        path = os.path.join(self.root, os.path.basename(self.path.split("?")[0]))
+        if not os.path.isfile(path):
+            self.send_error(404)
+            return
+        with open(path, "rb") as f:
+            data = f.read()
+
+        start, end = 0, len(data)
+        match = re.match(r"bytes=(\d+)-(\d*)$", self.headers.get("Range", ""))
+        if match:
+            start = int(match.group(1))
+            end = min(int(match.group(2)) + 1, len(data)) if match.group(2) else len(data)
+            if start >= end:
+                self.send_error(416)
+                return
+            self.send_response(206)
+            self.send_header("Content-Range", "bytes %d-%d/%d" % (start, end - 1, len(data)))
+        else:
+            self.send_response(200)
+        self.send_header("Content-Length", str(end - start))
+        self.send_header("Accept-Ranges", "bytes")
+        self.end_headers()
+
+        stop = end
+        if random.random() < self.fail:
+            stop = start + (end - start) // 2
+        began = time.monotonic()
+        for offset in range(start, stop, CHUNK_SIZE):
+            self.wfile.write(data[offset:min(offset + CHUNK_SIZE, stop)])
+            if self.rate:
+                delay = (offset + CHUNK_SIZE - start) / self.rate - (time.monotonic() - began)
+                if delay > 0:
+                    time.sleep(delay)
+        if stop != end:
+            self.close_connection = True
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("root")
+    parser.add_argument("--port", type=int, default=8443)
+    parser.add_argument("--cert", required=True)
+    parser.add_argument("--key", required=True)
+    parser.add_argument("--rate", type=int, default=0, help="bytes/s per response, 0: unlimited")
+    parser.add_argument("--fail", type=float, default=0.0, help="fraction of responses cut in half")
+    args = parser.parse_args()
+
+    Handler.root = args.root
+    Handler.rate = args.rate
+    Handler.fail = args.fail
+    server = http.server.ThreadingHTTPServer(("", args.port), Handler)
+    context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+    context.load_cert_chain(args.cert, args.key)
+    server.socket = context.wrap_socket(server.socket, server_side=True)
+    server.serve_forever()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())